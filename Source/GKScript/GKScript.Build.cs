@@ -28,6 +28,8 @@ public class GKScript : ModuleRules
 
                 "BlueprintGraph",   // K2 Nodes
                 "UnrealEd",         // UBlueprintFactory
+                "KismetCompiler",   // FKismetCompilerUtilities, bytecode backend
+                "WorkspaceMenuStructure",   // Preview tab
 
                 // EnhancedInput
                 "EnhancedInput",
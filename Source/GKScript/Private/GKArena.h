@@ -0,0 +1,56 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Unreal Engine
+#include "CoreMinimal.h"
+#include "Misc/MemStack.h"
+#include "Misc/StringBuilder.h"
+
+
+// Array of strings living in the arena, most nodes have a handful of pins
+using FGKArenaStrings = TArray<FStringView, TInlineAllocator<8>>;
+
+
+/*! Linear arena for everything that lives as long as a graph of a transform
+ *
+ * Each arena owns its own FMemStackBase, nothing is shared with the thread local
+ * FMemStack, so arenas of transforms running on the same thread, or nested
+ * in a task that waits on another one, never interleave.
+ * Everything allocated is released at once when the arena is reset or destroyed.
+ *
+ * Strings copied into the arena are null terminated, ``View.GetData()``
+ * can be given to ``%s``.
+ *
+ * .. note::
+ *
+ *    An arena is not thread safe, forks of a transform use their own
+ */
+struct FGKArena {
+    FGKArena() = default;
+
+    // Release everything allocated so far, the pages go back to the page allocator
+    void Reset() {
+        Stack.Flush();
+    }
+
+    FStringView Copy(FStringView Str) {
+        TCHAR* Data = New<TCHAR>(Stack, Str.Len() + 1);
+        FMemory::Memcpy(Data, Str.GetData(), Str.Len() * sizeof(TCHAR));
+        Data[Str.Len()] = TEXT('\0');
+        return FStringView(Data, Str.Len());
+    }
+
+    template <typename FmtType, typename... Types>
+    FStringView Printf(const FmtType& Fmt, Types... Args) {
+        TStringBuilder<256> Builder;
+        Builder.Appendf(Fmt, Args...);
+        return Copy(Builder.ToView());
+    }
+
+    FGKArena(FGKArena const&) = delete;
+    FGKArena& operator= (FGKArena const&) = delete;
+
+private:
+    FMemStackBase Stack;
+};
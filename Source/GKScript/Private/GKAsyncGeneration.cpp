@@ -0,0 +1,283 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKAsyncGeneration.h"
+
+// Gamekit
+#include "GKBackgroundWrite.h"
+#include "GKFunctionCache.h"
+#include "GKScript.h"
+#include "GKScriptStats.h"
+
+// Unreal Engine
+#include "AssetRegistry/AssetData.h"
+#include "Engine/Blueprint.h"
+#include "Engine/StreamableManager.h"
+#include "Framework/Notifications/NotificationManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "Widgets/Notifications/SNotificationList.h"
+
+
+#define LOCTEXT_NAMESPACE "FGKScriptModule"
+
+namespace {
+
+// Spans the whole load in Insights, most of it happens on the async loading thread
+const TCHAR* GKLoadRegion = TEXT("GKScript Load Blueprints");
+
+FStreamableManager& GetStreamableManager() {
+    static FStreamableManager Manager;
+    return Manager;
+}
+
+} // namespace
+
+
+FGKAsyncGeneration::FGKAsyncGeneration(FString Destination):
+    Destination(MoveTemp(Destination))
+{}
+
+TSharedRef<FGKAsyncGeneration> FGKAsyncGeneration::Start(TArray<FAssetData> const& Assets, FString Destination) {
+    TSharedRef<FGKAsyncGeneration> Generation = MakeShareable(new FGKAsyncGeneration(MoveTemp(Destination)));
+
+    for (FAssetData const& AssetData : Assets) {
+        UClass* AssetClass = AssetData.GetClass();
+        if (AssetClass && AssetClass->IsChildOf(UBlueprint::StaticClass())) {
+            Generation->Paths.Add(AssetData.GetSoftObjectPath());
+        }
+    }
+
+    FNotificationInfo Info(LOCTEXT("GenerateLoading", "Loading Blueprints"));
+    Info.bFireAndForget = false;
+    Info.ExpireDuration = 3.f;
+    Info.ButtonDetails.Add(FNotificationButtonInfo(
+        LOCTEXT("GenerateCancel", "Cancel"),
+        LOCTEXT("GenerateCancelTooltip", "Stop generating code, Blueprints already generated are kept"),
+        FSimpleDelegate::CreateSP(Generation, &FGKAsyncGeneration::Cancel),
+        SNotificationItem::CS_Pending
+    ));
+
+    FGKFunctionCache::Get().TrimAsync();
+
+    Generation->Notification = FSlateNotificationManager::Get().AddNotification(Info);
+    if (Generation->Notification.IsValid()) {
+        Generation->Notification->SetCompletionState(SNotificationItem::CS_Pending);
+    }
+
+    // The ticker owns the generation until it is done
+    Generation->TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateLambda([Generation](float DeltaTime) {
+            return Generation->Tick(DeltaTime);
+        })
+    );
+
+    {
+        GKSCRIPT_SCOPE(STAT_GKScript_Load);
+        TRACE_BEGIN_REGION(GKLoadRegion);
+        Generation->LoadStartTime = FPlatformTime::Seconds();
+
+        Generation->Handle = GetStreamableManager().RequestAsyncLoad(
+            Generation->Paths,
+            FStreamableDelegate::CreateSP(Generation, &FGKAsyncGeneration::OnLoaded),
+            FStreamableManager::AsyncLoadHighPriority
+        );
+    }
+
+    // Nothing to load, the callback was not called
+    if (!Generation->bLoaded && !Generation->Handle.IsValid()) {
+        Generation->OnLoaded();
+    }
+    return Generation;
+}
+
+void FGKAsyncGeneration::Cancel() {
+    bCancelled = true;
+
+    if (Handle.IsValid() && Handle->IsLoadingInProgress()) {
+        Handle->CancelHandle();
+    }
+
+    if (Job.IsValid()) {
+        Job->Cancel();
+    }
+    Release();
+}
+
+void FGKAsyncGeneration::OnLoaded() {
+    GKSCRIPT_SCOPE(STAT_GKScript_Load);
+    TRACE_END_REGION(GKLoadRegion);
+    bLoaded = true;
+
+    if (bCancelled) {
+        return;
+    }
+
+    GKSCRIPT_VERBOSE(TEXT("Loaded %d Blueprints in %.2fs"), Paths.Num(), FPlatformTime::Seconds() - LoadStartTime);
+
+    // Already loaded assets call back before the handle is returned, resolve the paths instead
+    for (FSoftObjectPath const& Path : Paths) {
+        UBlueprint* Blueprint = Cast<UBlueprint>(Path.ResolveObject());
+        if (Blueprint && Blueprint->GeneratedClass) {
+            Blueprints.Add(Blueprint);
+        }
+    }
+
+    // The job is owned by the generation
+    Job = FGKTimeSlicedJob::Start([this](double EndTime) {
+        return Step(EndTime);
+    });
+}
+
+bool FGKAsyncGeneration::Step(double EndTime) {
+    while (!bCancelled) {
+        if (!Transform.IsValid() && !Next()) {
+            return true;
+        }
+
+        UBlueprint* Blueprint = Current.Get();
+        if (Blueprint == nullptr) {
+            GKSCRIPT_VERBOSE(TEXT("Blueprint deleted during generation, skipped"));
+            Release();
+            NumGenerated += 1;
+            continue;
+        }
+
+        // Edited or compiled between two slices, the nodes being traversed might be gone
+        if (bChanged) {
+            GKSCRIPT_VERBOSE(TEXT("%s: modified during generation, starting over"), *Blueprint->GetName());
+            Begin(Blueprint);
+        }
+
+        if (!Transform->GenerateSlice(EndTime)) {
+            return false;
+        }
+
+        FString FilePath = FPaths::Combine(FPaths::ProjectContentDir(), Destination, Blueprint->GetName() + TEXT(".us"));
+        Writes.Add(FGKBackgroundWrite::Get().Write(FilePath, MoveTemp(Output)));
+
+        Release();
+        NumGenerated += 1;
+
+        if (FPlatformTime::Seconds() >= EndTime) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FGKAsyncGeneration::Next() {
+    while (NextBlueprint < Blueprints.Num()) {
+        UBlueprint* Blueprint = Blueprints[NextBlueprint].Get();
+        NextBlueprint += 1;
+
+        if (Blueprint == nullptr || Blueprint->GeneratedClass == nullptr) {
+            NumGenerated += 1;
+            continue;
+        }
+
+        Current = Blueprint;
+        ChangedHandle = Blueprint->OnChanged().AddSP(AsShared(), &FGKAsyncGeneration::OnBlueprintChanged);
+        CompiledHandle = Blueprint->OnCompiled().AddSP(AsShared(), &FGKAsyncGeneration::OnBlueprintChanged);
+        Begin(Blueprint);
+        return true;
+    }
+    return false;
+}
+
+void FGKAsyncGeneration::Begin(UBlueprint* Blueprint) {
+    bChanged = false;
+    Output.Reset();
+
+    Transform = MakeUnique<FGKEdGraphTransform>(Blueprint, Output);
+    Transform->Writer.Write("import unreal\n");
+}
+
+void FGKAsyncGeneration::Release() {
+    if (UBlueprint* Blueprint = Current.Get()) {
+        Blueprint->OnChanged().Remove(ChangedHandle);
+        Blueprint->OnCompiled().Remove(CompiledHandle);
+    }
+
+    ChangedHandle.Reset();
+    CompiledHandle.Reset();
+    Current.Reset();
+    Transform.Reset();
+}
+
+void FGKAsyncGeneration::OnBlueprintChanged(UBlueprint* Blueprint) {
+    bChanged = true;
+}
+
+bool FGKAsyncGeneration::Tick(float DeltaTime) {
+    if (!bLoaded) {
+        // A cancelled load never calls back
+        if (bCancelled) {
+            TRACE_END_REGION(GKLoadRegion);
+            Finish();
+            return false;
+        }
+
+        if (Notification.IsValid() && Handle.IsValid()) {
+            int32 Percent = FMath::RoundToInt(Handle->GetProgress() * 100.f);
+            Notification->SetText(FText::Format(
+                LOCTEXT("GenerateLoadingProgress", "Loading {0} Blueprints ({1}%)"), Paths.Num(), Percent
+            ));
+        }
+        return true;
+    }
+
+    if (Job.IsValid() && !Job->IsDone()) {
+        if (Notification.IsValid()) {
+            Notification->SetText(FText::Format(
+                LOCTEXT("GenerateProgress", "Generating code {0}/{1}"), NumGenerated, Blueprints.Num()
+            ));
+        }
+        return true;
+    }
+
+    // Files still being written
+    for (UE::Tasks::TTask<bool> const& Write : Writes) {
+        if (!Write.IsCompleted()) {
+            return true;
+        }
+    }
+
+    Finish();
+    return false;
+}
+
+void FGKAsyncGeneration::Finish() {
+    int32 Written = 0;
+    for (UE::Tasks::TTask<bool>& Write : Writes) {
+        Written += Write.GetResult() ? 1 : 0;
+    }
+
+    GKSCRIPT_DISPLAY(TEXT("Generated %d/%d Blueprints%s"), Written, Paths.Num(), bCancelled ? TEXT(" (cancelled)") : TEXT(""));
+
+    if (Notification.IsValid()) {
+        if (bCancelled) {
+            Notification->SetText(LOCTEXT("GenerateCancelled", "Code generation cancelled"));
+            Notification->SetCompletionState(SNotificationItem::CS_Fail);
+        } else {
+            Notification->SetText(FText::Format(LOCTEXT("GenerateDone", "Generated code for {0} Blueprints"), Written));
+            Notification->SetCompletionState(SNotificationItem::CS_Success);
+        }
+        Notification->ExpireAndFadeout();
+    }
+
+    Release();
+    Job.Reset();
+    Writes.Reset();
+    Blueprints.Reset();
+
+    // Let the assets go
+    if (Handle.IsValid()) {
+        Handle->ReleaseHandle();
+        Handle.Reset();
+    }
+}
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,86 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Gamekit
+#include "GKEdGraphTransform.h"
+#include "GKTimeSlice.h"
+
+// Unreal Engine
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Tasks/Task.h"
+
+struct FAssetData;
+struct FStreamableHandle;
+class SNotificationItem;
+class UBlueprint;
+
+
+/*! Generate code for a Content Browser selection without blocking the editor
+ *
+ * The selection is loaded through a streamable manager, the Blueprints are then
+ * generated one after the other on the game thread, time sliced (``GKScript.TimeSliceMs``),
+ * and their files are written by background tasks.
+ * Progress is reported through a notification, its Cancel button stops the loading
+ * and skips the Blueprints that were not generated yet.
+ *
+ * .. note::
+ *
+ *    Only the writes leave the game thread, the Blueprints are read between frames
+ *    where they can be edited, compiled or collected. A Blueprint that changes while
+ *    it is generated is started over, one that is gone is skipped.
+ */
+class FGKAsyncGeneration: public TSharedFromThis<FGKAsyncGeneration>
+{
+    public:
+    static TSharedRef<FGKAsyncGeneration> Start(TArray<FAssetData> const& Assets, FString Destination);
+
+    void Cancel();
+
+    bool IsCancelled() const { return bCancelled; }
+
+    private:
+    FGKAsyncGeneration(FString Destination);
+
+    void OnLoaded();
+
+    // Time sliced, generate Blueprints until EndTime
+    bool Step(double EndTime);
+
+    // Start the transform of the next Blueprint, returns false once there are none left
+    bool Next();
+
+    // Start, or start over, the transform of a Blueprint
+    void Begin(UBlueprint* Blueprint);
+
+    // Stop following the current Blueprint
+    void Release();
+
+    void OnBlueprintChanged(UBlueprint* Blueprint);
+
+    // Game thread, update the notification and finish once every file is written
+    bool Tick(float DeltaTime);
+
+    void Finish();
+
+    FString                             Destination;
+    TArray<FSoftObjectPath>             Paths;
+    TSharedPtr<FStreamableHandle>       Handle;
+    double                              LoadStartTime = 0;
+    TSharedPtr<FGKTimeSlicedJob>        Job;
+    TSharedPtr<SNotificationItem>       Notification;
+    FTSTicker::FDelegateHandle          TickerHandle;
+    TArray<TWeakObjectPtr<UBlueprint>>  Blueprints;
+    int32                               NextBlueprint = 0;
+    TWeakObjectPtr<UBlueprint>          Current;
+    FDelegateHandle                     ChangedHandle;  // On Current
+    FDelegateHandle                     CompiledHandle;
+    bool                                bChanged = false;
+    TArray<ANSICHAR>                    Output;         // Written by Transform
+    TUniquePtr<FGKEdGraphTransform>     Transform;
+    TArray<UE::Tasks::TTask<bool>>      Writes;
+    int32                               NumGenerated = 0;   // Skipped ones included
+    bool                                bLoaded = false;
+    bool                                bCancelled = false;
+};
@@ -0,0 +1,54 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKBackgroundWrite.h"
+
+// Gamekit
+#include "GKScript.h"
+#include "GKScriptStats.h"
+
+// Unreal Engine
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+
+FGKBackgroundWrite& FGKBackgroundWrite::Get() {
+    static FGKBackgroundWrite BackgroundWrite;
+    return BackgroundWrite;
+}
+
+UE::Tasks::TTask<bool> FGKBackgroundWrite::Write(FString FilePath, TArray<ANSICHAR> Bytes) {
+    check(IsInGameThread());
+    FilePath = FPaths::ConvertRelativePathToFull(FilePath);
+
+    // Forget the writes that are done
+    for (auto It = LastWrites.CreateIterator(); It; ++It) {
+        if (It.Value().IsCompleted()) {
+            It.RemoveCurrent();
+        }
+    }
+
+    auto WriteFile = [FilePath, Bytes = MoveTemp(Bytes)]() {
+        GKSCRIPT_SCOPE(STAT_GKScript_Write);
+        IFileManager::Get().MakeDirectory(*FPaths::GetPath(FilePath), true);
+
+        TArrayView<const uint8> View(reinterpret_cast<const uint8*>(Bytes.GetData()), Bytes.Num());
+        if (!FFileHelper::SaveArrayToFile(View, *FilePath)) {
+            GKSCRIPT_WARNING(TEXT("Could not write %s"), *FilePath);
+            return false;
+        }
+        GKSCRIPT_VERBOSE(TEXT(" - %s"), *FilePath);
+        return true;
+    };
+
+    UE::Tasks::TTask<bool> Task;
+    if (UE::Tasks::TTask<bool> const* Previous = LastWrites.Find(FilePath)) {
+        Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(WriteFile), UE::Tasks::Prerequisites(*Previous));
+    } else {
+        Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(WriteFile));
+    }
+
+    LastWrites.Add(FilePath, Task);
+    return Task;
+}
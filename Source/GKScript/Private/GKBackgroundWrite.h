@@ -0,0 +1,25 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Unreal Engine
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+
+
+/*! Write generated files from background tasks
+ *
+ * A write waits for the previous write of the same path, the last one queued
+ * is the one left on disk. Writes are queued from the game thread.
+ */
+class FGKBackgroundWrite
+{
+    public:
+    static FGKBackgroundWrite& Get();
+
+    // The task result is true when the file was written
+    UE::Tasks::TTask<bool> Write(FString FilePath, TArray<ANSICHAR> Bytes);
+
+    private:
+    TMap<FString, UE::Tasks::TTask<bool>> LastWrites;    // By full path
+};
@@ -8,25 +8,19 @@
 #include "GKEdGraphTransform.h"
 #include "GKEdGraphDebug.h"
 #include "GKEdGraphUtils.h"
+#include "GKBytecodeTransform.h"
 
 // UnrealEngine
 #include "Engine/Blueprint.h"
 #include "Engine/BlueprintGeneratedClass.h" 
-#include "Engine/SimpleConstructionScript.h"
 
 
-void GeneratePythonFromBlueprint(class UBlueprintGeneratedClass* Source);
-void GeneratePythonFromBlueprint(class USimpleConstructionScript* Source);
-
 void GeneratePythonFromBlueprint(class UBlueprint* Source, FString Destination) {
     FGKEdGraphTransform Transformer(Source, Destination, Source->GetName());
     Transformer.Generate();
 }
 
-void GeneratePythonFromBlueprint(class UBlueprintGeneratedClass* Source) {
-    GeneratePythonFromBlueprint(Source->SimpleConstructionScript);
-}
-
-void GeneratePythonFromBlueprint(class USimpleConstructionScript* Source) {
-    Source->GetRootNodes();
+void GeneratePythonFromBlueprint(class UBlueprintGeneratedClass* Source, FString Destination) {
+    FGKBytecodeTransform Transformer(Source, Destination, Source->GetName().LeftChop(2));
+    Transformer.Generate();
 }
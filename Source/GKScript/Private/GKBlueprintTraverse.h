@@ -2,5 +2,15 @@
 
 #pragma once
 
+// Gamekit
+#include "GKEdGraphTransform.h"
+
+// Unreal Engine
+#include "CoreMinimal.h"
+
+
 void GeneratePythonFromBlueprint(class UBlueprint* Source, FString Destination);
+
+// Decompile the class bytecode, the editor graphs are not needed
+void GeneratePythonFromBlueprint(class UBlueprintGeneratedClass* Source, FString Destination);
  
\ No newline at end of file
@@ -0,0 +1,541 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKBytecodeTransform.h"
+
+// Gamekit
+#include "GKScript.h"
+#include "GKClassDefaults.h"
+#include "GKEdGraphTypes.h"
+#include "GKScriptStats.h"
+
+// Unreal Engine
+#include "EdGraphSchema_K2.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "UObject/TextProperty.h"
+
+
+#define WRITELINE(fmt, ...) Writer.Printf(TEXT("%s" fmt "\n"), *Indentation(), __VA_ARGS__)
+
+namespace {
+
+// Same names as the graph transform
+FString GetPropertyType(FProperty* Property) {
+    FEdGraphPinType PinType;
+    if (!GetDefault<UEdGraphSchema_K2>()->ConvertPropertyToPinType(Property, PinType)) {
+        return Property->GetCPPType();
+    }
+    return FGKPinTypeNames::Get().GetName(PinType);
+}
+
+FString GetFieldName(FField* Field) {
+    return Field ? Field->GetName() : TEXT("None");
+}
+
+FString GetObjectName(UObject* Object) {
+    return Object ? Object->GetName() : TEXT("None");
+}
+
+FString Quote(FString const& Value) {
+    return TEXT("\"") + Value.ReplaceCharWithEscapedChar() + TEXT("\"");
+}
+
+} // namespace
+
+
+FGKBytecodeTransform::FGKBytecodeTransform(UBlueprintGeneratedClass* Source, FString Folder, FString ScriptName):
+    Source(Source)
+{
+    Writer.OpenFile(Folder, ScriptName);
+    WRITELINE("import unreal");
+}
+
+FString FGKBytecodeTransform::Indentation() const {
+    return FString::ChrN(IndentationLevel * 2, ' ');
+}
+
+void FGKBytecodeTransform::Generate() {
+    UObject* Defaults = Source->GetDefaultObject();
+
+    WRITELINE("class %s(%s):", *Source->GetName().LeftChop(2), *GetObjectName(Source->GetSuperClass()));
+    IndentationLevel += 1;
+
+    for (TFieldIterator<FProperty> It(Source, EFieldIteratorFlags::ExcludeSuper); It; ++It) {
+        FProperty* Property = *It;
+
+        // Frame of the event graph, not a variable
+        if (Property == Source->UberGraphFramePointerProperty) {
+            continue;
+        }
+
+        // Only values that differ from the type default are written
+        if (FGKClassDefaults::IsDefault(Property, Defaults)) {
+            WRITELINE("%s: %s", *Property->GetName(), *GetPropertyType(Property));
+            continue;
+        }
+
+        WRITELINE("%s: %s = DefaultSubObject(%s)",
+            *Property->GetName(),
+            *GetPropertyType(Property),
+            *FGKClassDefaults::Export(Property, Defaults)
+        );
+    }
+
+    // Inherited values the class overrides
+    TArray<FGKPropertyDelta> Deltas;
+    FGKClassDefaults::Get().Diff(Defaults, Defaults->GetArchetype(), Deltas);
+
+    for (FGKPropertyDelta const& Delta : Deltas) {
+        WRITELINE("%s = %s", *Delta.Property->GetName(), *Delta.Value);
+    }
+
+    // Native components, against the same component of the parent defaults
+    TArray<FGKSubobjectDelta> Subobjects;
+    FGKClassDefaults::Get().DiffSubobjects(Defaults, Defaults->GetArchetype(), Subobjects);
+
+    for (FGKSubobjectDelta const& Subobject : Subobjects) {
+        for (FGKPropertyDelta const& Delta : Subobject.Deltas) {
+            WRITELINE("%s.%s = %s", *Subobject.Path, *Delta.Property->GetName(), *Delta.Value);
+        }
+    }
+    WRITELINE("");
+
+    for (TFieldIterator<UFunction> It(Source, EFieldIteratorFlags::ExcludeSuper); It; ++It) {
+        GenerateFunction(*It);
+    }
+
+    IndentationLevel -= 1;
+    Writer.Close();
+}
+
+void FGKBytecodeTransform::GenerateFunction(UFunction* Function) {
+    GKSCRIPT_SCOPE(STAT_GKScript_Decompile);
+    TArray<FString> Args;
+    for (TFieldIterator<FProperty> It(Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It) {
+        if (It->HasAnyPropertyFlags(CPF_ReturnParm | CPF_OutParm) && !It->HasAnyPropertyFlags(CPF_ReferenceParm)) {
+            continue;
+        }
+        Args.Add(FString::Printf(TEXT("%s: %s"), *It->GetName(), *GetPropertyType(*It)));
+    }
+
+    WRITELINE("def %s(%s):", *Function->GetName(), *FString::Join(Args, TEXT(", ")));
+    IndentationLevel += 1;
+
+    // Decode everything first, jumps can go backward
+    struct FStatement {
+        int32   Offset;
+        FString Code;
+    };
+    TArray<FStatement> Statements;
+
+    Script = &Function->Script;
+    Offset = 0;
+    bError = false;
+    Targets.Reset();
+
+    while (Offset < Script->Num() && !bError) {
+        int32 Start = Offset;
+        if (Match(EX_EndOfScript)) {
+            break;
+        }
+        FString Code = Expr();
+        Statements.Add({Start, MoveTemp(Code)});
+    }
+
+    bool bEmpty = true;
+    for (FStatement const& Statement : Statements) {
+        if (Targets.Contains(CodeSkipSizeType(Statement.Offset))) {
+            WRITELINE("# %s", *Label(Statement.Offset));
+        }
+        if (!Statement.Code.IsEmpty()) {
+            WRITELINE("%s", *Statement.Code);
+            bEmpty = false;
+        }
+    }
+
+    if (bError) {
+        GKSCRIPT_WARNING(TEXT("%s: could not decode the bytecode at %d"), *Function->GetPathName(), Offset);
+    }
+    if (bEmpty) {
+        WRITELINE("pass");
+    }
+
+    IndentationLevel -= 1;
+    WRITELINE("");
+    Script = nullptr;
+}
+
+bool FGKBytecodeTransform::Match(EExprToken Token) {
+    if (Offset < Script->Num() && (*Script)[Offset] == Token) {
+        Offset += 1;
+        return true;
+    }
+    return false;
+}
+
+FString FGKBytecodeTransform::Label(CodeSkipSizeType Target) {
+    return FString::Printf(TEXT("label_%04x"), Target);
+}
+
+FString FGKBytecodeTransform::ReadName() {
+    return ScriptNameToName(Read<FScriptName>()).ToString();
+}
+
+FString FGKBytecodeTransform::ReadString() {
+    FString Value;
+    while (!bError) {
+        ANSICHAR Char = Read<ANSICHAR>();
+        if (Char == '\0') {
+            break;
+        }
+        Value.AppendChar(TCHAR(Char));
+    }
+    return Value;
+}
+
+FString FGKBytecodeTransform::ReadUnicodeString() {
+    TArray<UTF16CHAR> Chars;
+    while (!bError) {
+        UTF16CHAR Char = Read<UTF16CHAR>();
+        if (Char == 0) {
+            break;
+        }
+        Chars.Add(Char);
+    }
+    return FString(Chars.Num(), StringCast<TCHAR>(Chars.GetData(), Chars.Num()).Get());
+}
+
+FString FGKBytecodeTransform::List(EExprToken End) {
+    TArray<FString> Items;
+    while (!bError && !Match(End)) {
+        Items.Add(Expr());
+    }
+    return FString::Join(Items, TEXT(", "));
+}
+
+FString FGKBytecodeTransform::Call(UFunction* Function, FString const& Name) {
+    // Arguments are written in the order of the parameters
+    TArray<FString> Args;
+    TFieldIterator<FProperty> Param(Function);
+
+    while (!bError && !Match(EX_EndFunctionParms)) {
+        FString Value = Expr();
+
+        while (Param && Param->HasAnyPropertyFlags(CPF_ReturnParm)) {
+            ++Param;
+        }
+
+        if (Param && Param->HasAnyPropertyFlags(CPF_Parm)) {
+            Args.Add(FString::Printf(TEXT("%s = %s"), *Param->GetName(), *Value));
+            ++Param;
+        } else {
+            Args.Add(Value);
+        }
+    }
+    return FString::Printf(TEXT("%s(%s)"), *Name, *FString::Join(Args, TEXT(", ")));
+}
+
+FString FGKBytecodeTransform::Expr() {
+    if (bError) {
+        return FString();
+    }
+
+    int32 Start = Offset;
+    uint8 Token = Read<uint8>();
+
+    switch (Token) {
+    // Variables
+    case EX_LocalVariable:
+    case EX_InstanceVariable:
+    case EX_DefaultVariable:
+    case EX_LocalOutVariable:
+    case EX_ClassSparseDataVariable:
+        return GetFieldName(ReadPointer<FField>());
+
+    case EX_PropertyConst:
+        return GetFieldName(ReadPointer<FField>());
+
+    // Assignments
+    case EX_Let: {
+        ReadPointer<FProperty>();
+        FString Variable = Expr();
+        FString Value = Expr();
+        return FString::Printf(TEXT("%s = %s"), *Variable, *Value);
+    }
+    case EX_LetBool:
+    case EX_LetObj:
+    case EX_LetWeakObjPtr:
+    case EX_LetDelegate:
+    case EX_LetMulticastDelegate: {
+        FString Variable = Expr();
+        FString Value = Expr();
+        return FString::Printf(TEXT("%s = %s"), *Variable, *Value);
+    }
+    case EX_LetValueOnPersistentFrame: {
+        FString Variable = GetFieldName(ReadPointer<FField>());
+        FString Value = Expr();
+        return FString::Printf(TEXT("%s = %s"), *Variable, *Value);
+    }
+
+    // Context
+    case EX_Context:
+    case EX_Context_FailSilent:
+    case EX_ClassContext: {
+        FString Object = Expr();
+        Read<CodeSkipSizeType>();
+        ReadPointer<FField>();
+        FString Member = Expr();
+        return FString::Printf(TEXT("%s.%s"), *Object, *Member);
+    }
+    case EX_StructMemberContext: {
+        FString Member = GetFieldName(ReadPointer<FField>());
+        FString Struct = Expr();
+        return FString::Printf(TEXT("%s.%s"), *Struct, *Member);
+    }
+    case EX_InterfaceContext:
+        return Expr();
+
+    // Calls
+    case EX_FinalFunction:
+    case EX_LocalFinalFunction:
+    case EX_CallMath: {
+        UFunction* Function = ReadPointer<UFunction>();
+        return Call(Function, GetObjectName(Function));
+    }
+    case EX_VirtualFunction:
+    case EX_LocalVirtualFunction: {
+        FString Name = ReadName();
+        UFunction* Function = Source->FindFunctionByName(FName(*Name));
+        return Call(Function, Name);
+    }
+    case EX_CallMulticastDelegate: {
+        UFunction* Signature = ReadPointer<UFunction>();
+        FString Delegate = Expr();
+        return Call(Signature, Delegate + TEXT(".Broadcast"));
+    }
+
+    // Flow
+    case EX_Return: {
+        FString Value = Expr();
+        return Value.IsEmpty() ? FString(TEXT("return")) : TEXT("return ") + Value;
+    }
+    case EX_Jump: {
+        CodeSkipSizeType Target = Read<CodeSkipSizeType>();
+        Targets.Add(Target);
+        return FString::Printf(TEXT("goto(%s)"), *Label(Target));
+    }
+    case EX_JumpIfNot: {
+        CodeSkipSizeType Target = Read<CodeSkipSizeType>();
+        Targets.Add(Target);
+        FString Condition = Expr();
+        return FString::Printf(TEXT("if not %s: goto(%s)"), *Condition, *Label(Target));
+    }
+    case EX_ComputedJump:
+        return FString::Printf(TEXT("goto(%s)"), *Expr());
+    case EX_PushExecutionFlow: {
+        CodeSkipSizeType Target = Read<CodeSkipSizeType>();
+        Targets.Add(Target);
+        return FString::Printf(TEXT("push_flow(%s)"), *Label(Target));
+    }
+    case EX_PopExecutionFlow:
+        return TEXT("pop_flow()");
+    case EX_PopExecutionFlowIfNot:
+        return FString::Printf(TEXT("if not %s: pop_flow()"), *Expr());
+    case EX_Assert: {
+        Read<uint16>();
+        Read<uint8>();
+        return FString::Printf(TEXT("assert %s"), *Expr());
+    }
+
+    // Debugging, not code
+    case EX_Nothing:
+    case EX_Tracepoint:
+    case EX_WireTracepoint:
+    case EX_Breakpoint:
+    case EX_EndOfScript:
+        return FString();
+    case EX_InstrumentationEvent: {
+        uint8 EventType = Read<uint8>();
+        if (EventType == EScriptInstrumentation::InlineEvent) {
+            ReadName();
+        }
+        return FString();
+    }
+
+    // Constants
+    case EX_IntConst:
+        return FString::FromInt(Read<int32>());
+    case EX_Int64Const:
+        return LexToString(Read<int64>());
+    case EX_UInt64Const:
+        return LexToString(Read<uint64>());
+    case EX_SkipOffsetConst:
+        return LexToString(Read<CodeSkipSizeType>());
+    case EX_ByteConst:
+    case EX_IntConstByte:
+        return FString::FromInt(Read<uint8>());
+    case EX_IntZero:
+        return TEXT("0");
+    case EX_IntOne:
+        return TEXT("1");
+    case EX_FloatConst:
+        return FString::SanitizeFloat(Read<float>());
+    case EX_DoubleConst:
+        return FString::SanitizeFloat(Read<double>());
+    case EX_True:
+        return TEXT("True");
+    case EX_False:
+        return TEXT("False");
+    case EX_NoObject:
+    case EX_NoInterface:
+        return TEXT("None");
+    case EX_Self:
+        return TEXT("self");
+    case EX_StringConst:
+        return Quote(ReadString());
+    case EX_UnicodeStringConst:
+        return Quote(ReadUnicodeString());
+    case EX_NameConst:
+        return Quote(ReadName());
+    case EX_ObjectConst:
+        return GetObjectName(ReadPointer<UObject>());
+    case EX_SoftObjectConst:
+    case EX_FieldPathConst:
+        return Expr();
+    case EX_VectorConst: {
+        double X = Read<double>(), Y = Read<double>(), Z = Read<double>();
+        return FString::Printf(TEXT("(%s, %s, %s)"), *FString::SanitizeFloat(X), *FString::SanitizeFloat(Y), *FString::SanitizeFloat(Z));
+    }
+    case EX_RotationConst: {
+        double Pitch = Read<double>(), Yaw = Read<double>(), Roll = Read<double>();
+        return FString::Printf(TEXT("(%s, %s, %s)"), *FString::SanitizeFloat(Pitch), *FString::SanitizeFloat(Yaw), *FString::SanitizeFloat(Roll));
+    }
+    case EX_TransformConst: {
+        TArray<FString> Values;
+        for (int32 i = 0; i < 10; i++) {
+            Values.Add(FString::SanitizeFloat(Read<double>()));
+        }
+        return FString::Printf(TEXT("Transform(%s)"), *FString::Join(Values, TEXT(", ")));
+    }
+    case EX_TextConst: {
+        switch (Read<uint8>()) {
+        case uint8(EBlueprintTextLiteralType::Empty):
+            return TEXT("Text(\"\")");
+        case uint8(EBlueprintTextLiteralType::LocalizedText): {
+            FString Value = Expr();
+            Expr();
+            Expr();
+            return FString::Printf(TEXT("Text(%s)"), *Value);
+        }
+        case uint8(EBlueprintTextLiteralType::InvariantText):
+        case uint8(EBlueprintTextLiteralType::LiteralString):
+            return FString::Printf(TEXT("Text(%s)"), *Expr());
+        case uint8(EBlueprintTextLiteralType::StringTableEntry): {
+            ReadPointer<UObject>();
+            FString Table = Expr();
+            FString Key = Expr();
+            return FString::Printf(TEXT("Text(%s, %s)"), *Table, *Key);
+        }
+        }
+        break;
+    }
+
+    // Casts
+    case EX_PrimitiveCast:
+        Read<uint8>();
+        return Expr();
+    case EX_DynamicCast:
+    case EX_MetaCast:
+    case EX_ObjToInterfaceCast:
+    case EX_CrossInterfaceCast:
+    case EX_InterfaceToObjCast: {
+        UClass* Class = ReadPointer<UClass>();
+        FString Value = Expr();
+        return FString::Printf(TEXT("Cast(%s, %s)"), *Value, *GetObjectName(Class));
+    }
+
+    // Containers
+    case EX_SetArray: {
+        FString Variable = Expr();
+        return FString::Printf(TEXT("%s = [%s]"), *Variable, *List(EX_EndArray));
+    }
+    case EX_SetSet: {
+        FString Variable = Expr();
+        Read<int32>();
+        return FString::Printf(TEXT("%s = set([%s])"), *Variable, *List(EX_EndSet));
+    }
+    case EX_SetMap: {
+        FString Variable = Expr();
+        Read<int32>();
+        return FString::Printf(TEXT("%s = dict([%s])"), *Variable, *List(EX_EndMap));
+    }
+    case EX_ArrayConst:
+        ReadPointer<FField>();
+        Read<int32>();
+        return FString::Printf(TEXT("[%s]"), *List(EX_EndArrayConst));
+    case EX_SetConst:
+        ReadPointer<FField>();
+        Read<int32>();
+        return FString::Printf(TEXT("set([%s])"), *List(EX_EndSetConst));
+    case EX_MapConst:
+        ReadPointer<FField>();
+        ReadPointer<FField>();
+        Read<int32>();
+        return FString::Printf(TEXT("dict([%s])"), *List(EX_EndMapConst));
+    case EX_StructConst: {
+        UScriptStruct* Struct = ReadPointer<UScriptStruct>();
+        Read<int32>();
+        return FString::Printf(TEXT("%s(%s)"), *GetObjectName(Struct), *List(EX_EndStructConst));
+    }
+    case EX_ArrayGetByRef: {
+        FString Array = Expr();
+        FString Index = Expr();
+        return FString::Printf(TEXT("%s[%s]"), *Array, *Index);
+    }
+
+    // Delegates
+    case EX_InstanceDelegate:
+        return ReadName();
+    case EX_BindDelegate: {
+        FString Name = ReadName();
+        FString Delegate = Expr();
+        FString Object = Expr();
+        return FString::Printf(TEXT("%s = %s.%s"), *Delegate, *Object, *Name);
+    }
+    case EX_AddMulticastDelegate: {
+        FString Delegate = Expr();
+        return FString::Printf(TEXT("%s += %s"), *Delegate, *Expr());
+    }
+    case EX_RemoveMulticastDelegate: {
+        FString Delegate = Expr();
+        return FString::Printf(TEXT("%s -= %s"), *Delegate, *Expr());
+    }
+    case EX_ClearMulticastDelegate:
+        return FString::Printf(TEXT("%s.Clear()"), *Expr());
+
+    case EX_SwitchValue: {
+        uint16 NumCases = Read<uint16>();
+        Read<CodeSkipSizeType>();
+        FString Index = Expr();
+
+        TArray<FString> Cases;
+        for (uint16 i = 0; i < NumCases && !bError; i++) {
+            FString Case = Expr();
+            Read<CodeSkipSizeType>();
+            FString Result = Expr();
+            Cases.Add(FString::Printf(TEXT("%s: %s"), *Case, *Result));
+        }
+        FString Default = Expr();
+        return FString::Printf(TEXT("switch(%s, {%s}, %s)"), *Index, *FString::Join(Cases, TEXT(", ")), *Default);
+    }
+
+    default:
+        break;
+    }
+
+    bError = true;
+    Offset = Start;
+    return FString::Printf(TEXT("Unsupported(0x%02x)"), Token);
+}
+
+#undef WRITELINE
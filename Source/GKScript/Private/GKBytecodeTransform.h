@@ -0,0 +1,77 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+#pragma once
+
+// Gamekit
+#include "GKEdGraphTransform.h"
+
+// Unreal Engine
+#include "UObject/Script.h"
+
+class UBlueprintGeneratedClass;
+
+
+/*! Turn the compiled bytecode of a Blueprint class into code
+ *
+ * Only the generated class is read: its properties, its functions and their ``Script``,
+ * the editor graphs are never loaded so it works on cooked content too.
+ *
+ * Each function is decoded as a flat list of statements, the Kismet compiler
+ * already flattened the graph, branches and sequences are jumps.
+ * Jump targets are labelled, jumps are written as ``goto(label_0012)``.
+ *
+ * .. note::
+ *
+ *    Bytecode that cannot be decoded stops the function with an ``Unsupported`` statement
+ */
+struct FGKBytecodeTransform {
+    FGKBytecodeTransform(UBlueprintGeneratedClass* Source, FString Folder, FString ScriptName);
+
+    void Generate();
+
+    void GenerateFunction(UFunction* Function);
+
+    FString Indentation() const;
+
+    // Decoding
+    // --------
+    FString Expr();
+
+    FString Call(UFunction* Function, FString const& Name);
+
+    FString List(EExprToken End);
+
+    bool Match(EExprToken Token);
+
+    FString Label(CodeSkipSizeType Target);
+
+    template <typename T>
+    T Read() {
+        T Value;
+        if (Offset + int32(sizeof(T)) > Script->Num()) {
+            bError = true;
+            FMemory::Memzero(Value);
+            return Value;
+        }
+        FMemory::Memcpy(&Value, Script->GetData() + Offset, sizeof(T));
+        Offset += sizeof(T);
+        return Value;
+    }
+
+    // Objects and properties are stored as raw pointers once the script is loaded
+    template <typename T>
+    T* ReadPointer() {
+        return reinterpret_cast<T*>(UPTRINT(Read<ScriptPointerType>()));
+    }
+
+    FString ReadName();
+    FString ReadString();
+    FString ReadUnicodeString();
+
+    UBlueprintGeneratedClass*   Source = nullptr;
+    FGKCodeWriter               Writer;
+    TArray<uint8> const*        Script = nullptr;   // Bytecode of the function being decoded
+    int32                       Offset = 0;
+    bool                        bError = false;
+    TSet<CodeSkipSizeType>      Targets;            // Jump targets of the function
+    int                         IndentationLevel = 0;
+};
@@ -0,0 +1,160 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKClassDefaults.h"
+
+// Unreal Engine
+#include "Editor.h"
+#include "Misc/CoreDelegates.h"
+#include "UObject/UObjectGlobals.h"
+#include "UObject/UnrealType.h"
+
+
+FGKClassDefaults& FGKClassDefaults::Get() {
+    static FGKClassDefaults Defaults;
+    return Defaults;
+}
+
+void FGKClassDefaults::Reset() {
+    FWriteScopeLock WriteLock(Lock);
+    Properties.Reset();
+}
+
+void FGKClassDefaults::Register() {
+    ReinstancedHandle = FCoreUObjectDelegates::OnObjectsReinstanced.AddRaw(this, &FGKClassDefaults::OnObjectsReinstanced);
+
+    // Blueprint compiles regenerate the properties of the class in place
+    if (GEditor != nullptr) {
+        CompiledHandle = GEditor->OnBlueprintCompiled().AddRaw(this, &FGKClassDefaults::Reset);
+        return;
+    }
+
+    // The editor does not exist yet when the module starts with it
+    PostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddLambda([this]() {
+        if (GEditor != nullptr) {
+            CompiledHandle = GEditor->OnBlueprintCompiled().AddRaw(this, &FGKClassDefaults::Reset);
+        }
+    });
+}
+
+void FGKClassDefaults::Unregister() {
+    FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
+    FCoreUObjectDelegates::OnObjectsReinstanced.Remove(ReinstancedHandle);
+
+    if (GEditor != nullptr) {
+        GEditor->OnBlueprintCompiled().Remove(CompiledHandle);
+    }
+
+    PostEngineInitHandle.Reset();
+    ReinstancedHandle.Reset();
+    CompiledHandle.Reset();
+    Reset();
+}
+
+void FGKClassDefaults::OnObjectsReinstanced(TMap<UObject*, UObject*> const& OldToNew) {
+    Reset();
+}
+
+TArray<FProperty*> const& FGKClassDefaults::GetProperties(UClass* Class) {
+    TWeakObjectPtr<UClass> Key(Class);
+
+    {
+        FReadScopeLock ReadLock(Lock);
+        if (TUniquePtr<TArray<FProperty*>> const* Found = Properties.Find(Key)) {
+            return *Found[0];
+        }
+    }
+
+    FWriteScopeLock WriteLock(Lock);
+
+    // Another thread might have added it while we were waiting
+    TUniquePtr<TArray<FProperty*>>& Entry = Properties.FindOrAdd(Key);
+    if (!Entry.IsValid()) {
+        Entry = MakeUnique<TArray<FProperty*>>();
+
+        for (TFieldIterator<FProperty> It(Class); It; ++It) {
+            FProperty* Property = *It;
+
+            if (!Property->HasAnyPropertyFlags(CPF_Edit | CPF_BlueprintVisible)) {
+                continue;
+            }
+
+            // Never saved, or owned by the object and always different, see DiffSubobjects
+            if (Property->HasAnyPropertyFlags(CPF_Transient | CPF_DuplicateTransient | CPF_Deprecated |
+                                              CPF_InstancedReference | CPF_ContainsInstancedReference)) {
+                continue;
+            }
+
+            Entry->Add(Property);
+        }
+    }
+    return *Entry;
+}
+
+void FGKClassDefaults::Diff(UObject* Object, UObject* Archetype, TArray<FGKPropertyDelta>& Deltas) {
+    if (Object == nullptr || Archetype == nullptr || !Object->IsA(Archetype->GetClass())) {
+        return;
+    }
+
+    for (FProperty* Property : GetProperties(Archetype->GetClass())) {
+        if (Property->Identical_InContainer(Object, Archetype, 0, PPF_None)) {
+            continue;
+        }
+
+        Deltas.Add({Property, Export(Property, Object, Archetype)});
+    }
+}
+
+void FGKClassDefaults::DiffSubobjects(UObject* Object, UObject* Archetype, TArray<FGKSubobjectDelta>& Deltas, FString const& Prefix) {
+    if (Object == nullptr || Archetype == nullptr) {
+        return;
+    }
+
+    TArray<UObject*> Subobjects;
+    Object->GetDefaultSubobjects(Subobjects);
+
+    for (UObject* Subobject : Subobjects) {
+        // Created by the class itself, nothing is inherited
+        UObject* Inherited = Archetype->GetDefaultSubobjectByName(Subobject->GetFName());
+        if (Inherited == nullptr) {
+            continue;
+        }
+
+        FGKSubobjectDelta Delta;
+        Delta.Path = Prefix + Subobject->GetName();
+        Diff(Subobject, Inherited, Delta.Deltas);
+
+        FString Path = Delta.Path;
+        if (Delta.Deltas.Num() > 0) {
+            Deltas.Add(MoveTemp(Delta));
+        }
+
+        DiffSubobjects(Subobject, Inherited, Deltas, Path + TEXT("."));
+    }
+}
+
+bool FGKClassDefaults::IsDefault(FProperty* Property, void const* Container) {
+    void const* Value = Property->ContainerPtrToValuePtr<void>(Container);
+
+    // Default constructed value of the type
+    void* Default = FMemory::Malloc(Property->GetSize(), Property->GetMinAlignment());
+    Property->InitializeValue(Default);
+
+    bool bDefault = Property->Identical(Value, Default, PPF_None);
+
+    Property->DestroyValue(Default);
+    FMemory::Free(Default);
+    return bDefault;
+}
+
+FString FGKClassDefaults::Export(FProperty* Property, void const* Container, void const* DefaultContainer) {
+    FString Value;
+    Property->ExportTextItem_Direct(
+        Value,
+        Property->ContainerPtrToValuePtr<void>(Container),
+        DefaultContainer ? Property->ContainerPtrToValuePtr<void>(DefaultContainer) : nullptr,
+        nullptr,
+        PPF_None
+    );
+    return Value;
+}
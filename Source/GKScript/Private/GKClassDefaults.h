@@ -0,0 +1,68 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Unreal Engine
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+
+
+struct FGKPropertyDelta {
+    FProperty* Property;
+    FString    Value;       // Exported against the archetype, structs only list the fields that differ
+};
+
+struct FGKSubobjectDelta {
+    FString                  Path;      // Subobject names from the diffed object, dot separated
+    TArray<FGKPropertyDelta> Deltas;
+};
+
+
+/*! Property delta of an object against its archetype
+ *
+ * Generated code only lists the values a Blueprint or a component template changes,
+ * everything else comes from the parent class defaults.
+ *
+ * The properties worth comparing (editable or visible to Blueprints, not transient,
+ * not instanced subobjects) are gathered once per class and kept until a Blueprint
+ * is compiled or objects are reinstanced, both free the properties of the old class.
+ * A diff is a value comparison per property and an export per difference.
+ *
+ * .. note::
+ *
+ *    Lookups are thread safe, the table is shared by all transforms
+ */
+struct FGKClassDefaults {
+    static FGKClassDefaults& Get();
+
+    // Properties of Archetype's class that differ between Object and Archetype
+    void Diff(UObject* Object, UObject* Archetype, TArray<FGKPropertyDelta>& Deltas);
+
+    // Default subobjects of Object, nested ones included, against the subobject of the same name in Archetype.
+    // Instanced properties point to different objects by design, their values are compared here instead
+    void DiffSubobjects(UObject* Object, UObject* Archetype, TArray<FGKSubobjectDelta>& Deltas, FString const& Prefix = FString());
+
+    TArray<FProperty*> const& GetProperties(UClass* Class);
+
+    // True if the value of Property in Container is the default value of its type
+    static bool IsDefault(FProperty* Property, void const* Container);
+
+    static FString Export(FProperty* Property, void const* Container, void const* DefaultContainer = nullptr);
+
+    void Reset();
+
+    // Drop the cache when the properties it points to are freed
+    void Register();
+    void Unregister();
+
+private:
+    void OnObjectsReinstanced(TMap<UObject*, UObject*> const& OldToNew);
+
+    FDelegateHandle PostEngineInitHandle;
+    FDelegateHandle ReinstancedHandle;
+    FDelegateHandle CompiledHandle;
+
+    FRWLock                                                       Lock;
+    TMap<TWeakObjectPtr<UClass>, TUniquePtr<TArray<FProperty*>>>  Properties;   // Heap allocated so references
+                                                                                // survive a rehash of the map
+};
@@ -0,0 +1,396 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKCodePreview.h"
+
+// Gamekit
+#include "GKScript.h"
+
+// Unreal Engine
+#include "Editor.h"
+#include "EdGraph/EdGraph.h"
+#include "Engine/Blueprint.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Framework/Docking/TabManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/CoreDelegates.h"
+#include "Styling/CoreStyle.h"
+#include "Subsystems/AssetEditorSubsystem.h"
+#include "Widgets/Docking/SDockTab.h"
+#include "Widgets/Input/SMultiLineEditableTextBox.h"
+#include "Widgets/Layout/SBorder.h"
+#include "Widgets/SBoxPanel.h"
+#include "Widgets/Text/STextBlock.h"
+#include "WorkspaceMenuStructure.h"
+#include "WorkspaceMenuStructureModule.h"
+
+
+#define LOCTEXT_NAMESPACE "FGKScriptModule"
+
+namespace {
+
+const FName GKCodePreviewTab(TEXT("GKScriptCodePreview"));
+
+void AppendCode(FString& Code, TArray<ANSICHAR> const& Bytes) {
+    FUTF8ToTCHAR Converted(Bytes.GetData(), Bytes.Num());
+    Code.AppendChars(Converted.Get(), Converted.Length());
+}
+
+} // namespace
+
+
+void SGKCodePreview::Construct(FArguments const& InArgs) {
+    ChildSlot
+    [
+        SNew(SVerticalBox)
+        + SVerticalBox::Slot()
+        .AutoHeight()
+        .Padding(4.f)
+        [
+            SAssignNew(TitleText, STextBlock)
+            .Text(LOCTEXT("PreviewEmpty", "Open a Blueprint to preview its code"))
+        ]
+        + SVerticalBox::Slot()
+        .FillHeight(1.f)
+        [
+            SAssignNew(CodeText, SMultiLineEditableTextBox)
+            .IsReadOnly(true)
+            .AlwaysShowScrollbars(true)
+            .Font(FCoreStyle::GetDefaultFontStyle("Mono", 9))
+        ]
+    ];
+}
+
+void SGKCodePreview::SetCode(FText const& Title, FString const& Code) {
+    TitleText->SetText(Title);
+    CodeText->SetText(FText::FromString(Code));
+}
+
+
+FGKCodePreview& FGKCodePreview::Get() {
+    static FGKCodePreview Preview;
+    return Preview;
+}
+
+void FGKCodePreview::Register() {
+    FGlobalTabmanager::Get()->RegisterNomadTabSpawner(GKCodePreviewTab, FOnSpawnTab::CreateRaw(this, &FGKCodePreview::SpawnTab))
+        .SetDisplayName(LOCTEXT("PreviewTab", "GKScript Preview"))
+        .SetTooltipText(LOCTEXT("PreviewTabTooltip", "Code generated from the Blueprint being edited"))
+        .SetGroup(WorkspaceMenu::GetMenuStructure().GetToolsCategory());
+
+    if (GEditor != nullptr) {
+        SubscribeAssetEditors();
+        return;
+    }
+
+    // The asset editor subsystem does not exist yet when the module starts with the editor
+    PostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddRaw(this, &FGKCodePreview::SubscribeAssetEditors);
+}
+
+void FGKCodePreview::SubscribeAssetEditors() {
+    if (GEditor == nullptr) {
+        return;
+    }
+
+    if (UAssetEditorSubsystem* AssetEditors = GEditor->GetEditorSubsystem<UAssetEditorSubsystem>()) {
+        AssetOpenedHandle = AssetEditors->OnAssetOpenedInEditor().AddRaw(this, &FGKCodePreview::OnAssetOpened);
+    }
+}
+
+void FGKCodePreview::Unregister() {
+    SetBlueprint(nullptr);
+
+    FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
+    PostEngineInitHandle.Reset();
+
+    if (FSlateApplication::IsInitialized()) {
+        FGlobalTabmanager::Get()->UnregisterNomadTabSpawner(GKCodePreviewTab);
+    }
+
+    if (GEditor && AssetOpenedHandle.IsValid()) {
+        if (UAssetEditorSubsystem* AssetEditors = GEditor->GetEditorSubsystem<UAssetEditorSubsystem>()) {
+            AssetEditors->OnAssetOpenedInEditor().Remove(AssetOpenedHandle);
+        }
+    }
+    AssetOpenedHandle.Reset();
+}
+
+TSharedRef<SDockTab> FGKCodePreview::SpawnTab(FSpawnTabArgs const& Args) {
+    TSharedRef<SGKCodePreview> Preview = SNew(SGKCodePreview);
+    Widget = Preview;
+    Refresh();
+
+    // Edits made while the tab was closed
+    Schedule();
+
+    return SNew(SDockTab)
+        .TabRole(ETabRole::NomadTab)
+        [
+            Preview
+        ];
+}
+
+void FGKCodePreview::OnAssetOpened(UObject* Asset, IAssetEditorInstance* Editor) {
+    if (UBlueprint* Opened = Cast<UBlueprint>(Asset)) {
+        SetBlueprint(Opened);
+    }
+}
+
+void FGKCodePreview::SetBlueprint(UBlueprint* NewBlueprint) {
+    if (Blueprint.Get() == NewBlueprint) {
+        return;
+    }
+
+    Unsubscribe();
+    Job.Reset();
+    Transform.Reset();
+    HeaderCode.Reset();
+    GraphCode.Reset();
+    GraphNames.Reset();
+    DirtyGraphs.Reset();
+    CurrentGraph.Reset();
+
+    Blueprint = NewBlueprint;
+    if (NewBlueprint == nullptr) {
+        return;
+    }
+
+    BlueprintHandle = NewBlueprint->OnChanged().AddRaw(this, &FGKCodePreview::OnBlueprintChanged);
+    bHeaderDirty = true;
+    SyncGraphs();
+    Schedule();
+}
+
+void FGKCodePreview::Unsubscribe() {
+    for (TPair<TWeakObjectPtr<UEdGraph>, FDelegateHandle> const& Item : GraphHandles) {
+        if (UEdGraph* Graph = Item.Key.Get()) {
+            Graph->RemoveOnGraphChangedHandler(Item.Value);
+        }
+    }
+    GraphHandles.Reset();
+
+    if (UBlueprint* Current = Blueprint.Get()) {
+        Current->OnChanged().Remove(BlueprintHandle);
+    }
+    BlueprintHandle.Reset();
+}
+
+void FGKCodePreview::SyncGraphs() {
+    UBlueprint* Current = Blueprint.Get();
+    if (Current == nullptr) {
+        return;
+    }
+
+    TSet<TWeakObjectPtr<UEdGraph>> Graphs;
+    for (UEdGraph* Graph : Current->FunctionGraphs) {
+        Graphs.Add(Graph);
+    }
+    for (UEdGraph* Graph : Current->UbergraphPages) {
+        Graphs.Add(Graph);
+    }
+
+    // Removed graphs
+    for (auto It = GraphHandles.CreateIterator(); It; ++It) {
+        if (!Graphs.Contains(It->Key)) {
+            if (UEdGraph* Graph = It->Key.Get()) {
+                Graph->RemoveOnGraphChangedHandler(It->Value);
+            }
+            GraphCode.Remove(It->Key);
+            GraphNames.Remove(It->Key);
+            It.RemoveCurrent();
+        }
+    }
+
+    // New graphs
+    for (TWeakObjectPtr<UEdGraph> const& Graph : Graphs) {
+        if (!GraphHandles.Contains(Graph)) {
+            GraphHandles.Add(Graph, Graph->AddOnGraphChangedHandler(
+                FOnGraphChanged::FDelegate::CreateRaw(this, &FGKCodePreview::OnGraphChanged, Graph)
+            ));
+            MarkDirty(Graph.Get());
+        }
+    }
+}
+
+void FGKCodePreview::OnBlueprintChanged(UBlueprint* Changed) {
+    // Compilation can rebuild the nodes of the graph being emitted
+    Restart();
+    bHeaderDirty = true;
+    SyncGraphs();
+    Schedule();
+}
+
+void FGKCodePreview::OnGraphChanged(FEdGraphEditAction const& Action, TWeakObjectPtr<UEdGraph> Graph) {
+    // The traversal of a graph does not survive an edit of the graph
+    if (Graph == CurrentGraph) {
+        Restart();
+    }
+    MarkDirty(Graph.Get());
+    Schedule();
+}
+
+void FGKCodePreview::Restart() {
+    if (Transform.IsValid()) {
+        Transform.Reset();
+        MarkDirty(CurrentGraph.Get());
+    }
+    CurrentGraph.Reset();
+}
+
+void FGKCodePreview::MarkDirty(UEdGraph* Graph) {
+    if (Graph) {
+        DirtyGraphs.AddUnique(Graph);
+    }
+}
+
+void FGKCodePreview::Schedule() {
+    // Nobody is looking
+    if (!Widget.IsValid()) {
+        return;
+    }
+
+    if (!Job.IsValid() || Job->IsDone()) {
+        Job = FGKTimeSlicedJob::Start([this](double EndTime) {
+            return Step(EndTime);
+        });
+    }
+}
+
+bool FGKCodePreview::Step(double EndTime) {
+    UBlueprint* Current = Blueprint.Get();
+    if (Current == nullptr || !Widget.IsValid()) {
+        Restart();
+        return true;
+    }
+
+    while (true) {
+        if (!Transform.IsValid()) {
+            if (bHeaderDirty) {
+                HeaderCode.Reset();
+                FGKEdGraphTransform Header(Current, HeaderCode);
+                Header.Writer.Write("import unreal\n");
+                Header.BeginClass();
+                Header.GenerateDefaults();
+                bHeaderDirty = false;
+
+                if (FPlatformTime::Seconds() >= EndTime) {
+                    Refresh();
+                    return false;
+                }
+                continue;
+            }
+
+            if (DirtyGraphs.Num() == 0) {
+                Refresh();
+                return true;
+            }
+
+            // In file order, a graph picks its names after the ones before it
+            TArray<UEdGraph*> Graphs = GetGraphs();
+            DirtyGraphs.Sort([&Graphs](TWeakObjectPtr<UEdGraph> const& A, TWeakObjectPtr<UEdGraph> const& B) {
+                return Graphs.IndexOfByKey(A.Get()) < Graphs.IndexOfByKey(B.Get());
+            });
+
+            CurrentGraph = DirtyGraphs[0];
+            DirtyGraphs.RemoveAt(0);
+            if (!CurrentGraph.IsValid()) {
+                continue;
+            }
+
+            // Graphs are emitted inside the class body, after the names the graphs before them took
+            Output.Reset();
+            Transform = MakeUnique<FGKEdGraphTransform>(Current, Output);
+            Transform->IndentationLevel = 1;
+            Transform->bFunctionCache = false;
+            Transform->Context.Last().Variables = GetNamesBefore(CurrentGraph.Get());
+            SeedNames = Transform->Context.Last().Variables;
+        }
+
+        UEdGraph* Graph = CurrentGraph.Get();
+        if (Graph && !Transform->GenerateGraphSlice(Graph, EndTime)) {
+            return false;
+        }
+
+        if (Graph) {
+            GraphCode.Add(Graph, Output);
+            SetNames(Graph, Transform->Context.Last().Variables);
+        }
+        Transform.Reset();
+
+        // Show what is ready, the rest comes next frame
+        if (FPlatformTime::Seconds() >= EndTime) {
+            Refresh();
+            return false;
+        }
+    }
+}
+
+TArray<UEdGraph*> FGKCodePreview::GetGraphs() const {
+    TArray<UEdGraph*> Graphs;
+    if (UBlueprint* Current = Blueprint.Get()) {
+        Graphs.Append(Current->FunctionGraphs);
+        Graphs.Append(Current->UbergraphPages);
+    }
+    return Graphs;
+}
+
+TSet<FString> FGKCodePreview::GetNamesBefore(UEdGraph* Graph) const {
+    TSet<FString> Names;
+
+    for (UEdGraph* Previous : GetGraphs()) {
+        if (Previous == Graph) {
+            break;
+        }
+        if (TSet<FString> const* Found = GraphNames.Find(Previous)) {
+            Names.Append(*Found);
+        }
+    }
+    return Names;
+}
+
+void FGKCodePreview::SetNames(UEdGraph* Graph, TSet<FString> const& Variables) {
+    TSet<FString> Names = Variables.Difference(SeedNames);
+
+    TSet<FString>* Previous = GraphNames.Find(Graph);
+    if (Previous && Previous->Num() == Names.Num() && Previous->Includes(Names)) {
+        return;
+    }
+    GraphNames.Add(Graph, MoveTemp(Names));
+
+    // The graphs after it pick their names against different ones
+    bool bAfter = false;
+    for (UEdGraph* Next : GetGraphs()) {
+        if (bAfter) {
+            MarkDirty(Next);
+        }
+        bAfter = bAfter || Next == Graph;
+    }
+}
+
+void FGKCodePreview::Refresh() {
+    TSharedPtr<SGKCodePreview> Preview = Widget.Pin();
+    UBlueprint* Current = Blueprint.Get();
+
+    if (!Preview.IsValid() || Current == nullptr) {
+        return;
+    }
+
+    FString Code;
+    AppendCode(Code, HeaderCode);
+
+    // In the order of the generated file
+    auto AppendGraphs = [&](TArray<UEdGraph*> const& Graphs) {
+        for (UEdGraph* Graph : Graphs) {
+            if (TArray<ANSICHAR> const* Found = GraphCode.Find(Graph)) {
+                AppendCode(Code, *Found);
+            }
+        }
+    };
+    AppendGraphs(Current->FunctionGraphs);
+    AppendGraphs(Current->UbergraphPages);
+
+    Preview->SetCode(FText::FromString(Current->GetName()), Code);
+}
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,112 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Gamekit
+#include "GKEdGraphTransform.h"
+#include "GKTimeSlice.h"
+
+// Unreal Engine
+#include "CoreMinimal.h"
+#include "Widgets/SCompoundWidget.h"
+
+class SDockTab;
+class FSpawnTabArgs;
+class SMultiLineEditableTextBox;
+class STextBlock;
+class UBlueprint;
+class UEdGraph;
+
+
+class SGKCodePreview: public SCompoundWidget
+{
+    public:
+    SLATE_BEGIN_ARGS(SGKCodePreview) {}
+    SLATE_END_ARGS()
+
+    void Construct(FArguments const& InArgs);
+
+    void SetCode(FText const& Title, FString const& Code);
+
+    private:
+    TSharedPtr<STextBlock>                  TitleText;
+    TSharedPtr<SMultiLineEditableTextBox>   CodeText;
+};
+
+
+/*! Live code preview of the Blueprint being edited
+ *
+ * The preview follows the last Blueprint opened in an asset editor and keeps
+ * the code of its class header and of each graph separately.
+ * A graph change only regenerates that graph, a Blueprint change (compile, new variable,
+ * new function) regenerates the header and the graphs that were added.
+ *
+ * Regeneration is time sliced on the game thread (``GKScript.TimeSliceMs``),
+ * graphs that did not change keep their code in memory, the on disk FGKFunctionCache
+ * is not used so the game thread does not wait on it.
+ * A graph starts from the names the graphs before it took, as in the generated file,
+ * when those change the graphs after it are emitted again.
+ */
+class FGKCodePreview
+{
+    public:
+    static FGKCodePreview& Get();
+
+    void Register();
+    void Unregister();
+
+    void SetBlueprint(UBlueprint* Blueprint);
+
+    private:
+    TSharedRef<SDockTab> SpawnTab(FSpawnTabArgs const& Args);
+
+    void SubscribeAssetEditors();
+
+    void OnAssetOpened(UObject* Asset, class IAssetEditorInstance* Editor);
+    void OnBlueprintChanged(UBlueprint* Blueprint);
+    void OnGraphChanged(struct FEdGraphEditAction const& Action, TWeakObjectPtr<UEdGraph> Graph);
+
+    // Subscribe to the graphs of the Blueprint, new graphs are marked dirty
+    void SyncGraphs();
+    void Unsubscribe();
+
+    // Drop the graph being emitted, it is emitted again from the start
+    void Restart();
+
+    void MarkDirty(UEdGraph* Graph);
+    void Schedule();
+
+    bool Step(double EndTime);
+    void Refresh();
+
+    // Graphs in the order of the generated file
+    TArray<UEdGraph*> GetGraphs() const;
+
+    // Names taken by the graphs before this one, as the class scope of the generated file has them
+    TSet<FString> GetNamesBefore(UEdGraph* Graph) const;
+
+    // Remember the names the graph took, the graphs after it are emitted again if they changed
+    void SetNames(UEdGraph* Graph, TSet<FString> const& Variables);
+
+    TWeakObjectPtr<UBlueprint>                          Blueprint;
+    TMap<TWeakObjectPtr<UEdGraph>, FDelegateHandle>     GraphHandles;
+    FDelegateHandle                                     BlueprintHandle;
+    FDelegateHandle                                     AssetOpenedHandle;
+    FDelegateHandle                                     PostEngineInitHandle;
+
+    // Generated code, per part
+    TArray<ANSICHAR>                                    HeaderCode;
+    TMap<TWeakObjectPtr<UEdGraph>, TArray<ANSICHAR>>    GraphCode;
+    TMap<TWeakObjectPtr<UEdGraph>, TSet<FString>>       GraphNames;     // Names each graph added to the class scope
+
+    // Pending work
+    bool                                                bHeaderDirty = false;
+    TArray<TWeakObjectPtr<UEdGraph>>                    DirtyGraphs;
+    TWeakObjectPtr<UEdGraph>                            CurrentGraph;
+    TArray<ANSICHAR>                                    Output;         // Written by Transform
+    TUniquePtr<FGKEdGraphTransform>                     Transform;
+    TSet<FString>                                       SeedNames;      // Names Transform started with
+    TSharedPtr<FGKTimeSlicedJob>                        Job;
+
+    TWeakPtr<SGKCodePreview>                            Widget;
+};
@@ -0,0 +1,207 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKEdGraphLiterals.h"
+
+// Unreal Engine
+#include "EdGraphSchema_K2.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "Misc/DefaultValueHelper.h"
+
+
+namespace {
+
+bool ParseBool(FStringView Value, bool& Out) {
+    if (Value.Equals(TEXT("true"), ESearchCase::IgnoreCase)) {
+        Out = true;
+        return true;
+    }
+    if (Value.Equals(TEXT("false"), ESearchCase::IgnoreCase)) {
+        Out = false;
+        return true;
+    }
+    return false;
+}
+
+void AppendReal(FStringBuilderBase& Out, double Value) {
+    Out << FString::SanitizeFloat(Value);
+}
+
+void AppendTuple(FStringBuilderBase& Out, double const* Values, int Count) {
+    Out << TEXT("(");
+    for (int i = 0; i < Count; i++) {
+        if (i > 0) {
+            Out << TEXT(", ");
+        }
+        AppendReal(Out, Values[i]);
+    }
+    Out << TEXT(")");
+}
+
+void AppendQuoted(FStringBuilderBase& Out, FStringView Value) {
+    Out << TEXT("\"");
+
+    // Most literals have nothing to escape, do not copy them
+    bool bEscape = false;
+    for (TCHAR Char : Value) {
+        if (Char == TEXT('\\') || Char == TEXT('"') || Char == TEXT('\n') || Char == TEXT('\r') || Char == TEXT('\t')) {
+            bEscape = true;
+            break;
+        }
+    }
+
+    if (bEscape) {
+        Out << FString(Value).ReplaceCharWithEscapedChar();
+    } else {
+        Out.Append(Value.GetData(), Value.Len());
+    }
+    Out << TEXT("\"");
+}
+
+} // namespace
+
+
+FGKLiteral FGKLiteral::FromPin(UEdGraphPin const* Pin) {
+    FGKLiteral Literal;
+    FName const Category = Pin->PinType.PinCategory;
+    FString const& Value = Pin->DefaultValue;
+
+    // Same precedence as before the literals: value, object then text
+    if (Value.IsEmpty()) {
+        // Objects & Classes
+        if (Pin->DefaultObject) {
+            Literal.Kind = EGKLiteralKind::Object;
+            Literal.Object = Pin->DefaultObject;
+        }
+        else if (!Pin->DefaultTextValue.IsEmpty()) {
+            Literal.Kind = EGKLiteralKind::Text;
+            Literal.Text = Pin->DefaultTextValue.ToString();
+        }
+        return Literal;
+    }
+
+    Literal.Text = Value;
+
+    if (Category == UEdGraphSchema_K2::PC_Text) {
+        Literal.Kind = EGKLiteralKind::Text;
+    }
+    else if (Category == UEdGraphSchema_K2::PC_Boolean) {
+        Literal.Kind = ParseBool(Value, Literal.Bool) ? EGKLiteralKind::Bool : EGKLiteralKind::Raw;
+    }
+    else if (Category == UEdGraphSchema_K2::PC_Int || Category == UEdGraphSchema_K2::PC_Int64) {
+        Literal.Kind = EGKLiteralKind::Int;
+        Literal.Int = FCString::Atoi64(*Value);
+    }
+    else if (Category == UEdGraphSchema_K2::PC_Real || Category == UEdGraphSchema_K2::PC_Float || Category == UEdGraphSchema_K2::PC_Double) {
+        Literal.Kind = EGKLiteralKind::Real;
+        Literal.Real[0] = FCString::Atod(*Value);
+    }
+    else if (Category == UEdGraphSchema_K2::PC_Byte || Category == UEdGraphSchema_K2::PC_Enum) {
+        Literal.Object = Pin->PinType.PinSubCategoryObject.Get();
+
+        if (Cast<UEnum>(Literal.Object)) {
+            Literal.Kind = EGKLiteralKind::Enum;
+        } else {
+            Literal.Kind = EGKLiteralKind::Int;
+            Literal.Int = FCString::Atoi64(*Value);
+        }
+    }
+    else if (Category == UEdGraphSchema_K2::PC_String) {
+        Literal.Kind = EGKLiteralKind::String;
+    }
+    else if (Category == UEdGraphSchema_K2::PC_Name) {
+        Literal.Kind = EGKLiteralKind::Name;
+    }
+    else if (Category == UEdGraphSchema_K2::PC_Struct) {
+        UObject* Struct = Pin->PinType.PinSubCategoryObject.Get();
+        Literal.Kind = EGKLiteralKind::Raw;
+
+        if (Struct == TBaseStructure<FVector>::Get()) {
+            FVector Vector;
+            if (FDefaultValueHelper::ParseVector(Value, Vector)) {
+                Literal.Kind = EGKLiteralKind::Vector;
+                Literal.Real[0] = Vector.X;
+                Literal.Real[1] = Vector.Y;
+                Literal.Real[2] = Vector.Z;
+            }
+        }
+        else if (Struct == TBaseStructure<FRotator>::Get()) {
+            FRotator Rotator;
+            if (FDefaultValueHelper::ParseRotator(Value, Rotator)) {
+                Literal.Kind = EGKLiteralKind::Rotator;
+                Literal.Real[0] = Rotator.Pitch;
+                Literal.Real[1] = Rotator.Yaw;
+                Literal.Real[2] = Rotator.Roll;
+            }
+        }
+    }
+    else {
+        // Unknown category, booleans are still fixed up
+        Literal.Kind = ParseBool(Value, Literal.Bool) ? EGKLiteralKind::Bool : EGKLiteralKind::Raw;
+    }
+
+    return Literal;
+}
+
+void FGKLiteral::AppendTo(FStringBuilderBase& Out) const {
+    switch (Kind) {
+    case EGKLiteralKind::None:
+        return;
+
+    case EGKLiteralKind::Bool:
+        Out << (Bool ? TEXT("True") : TEXT("False"));
+        return;
+
+    case EGKLiteralKind::Int:
+        Out.Appendf(TEXT("%") INT64_FMT, Int);
+        return;
+
+    case EGKLiteralKind::Real:
+        AppendReal(Out, Real[0]);
+        return;
+
+    case EGKLiteralKind::Vector:
+    case EGKLiteralKind::Rotator:
+        AppendTuple(Out, Real, 3);
+        return;
+
+    case EGKLiteralKind::Enum:
+        Object->GetFName().AppendString(Out);
+        Out << TEXT(".");
+        Out.Append(Text.GetData(), Text.Len());
+        return;
+
+    case EGKLiteralKind::Object: {
+        Object->GetClass()->GetFName().AppendString(Out);
+
+        // Static functions are called on the library itself
+        if (Cast<UBlueprintFunctionLibrary>(Object)) {
+            return;
+        }
+
+        Out << TEXT("(\"");
+        Object->GetPathName(nullptr, Out);
+        Out << TEXT("\")");
+        return;
+    }
+
+    case EGKLiteralKind::Text:
+    case EGKLiteralKind::String:
+    case EGKLiteralKind::Name:
+        AppendQuoted(Out, Text);
+        return;
+
+    case EGKLiteralKind::Raw: {
+        // Structs are exported as (X=1.0,Y=1.0)
+        int32 Comma = INDEX_NONE;
+        if (!Text.StartsWith(TEXT('(')) && Text.FindChar(TEXT(','), Comma)) {
+            Out << TEXT("(");
+            Out.Append(Text.GetData(), Text.Len());
+            Out << TEXT(")");
+            return;
+        }
+        Out.Append(Text.GetData(), Text.Len());
+        return;
+    }
+    }
+}
@@ -0,0 +1,58 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Unreal Engine
+#include "CoreMinimal.h"
+#include "Misc/StringBuilder.h"
+
+class UEdGraphPin;
+
+
+enum class EGKLiteralKind : uint8 {
+    None,       // No default value
+    Bool,
+    Int,
+    Real,
+    Vector,
+    Rotator,
+    Enum,
+    Object,
+    Text,
+    String,
+    Name,
+    Raw,        // Unknown struct, emitted as is
+};
+
+
+/*! Compact literal parsed from a pin default value
+ *
+ * The pin category decides how the default value is interpreted,
+ * the literal keeps views on the pin strings, it must not outlive the pin.
+ *
+ * .. code-block:: python
+ *
+ *    Scale = (1.0, 1.0, 1.0)
+ *    TraceChannel = ETraceTypeQuery.TraceTypeQuery1
+ *    Message = "Hello"
+ */
+struct FGKLiteral {
+    static FGKLiteral FromPin(UEdGraphPin const* Pin);
+
+    void AppendTo(FStringBuilderBase& Out) const;
+
+    bool IsEmpty() const {
+        return Kind == EGKLiteralKind::None;
+    }
+
+    EGKLiteralKind Kind = EGKLiteralKind::None;
+
+    union {
+        bool   Bool;
+        int64  Int;
+        double Real[3];
+    };
+
+    UObject*    Object = nullptr;  // Enum or Default object
+    FStringView Text;              // View on the pin default value
+};
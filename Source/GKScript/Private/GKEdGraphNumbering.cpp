@@ -0,0 +1,168 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKEdGraphNumbering.h"
+
+// Gamekit
+#include "GKScriptStats.h"
+
+// Unreal Engine
+#include "EdGraph/EdGraph.h"
+#include "EdGraph/EdGraphNode.h"
+#include "EdGraph/EdGraphPin.h"
+#include "HAL/PlatformTime.h"
+
+
+namespace {
+
+// Past this many slots per node the object index table costs more than a map
+const int32 GKMaxObjectSlotsPerNode = 64;
+
+} // namespace
+
+
+void FGKGraphNumbering::Build(UEdGraph* Graph) {
+    BeginBuild(Graph);
+    BuildSlice(MAX_dbl);
+}
+
+void FGKGraphNumbering::BeginBuild(UEdGraph* Graph) {
+    Reset();
+
+    BuildGraph = Graph;
+    BuildNodes = Graph ? Graph->Nodes.Num() : 0;
+    BuildCursor = 0;
+    MinObject = MAX_uint32;
+    MaxObject = 0;
+
+    Nodes.Reserve(BuildNodes);
+    FirstPins.Reserve(BuildNodes + 1);
+    ObjectIds.Reserve(BuildNodes);
+}
+
+bool FGKGraphNumbering::BuildSlice(double EndTime) {
+    GKSCRIPT_SCOPE(STAT_GKScript_Numbering);
+
+    UEdGraph* Graph = BuildGraph.Get();
+    if (Graph == nullptr) {
+        Reset();
+        return true;
+    }
+
+    // The cursor would skip or repeat nodes
+    if (Graph->Nodes.Num() != BuildNodes) {
+        BeginBuild(Graph);
+    }
+
+    while (BuildCursor < Graph->Nodes.Num()) {
+        UEdGraphNode* Node = Graph->Nodes[BuildCursor];
+        BuildCursor += 1;
+
+        if (Node != nullptr) {
+            Nodes.Add(Node);
+            FirstPins.Add(Pins.Num());
+            Pins.Append(Node->Pins);
+
+            ObjectIds.Add(Node->GetUniqueID());
+            MinObject = FMath::Min(MinObject, Node->GetUniqueID());
+            MaxObject = FMath::Max(MaxObject, Node->GetUniqueID());
+        }
+
+        if (FPlatformTime::Seconds() >= EndTime && BuildCursor < Graph->Nodes.Num()) {
+            return false;
+        }
+    }
+    FirstPins.Add(Pins.Num());
+    BuildGraph = nullptr;
+
+    if (Nodes.Num() == 0) {
+        return true;
+    }
+
+    // Nodes of a graph are usually created together and have close object indices
+    uint64 Slots = uint64(MaxObject - MinObject) + 1;
+    if (Slots <= uint64(Nodes.Num()) * GKMaxObjectSlotsPerNode) {
+        FirstObject = MinObject;
+        ObjectToNode.Init(INDEX_NONE, int32(Slots));
+
+        for (int32 Id = 0; Id < Nodes.Num(); Id++) {
+            ObjectToNode[ObjectIds[Id] - FirstObject] = Id;
+        }
+        return true;
+    }
+
+    SparseNodeIds.Reserve(Nodes.Num());
+    for (int32 Id = 0; Id < Nodes.Num(); Id++) {
+        SparseNodeIds.Add(Nodes[Id], Id);
+    }
+    return true;
+}
+
+void FGKGraphNumbering::Reset() {
+    // Keep the memory around, graphs are numbered one after the other
+    Nodes.Reset();
+    Pins.Reset();
+    FirstPins.Reset();
+    FirstObject = 0;
+    ObjectToNode.Reset();
+    SparseNodeIds.Reset();
+    ObjectIds.Reset();
+}
+
+int32 FGKGraphNumbering::GetNodeId(UEdGraphNode const* Node) const {
+    if (Node == nullptr) {
+        return INDEX_NONE;
+    }
+
+    if (SparseNodeIds.Num() > 0) {
+        int32 const* Id = SparseNodeIds.Find(Node);
+        return Id ? *Id : INDEX_NONE;
+    }
+
+    uint32 Slot = Node->GetUniqueID() - FirstObject;
+    if (Slot >= uint32(ObjectToNode.Num())) {
+        return INDEX_NONE;
+    }
+
+    // Object indices are recycled, the slot could belong to a node of another graph
+    int32 Id = ObjectToNode[Slot];
+    return Id != INDEX_NONE && Nodes[Id] == Node ? Id : INDEX_NONE;
+}
+
+int32 FGKGraphNumbering::GetPinId(UEdGraphPin const* Pin) const {
+    int32 NodeId = GetNodeId(Pin->GetOwningNodeUnchecked());
+    if (NodeId == INDEX_NONE) {
+        return INDEX_NONE;
+    }
+
+    // Nodes have a handful of pins, a scan is cheaper than a hash
+    int32 First = FirstPins[NodeId];
+    int32 Count = FirstPins[NodeId + 1] - First;
+
+    for (int32 i = 0; i < Count; i++) {
+        if (Pins[First + i] == Pin) {
+            return First + i;
+        }
+    }
+    return INDEX_NONE;
+}
+
+
+FGKVisitedPins::FGKVisitedPins(FGKGraphNumbering const& Numbering):
+    Numbering(Numbering),
+    Bits(false, Numbering.NumPins())
+{}
+
+bool FGKVisitedPins::Mark(UEdGraphPin const* Pin) {
+    int32 Id = Numbering.GetPinId(Pin);
+
+    if (Id == INDEX_NONE) {
+        bool bVisited = false;
+        External.Add(Pin, &bVisited);
+        return bVisited;
+    }
+
+    bool bVisited = Bits[Id];
+    Bits[Id] = true;
+    return bVisited;
+}
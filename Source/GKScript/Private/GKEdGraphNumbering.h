@@ -0,0 +1,91 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Unreal Engine
+#include "CoreMinimal.h"
+
+class UEdGraph;
+class UEdGraphNode;
+class UEdGraphPin;
+
+
+/*! Dense numbering of the nodes and pins of a graph
+ *
+ * The numbering pass runs once per graph, afterwards the per node and per pin
+ * state of the traversal can live in flat arrays and bit arrays indexed by id
+ * instead of maps keyed by pointers.
+ *
+ * Ids are ``[0, NumNodes())`` and ``[0, NumPins())``, pins of a node are contiguous.
+ * Node ids are found through the object index the engine already stores in every node,
+ * pin ids from the id of their node and their position in it, so lookups do not hash
+ * pointers, unless the object indices of the nodes are scattered.
+ */
+struct FGKGraphNumbering {
+    void Build(UEdGraph* Graph);
+
+    // Resumable Build, for the game thread
+    void BeginBuild(UEdGraph* Graph);
+
+    // Returns true once the graph is numbered, EndTime is in FPlatformTime::Seconds.
+    // The numbering starts over if nodes were added or removed in between
+    bool BuildSlice(double EndTime);
+
+    void Reset();
+
+    // Returns INDEX_NONE for nodes that are not part of the numbered graph
+    int32 GetNodeId(UEdGraphNode const* Node) const;
+
+    // Returns INDEX_NONE for pins that are not part of the numbered graph
+    int32 GetPinId(UEdGraphPin const* Pin) const;
+
+    UEdGraphNode* GetNode(int32 Id) const {
+        return Nodes[Id];
+    }
+
+    UEdGraphPin* GetPin(int32 Id) const {
+        return Pins[Id];
+    }
+
+    int32 NumNodes() const {
+        return Nodes.Num();
+    }
+
+    int32 NumPins() const {
+        return Pins.Num();
+    }
+
+private:
+    TArray<UEdGraphNode*>             Nodes;
+    TArray<UEdGraphPin*>              Pins;
+    TArray<int32>                     FirstPins;        // By node id, plus the end of the last node
+    uint32                            FirstObject = 0;  // Lowest object index of the nodes
+    TArray<int32>                     ObjectToNode;     // Node ids by object index - FirstObject
+    TMap<UEdGraphNode const*, int32>  SparseNodeIds;    // Used instead when the object indices are too far apart
+
+    // Resumable build state, nodes are not read once numbered
+    TWeakObjectPtr<UEdGraph>          BuildGraph;
+    int32                             BuildNodes = 0;   // Nodes of the graph when the build started
+    int32                             BuildCursor = 0;  // Next node of the graph to number
+    TArray<uint32>                    ObjectIds;        // Object index of the nodes, by node id
+    uint32                            MinObject = 0;
+    uint32                            MaxObject = 0;
+};
+
+
+/*! Visited pins of a single lookup, indexed by pin id
+ *
+ * Pins outside of the numbered graph (macros, collapsed graphs) are tracked on the side,
+ * they are still visited once.
+ */
+struct FGKVisitedPins {
+    FGKVisitedPins(FGKGraphNumbering const& Numbering);
+
+    // Returns true if the pin was already visited, marks it as visited otherwise
+    bool Mark(UEdGraphPin const* Pin);
+
+private:
+    FGKGraphNumbering const&          Numbering;
+    TBitArray<TInlineAllocator<16>>   Bits;
+    TSet<UEdGraphPin const*>          External;
+};
@@ -4,10 +4,22 @@
 #include "GKEdGraphTransform.h"
 
 // Gamekit
+#include "GKClassDefaults.h"
 #include "GKEdGraphDebug.h"
+#include "GKEdGraphLiterals.h"
+#include "GKEdGraphTypes.h"
 #include "GKEdGraphUtils.h"
+#include "GKFunctionCache.h"
+#include "GKScriptStats.h"
 
 // Unreal Engine
+#include "Async/ParallelFor.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/InheritableComponentHandler.h"
+#include "Engine/SCS_Node.h"
+#include "Engine/SimpleConstructionScript.h"
+#include "HAL/IConsoleManager.h"
+#include "Hash/CityHash.h"
 #include "Misc/Paths.h"
 #include "InputAction.h"
 
@@ -15,6 +27,59 @@
 #include <cstdio>
 
 
+namespace {
+
+TAutoConsoleVariable<bool> CVarGKScriptVerifyParallelRoots(
+    TEXT("GKScript.VerifyParallelRoots"),
+    false,
+    TEXT("Emit graphs emitted in parallel a second time serially and check both are identical"),
+    ECVF_Default
+);
+
+// Name of the function or event a root defines
+FName GetDefinedFunctionName(UK2Node* Node) {
+    if (UK2Node_Event* Event = Cast<UK2Node_Event>(Node)) {
+        return Event->GetFunctionName();
+    }
+
+    UK2Node_FunctionTerminator* Terminator = Cast<UK2Node_FunctionTerminator>(Node);
+    if (Terminator == nullptr) {
+        return NAME_None;
+    }
+
+    UK2Node_FunctionEntry* Entry = Cast<UK2Node_FunctionEntry>(Terminator);
+    if (Entry && Entry->CustomGeneratedFunctionName != NAME_None) {
+        return Entry->CustomGeneratedFunctionName;
+    }
+    return Terminator->FunctionReference.GetMemberName();
+}
+
+int32 FindComponent(TArray<int32>& Parents, int32 Id) {
+    while (Parents[Id] != Id) {
+        Parents[Id] = Parents[Parents[Id]];
+        Id = Parents[Id];
+    }
+    return Id;
+}
+
+// Template an inherited component override applies to: the closest override in the parents,
+// else the component of the Blueprint that added it
+UActorComponent* GetInheritedTemplate(UBlueprint* Blueprint, FComponentKey const& Key) {
+    for (UBlueprintGeneratedClass* Parent = Cast<UBlueprintGeneratedClass>(Blueprint->ParentClass);
+         Parent != nullptr;
+         Parent = Cast<UBlueprintGeneratedClass>(Parent->GetSuperClass())) {
+        if (Parent->InheritableComponentHandler == nullptr) {
+            continue;
+        }
+        if (UActorComponent* Override = Parent->InheritableComponentHandler->GetOverridenComponentTemplate(Key)) {
+            return Override;
+        }
+    }
+    return Key.GetOriginalTemplate();
+}
+
+} // namespace
+
 
 void GetThenPins(UEdGraphNode* Node, TArray<UEdGraphPin*> ExecOut) {
     ExecOut.Reset();
@@ -35,6 +100,7 @@ void GetThenPins(UEdGraphNode* Node, TArray<UEdGraphPin*> ExecOut) {
 FGKCodeWriter::FGKCodeWriter(): FilePointer(nullptr) {}
 
 void FGKCodeWriter::OpenFile(FString Folder, FString ScriptName) {
+    GKSCRIPT_SCOPE(STAT_GKScript_Write);
     FString ContentDir = FPaths::ProjectContentDir();
     FString FolderPath = FPaths::Combine(ContentDir, Folder);
     FString FilePath = FPaths::Combine(FolderPath, ScriptName + ".us");
@@ -61,17 +127,41 @@ void FGKCodeWriter::OpenFile(FString Folder, FString ScriptName) {
 
     if (FilePointer) {
         GKSCRIPT_VERBOSE(TEXT(" - %s"), *FPaths::ConvertRelativePathToFull(FilePath));
+        Buffer = &FileBytes;
     }
 }
 
+void FGKCodeWriter::OpenBuffer(TArray<ANSICHAR>& Bytes) {
+    Close();
+    Buffer = &Bytes;
+}
+
 void FGKCodeWriter::Close() {
-    if (FilePointer) {
-        fclose((FILE*)FilePointer);
+    Buffer = nullptr;
+
+    if (FilePointer == nullptr) {
+        return;
     }
+
+    // Files are written at once, one write scope per file
+    GKSCRIPT_SCOPE(STAT_GKScript_Write);
+    fwrite(FileBytes.GetData(), sizeof(ANSICHAR), FileBytes.Num(), (FILE*)FilePointer);
+    fclose((FILE*)FilePointer);
+
+    FilePointer = nullptr;
+    FileBytes.Reset();
 }
 
 void FGKCodeWriter::Write(const char* Bytes) {
-    fprintf((FILE*)FilePointer, "%s", Bytes);
+    if (Buffer) {
+        Buffer->Append(Bytes, FCStringAnsi::Strlen(Bytes));
+    }
+}
+
+void FGKCodeWriter::Write(TArray<ANSICHAR> const& Bytes) {
+    if (Buffer) {
+        Buffer->Append(Bytes);
+    }
 }
 
 FGKCodeWriter::~FGKCodeWriter() {
@@ -99,44 +189,20 @@ struct FGKScopeGuard {
         Transform.Context.Add(FGKGenContext());
     }
 
+    // The scope stays open for the nodes the sliced traversal queued in it
     ~FGKScopeGuard() {
-        Transform.Context.Pop();
+        FGKEdGraphTransform& Owner = Transform;
+        Transform.Defer([&Owner]() { Owner.Context.Pop(); });
     }
 
     FGKEdGraphTransform& Transform;
 };
 
-FString ToPythonValidValue(FString Value) {
-    static TMap<FString, FString> Map = {
-        {TEXT("true"), TEXT("True")},
-        {TEXT("false"), TEXT("False")}
-    };
-
-    FString* Result = Map.Find(Value.ToLower());
-
-    if (Result != nullptr) {
-        return Result[0];
-    }
-
-    return Value;
+FString const& GetType(FEdGraphPinType const& PinType) {
+    return FGKPinTypeNames::Get().GetName(PinType);
 }
 
-FString GetType(FEdGraphPinType& PinType) {
-    UObject* Object = PinType.PinSubCategoryObject.Get();
-
-    if (Object) {
-        // The actual object of the CDO ?
-        return Object->GetName();
-    }
-    else {
-        // PinCategory: struct, object, bool
-        return PinType.PinCategory.ToString();
-    }
-
-    return TEXT("Type");
-}
-
-FString GetType(UEdGraphPin* Pin) {
+FString const& GetType(UEdGraphPin* Pin) {
     return GetType(Pin->PinType);
 }
 
@@ -168,23 +234,73 @@ FGKEdGraphTransform::FGKEdGraphTransform(class UBlueprint* Source, FString Folde
     WRITELINE("import unreal");
 }
 
+FGKEdGraphTransform::FGKEdGraphTransform(class UBlueprint* Source, TArray<ANSICHAR>& Output):
+    Source(Source)
+{
+    Writer.OpenBuffer(Output);
+    IndentationLevel = 0;
+    Context.Add(FGKGenContext());
+}
+
+FGKEdGraphTransform::FGKEdGraphTransform(FGKEdGraphTransform const& Parent, TArray<ANSICHAR>& Output):
+    bShowTypeName(Parent.bShowTypeName),
+    bDebugTypes(Parent.bDebugTypes),
+    bParallelRoots(false),
+    Snapshots(Parent.Snapshots),
+    Source(Parent.Source),
+    Context(Parent.Context),
+    IndentationLevel(Parent.IndentationLevel)
+{
+    Writer.OpenBuffer(Output);
+}
+
 
-FString FGKEdGraphTransform::GenerateCallArgument(FString const& Name, FString const& Type, FString const& Value) {
+FStringView FGKEdGraphTransform::GenerateCallArgument(FStringView Name, FString const& Type, FStringView Value) {
+    TStringBuilder<256> Builder;
+    Builder << Name;
     if (bDebugTypes){
-        return FString::Printf(TEXT("%s: %s = %s"), *Name, *Type, *Value);
+        Builder << TEXT(": ") << Type;
     }
-    return FString::Printf(TEXT("%s = %s"), *Name, *Value);
+    Builder << TEXT(" = ") << Value;
+    return Arena.Copy(Builder.ToView());
 }
 
-FString FGKEdGraphTransform::GenerateReturnVariable(FString const& Name, FString const& Type) {
+FStringView FGKEdGraphTransform::GenerateReturnVariable(FStringView Name, FString const& Type) {
     if (bDebugTypes) {
-        return FString::Printf(TEXT("%s: %s"), *Name, *Type);
+        TStringBuilder<256> Builder;
+        Builder << Name << TEXT(": ") << Type;
+        return Arena.Copy(Builder.ToView());
     }
     return Name;
 }
 
 void FGKEdGraphTransform::Generate() {
+    GKSCRIPT_SCOPE(STAT_GKScript_Generate);
+    BeginClass();
+    GenerateDefaults();
+
+    for (UEdGraph* Graph : Source->FunctionGraphs) {
+        GenerateGraph(Graph);
+    }
+
+    // This is generated trash, jsut calls the Ubergraph
+    /*
+    for (UEdGraph* Graph : Source->EventGraphs) {
+        TArray<UK2Node*> Roots = FindRoots(Graph);
+        for (UK2Node* Root : Roots) {
+            Exec(Root);
+        }
+    }
+    //*/
+
+    for (UEdGraph* Graph : Source->UbergraphPages) {
+        GenerateGraph(Graph);
+    }
 
+    EndClass();
+}
+
+void FGKEdGraphTransform::BeginClass() {
     Context.Add(FGKGenContext());
 
     // Godot Like
@@ -203,50 +319,556 @@ void FGKEdGraphTransform::Generate() {
     WRITELINE("");
     WRITELINE("");
 #else
-    // Python like
-    WRITELINE("class %s(%s):", *Source->GetName(), *Source->ParentClass->GetName());
-    INDENT();
+    // Python like, Blueprint parents are imported from their own script
+    FString ParentName = Source->ParentClass->GetName();
+    if (UBlueprint* ParentBlueprint = UBlueprint::GetBlueprintFromClass(Source->ParentClass)) {
+        ParentName = ParentBlueprint->GetName();
+        WRITELINE("from %s import %s", *ParentName, *ParentName);
+        WRITELINE("");
+    }
+
+    WRITELINE("class %s(%s):", *Source->GetName(), *ParentName);
+
+    // Class body, closed by EndClass
+    IndentationLevel += 1;
     WRITELINE(DOCSTRING "%s" DOCSTRING, *FormatDocstring(Source->BlueprintDescription));
     WRITELINE("");
+#endif
+}
+
+void FGKEdGraphTransform::EndClass() {
+#if 0
+#else
+    IndentationLevel -= 1;
+#endif
+}
+
+bool FGKEdGraphTransform::GenerateSlice(double EndTime) {
+    GKSCRIPT_SCOPE(STAT_GKScript_Generate);
+
+    // One step at a time, the deadline is checked after each of them
+    while (SliceStep != EGKSliceStep::Done) {
+        switch (SliceStep) {
+        case EGKSliceStep::Class:
+            BeginClass();
+            SliceGraphs.Append(Source->FunctionGraphs);
+            SliceGraphs.Append(Source->UbergraphPages);
+            SliceStep = EGKSliceStep::Defaults;
+            break;
+
+        case EGKSliceStep::Defaults:
+            GenerateDefaults();
+            SliceStep = EGKSliceStep::Graphs;
+            break;
+
+        default:
+            if (SliceGraph < SliceGraphs.Num()) {
+                if (!GenerateGraphSlice(SliceGraphs[SliceGraph].Get(), EndTime)) {
+                    return false;
+                }
+                SliceGraph += 1;
+                break;
+            }
+
+            EndClass();
+            Writer.Close();
+            SliceStep = EGKSliceStep::Done;
+            return true;
+        }
+
+        if (FPlatformTime::Seconds() >= EndTime) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FGKEdGraphTransform::GenerateDefaults() {
+    UClass* Class = Source->GeneratedClass;
+    UObject* Defaults = Class ? Class->GetDefaultObject() : nullptr;
+
+    // Only values that differ from the type default are written
     for (FBPVariableDescription& Variable : Source->NewVariables) {
+        FProperty* Property = Defaults ? FindFProperty<FProperty>(Class, Variable.VarName) : nullptr;
+
+        if (Property && FGKClassDefaults::IsDefault(Property, Defaults)) {
+            WRITELINE("%s: %s", *Variable.VarName.ToString(), *GetType(Variable.VarType));
+            continue;
+        }
+
         WRITELINE("%s: %s = DefaultSubObject(%s)",
             *Variable.VarName.ToString(),
             *GetType(Variable.VarType),
-            *Variable.DefaultValue
+            Property ? *FGKClassDefaults::Export(Property, Defaults) : *Variable.DefaultValue
         );
     }
+
+    if (Defaults == nullptr) {
+        WRITELINE("");
+        return;
+    }
+
+    // Inherited values the Blueprint overrides
+    TArray<FGKPropertyDelta> Deltas;
+    FGKClassDefaults::Get().Diff(Defaults, Defaults->GetArchetype(), Deltas);
+
+    for (FGKPropertyDelta const& Delta : Deltas) {
+        WRITELINE("%s = %s", *Delta.Property->GetName(), *Delta.Value);
+    }
+
+    // Native components, against the same component of the parent defaults
+    TArray<FGKSubobjectDelta> Subobjects;
+    FGKClassDefaults::Get().DiffSubobjects(Defaults, Defaults->GetArchetype(), Subobjects);
+
+    for (FGKSubobjectDelta const& Subobject : Subobjects) {
+        for (FGKPropertyDelta const& Delta : Subobject.Deltas) {
+            WRITELINE("%s.%s = %s", *Subobject.Path, *Delta.Property->GetName(), *Delta.Value);
+        }
+    }
+
+    // Components of the parent Blueprints, every node of their construction script can be overridden
+    if (UInheritableComponentHandler* Handler = Source->GetInheritableComponentHandler(false)) {
+        for (auto Record = Handler->CreateRecordIterator(); Record; ++Record) {
+            UActorComponent* Template = Record->ComponentTemplate;
+            if (Template == nullptr || !Record->ComponentKey.IsSCSKey()) {
+                continue;
+            }
+
+            FString Name = Record->ComponentKey.GetSCSVariableName().ToString();
+
+            TArray<FGKPropertyDelta> Deltas;
+            FGKClassDefaults::Get().Diff(Template, GetInheritedTemplate(Source, Record->ComponentKey), Deltas);
+
+            for (FGKPropertyDelta const& Delta : Deltas) {
+                WRITELINE("%s.%s = %s", *Name, *Delta.Property->GetName(), *Delta.Value);
+            }
+        }
+    }
+
+    if (Source->SimpleConstructionScript) {
+        for (USCS_Node* Root : Source->SimpleConstructionScript->GetRootNodes()) {
+            GenerateComponent(Root, Root->ParentComponentOrVariableName);
+        }
+    }
     WRITELINE("");
-#endif
+}
 
-    TArray<UEdGraph*> Graphs;
-    Source->GetAllGraphs(Graphs);
+void FGKEdGraphTransform::GenerateComponent(USCS_Node* Node, FName Parent) {
+    UActorComponent* Template = Node->ComponentTemplate;
+    if (Template == nullptr) {
+        return;
+    }
 
+    FString Name = Node->GetVariableName().ToString();
 
-    for (UEdGraph* Graph : Source->FunctionGraphs) {
-        TArray<UK2Node*> Roots = FindRoots(Graph);
-        for (UK2Node* Root : Roots) {
-            Exec(Root);
+    if (Parent.IsNone()) {
+        WRITELINE("%s: %s = Component()", *Name, *Template->GetClass()->GetName());
+    } else {
+        WRITELINE("%s: %s = Component(%s)", *Name, *Template->GetClass()->GetName(), *Parent.ToString());
+    }
+
+    // Against the defaults of the component class
+    TArray<FGKPropertyDelta> Deltas;
+    FGKClassDefaults::Get().Diff(Template, Template->GetArchetype(), Deltas);
+
+    for (FGKPropertyDelta const& Delta : Deltas) {
+        WRITELINE("%s.%s = %s", *Name, *Delta.Property->GetName(), *Delta.Value);
+    }
+
+    for (USCS_Node* Child : Node->GetChildNodes()) {
+        GenerateComponent(Child, Node->GetVariableName());
+    }
+}
+
+uint64 FGKEdGraphTransform::GetGraphKey(UEdGraph* Graph) const {
+    FGKGraphHasher Hasher;
+    BeginGraphKey(Graph, Hasher);
+    Hasher.Slice(MAX_dbl);
+    return Hasher.GetHash();
+}
+
+void FGKEdGraphTransform::BeginGraphKey(UEdGraph* Graph, FGKGraphHasher& Hasher) const {
+    uint64 Seed = (uint64(bShowTypeName) << 40) | (uint64(bDebugTypes) << 32) | uint32(IndentationLevel);
+
+    // Variable names are picked against the names already taken in the scope
+    if (Context.Num() > 0) {
+        TArray<FString> Taken = Context.Last().Variables.Array();
+        Taken.Sort();
+
+        FString Names = FString::Join(Taken, TEXT("\n"));
+        Seed = CityHash128to64({Seed, CityHash64((const char*)*Names, Names.Len() * sizeof(TCHAR))});
+    }
+
+    Hasher.Begin(Graph, [this, Seed](UEdGraphNode* Node) -> uint64 {
+        UK2Node* Root = Cast<UK2Node>(Node);
+        bool bFunction = Node->IsA<UK2Node_FunctionEntry>() || Node->IsA<UK2Node_Event>();
+
+        if (!bFunction && !Node->IsA<UK2Node_EnhancedInputAction>()) {
+            return Seed;
+        }
+
+        // Roots write their docstring, the same graph in another Blueprint can be an override or not
+        FString Docstring = GetNodeDocstring(Root);
+        if (bFunction) {
+            Docstring = GetDefinedFunctionName(Root).ToString() + (IsOverride(Root) ? TEXT("\n@override\n") : TEXT("\n")) + Docstring;
+        }
+        return CityHash128to64({Seed, CityHash64((const char*)*Docstring, Docstring.Len() * sizeof(TCHAR))});
+    });
+}
+
+bool FGKEdGraphTransform::GenerateGraphSlice(UEdGraph* Graph, double EndTime) {
+    // Deleted between two slices, what was emitted is kept but not cached
+    if (Graph == nullptr) {
+        if (GraphSliceStep == EGKGraphSliceStep::Exec) {
+            AbortSlice();
         }
+        EndCachedGraph(false);
+        GraphSliceStep = EGKGraphSliceStep::Begin;
+        return true;
     }
 
-    // This is generated trash, jsut calls the Ubergraph
-    /*
-    for (UEdGraph* Graph : Source->EventGraphs) {
-        TArray<UK2Node*> Roots = FindRoots(Graph);
+    while (true) {
+        switch (GraphSliceStep) {
+        case EGKGraphSliceStep::Begin:
+            if (bFunctionCache) {
+                BeginGraphKey(Graph, GraphHasher);
+                GraphSliceStep = EGKGraphSliceStep::Key;
+                break;
+            }
+            BeginSlicedGraph(Graph);
+            GraphSliceStep = EGKGraphSliceStep::Exec;
+            break;
+
+        case EGKGraphSliceStep::Key:
+            if (!GraphHasher.Slice(EndTime)) {
+                return false;
+            }
+            GraphSliceStep = EGKGraphSliceStep::Cache;
+            break;
+
+        case EGKGraphSliceStep::Cache:
+            // Cached graphs are written at once
+            if (BeginCachedGraph(Graph, GraphHasher.GetHash())) {
+                GraphSliceStep = EGKGraphSliceStep::Begin;
+                return true;
+            }
+            BeginSlicedGraph(Graph);
+            GraphSliceStep = EGKGraphSliceStep::Exec;
+            break;
+
+        default:
+            if (!ExecSlice(EndTime)) {
+                return false;
+            }
+
+            EndCachedGraph(!bStaleNodes);
+            GraphSliceStep = EGKGraphSliceStep::Begin;
+            return true;
+        }
+
+        if (FPlatformTime::Seconds() >= EndTime) {
+            return false;
+        }
+    }
+}
+
+void FGKEdGraphTransform::GenerateGraph(UEdGraph* Graph) {
+    if (BeginCachedGraph(Graph)) {
+        return;
+    }
+
+    EmitGraph(Graph);
+    EndCachedGraph();
+}
+
+bool FGKEdGraphTransform::BeginCachedGraph(UEdGraph* Graph) {
+    if (!bFunctionCache) {
+        return false;
+    }
+
+    return BeginCachedGraph(Graph, GetGraphKey(Graph));
+}
+
+bool FGKEdGraphTransform::BeginCachedGraph(UEdGraph* Graph, uint64 Key) {
+    FGKFunctionCacheEntry Entry;
+    if (FGKFunctionCache::Get().Load(Key, Entry)) {
+        GKSCRIPT_VERBOSE(TEXT("%s: reused %016llx"), *Graph->GetName(), Key);
+        INC_DWORD_STAT(STAT_GKScript_FunctionCacheHits);
+
+        Writer.Write(Entry.Text);
+
+        // Names the graph took, later graphs pick theirs against them
+        if (Context.Num() > 0) {
+            Context.Last().Variables.Append(Entry.Variables);
+        }
+        return true;
+    }
+
+    INC_DWORD_STAT(STAT_GKScript_FunctionCacheMisses);
+
+    PendingGraph = MakeUnique<FGKPendingGraph>();
+    PendingGraph->Key = Key;
+    PendingGraph->Buffer = Writer.Buffer;
+    if (Context.Num() > 0) {
+        PendingGraph->Variables = Context.Last().Variables;
+    }
+
+    Writer.Buffer = &PendingGraph->Entry.Text;
+    return false;
+}
+
+void FGKEdGraphTransform::EndCachedGraph(bool bStore) {
+    if (!PendingGraph.IsValid()) {
+        return;
+    }
+
+    TUniquePtr<FGKPendingGraph> Pending = MoveTemp(PendingGraph);
+    Writer.Buffer = Pending->Buffer;
+
+    if (!bStore) {
+        Writer.Write(Pending->Entry.Text);
+        return;
+    }
+
+    FGKFunctionCacheEntry& Entry = Pending->Entry;
+
+    // Names taken by the graph, replayed when the entry is reused
+    if (Context.Num() > 0) {
+        for (FString const& Name : Context.Last().Variables) {
+            if (!Pending->Variables.Contains(Name)) {
+                Entry.Variables.Add(Name);
+            }
+        }
+    }
+
+    FGKFunctionCache::Get().Store(Pending->Key, Entry);
+    Writer.Write(Entry.Text);
+}
+
+void FGKEdGraphTransform::EmitGraph(UEdGraph* Graph) {
+    GKSCRIPT_SCOPE(STAT_GKScript_EmitGraph);
+    BeginGraph(Graph);
+    TArray<UK2Node*> Roots = FindRoots(Graph);
+
+    TBitArray<> Forked;
+    if (bParallelRoots && Roots.Num() >= ParallelRootThreshold) {
+        Forked = FindIndependentRoots(Roots);
+    }
+
+    if (Forked.CountSetBits() < ParallelRootThreshold) {
         for (UK2Node* Root : Roots) {
             Exec(Root);
         }
+        return;
     }
-    //*/
 
-    for (UEdGraph* Graph : Source->UbergraphPages) {
-        TArray<UK2Node*> Roots = FindRoots(Graph);
+    // Serial reference, from the same state
+    TArray<ANSICHAR> Expected;
+    bool bVerify = CVarGKScriptVerifyParallelRoots.GetValueOnAnyThread();
+
+    if (bVerify) {
+        FGKEdGraphTransform Serial(*this, Expected);
+        Serial.BeginGraph(*Numbering);
+
         for (UK2Node* Root : Roots) {
-            Exec(Root);
+            Serial.Exec(Root);
+        }
+    }
+
+    // Forks only read the UObjects through the snapshot
+    TArray<FGKNodeSnapshot> NodeSnapshots;
+    TakeSnapshots(NodeSnapshots);
+
+    TArray<int32> ForkedRoots;
+    for (TConstSetBitIterator<> It(Forked); It; ++It) {
+        ForkedRoots.Add(It.GetIndex());
+    }
+
+    // Forked roots do not share any state with the other roots, each one is emitted
+    // in its own buffer and the buffers are merged back in the original order
+    TArray<TArray<ANSICHAR>> Outputs;
+    Outputs.SetNum(Roots.Num());
+
+    Snapshots = &NodeSnapshots;
+    ParallelFor(ForkedRoots.Num(), [&](int32 i) {
+        int32 Root = ForkedRoots[i];
+
+        FGKEdGraphTransform Worker(*this, Outputs[Root]);
+        Worker.BeginGraph(*Numbering);
+        Worker.Exec(Roots[Root]);
+    });
+    Snapshots = nullptr;
+
+    // The other roots share nodes, they are emitted in order on this thread
+    TArray<ANSICHAR>* Buffer = Writer.Buffer;
+    for (int32 i = 0; i < Roots.Num(); i++) {
+        if (!Forked[i]) {
+            Writer.Buffer = &Outputs[i];
+            Exec(Roots[i]);
+        }
+    }
+    Writer.Buffer = Buffer;
+
+    if (bVerify) {
+        TArray<ANSICHAR> Merged;
+        for (TArray<ANSICHAR> const& Output : Outputs) {
+            Merged.Append(Output);
+        }
+
+        if (Merged != Expected) {
+            GKSCRIPT_ERROR(TEXT("%s: parallel output differs from the serial output, the serial output is kept"), *Graph->GetName());
+            Writer.Write(Expected);
+            return;
         }
+        GKSCRIPT_VERBOSE(TEXT("%s: parallel output verified (%d roots)"), *Graph->GetName(), ForkedRoots.Num());
+    }
+
+    for (TArray<ANSICHAR> const& Output : Outputs) {
+        Writer.Write(Output);
     }
 }
 
+TBitArray<> FGKEdGraphTransform::FindIndependentRoots(TArray<UK2Node*> const& Roots) {
+    int32 NumNodes = Numbering->NumNodes();
+
+    // Connected components of the graph, through every link
+    TArray<int32> Parents;
+    Parents.SetNumUninitialized(NumNodes);
+    for (int32 Id = 0; Id < NumNodes; Id++) {
+        Parents[Id] = Id;
+    }
+
+    // Components linked to nodes outside of the graph are never forked
+    TBitArray<> Outside(false, NumNodes);
+
+    for (int32 Id = 0; Id < NumNodes; Id++) {
+        for (UEdGraphPin* Pin : Numbering->GetNode(Id)->Pins) {
+            for (UEdGraphPin* Link : Pin->LinkedTo) {
+                int32 Other = Numbering->GetNodeId(Link->GetOwningNodeUnchecked());
+
+                if (Other == INDEX_NONE) {
+                    Outside[Id] = true;
+                    continue;
+                }
+                Parents[FindComponent(Parents, Other)] = FindComponent(Parents, Id);
+            }
+        }
+    }
+
+    TBitArray<> OutsideComponents(false, NumNodes);
+    for (TConstSetBitIterator<> It(Outside); It; ++It) {
+        OutsideComponents[FindComponent(Parents, It.GetIndex())] = true;
+    }
+
+    TArray<int32> RootComponents;
+    TArray<int32> RootsPerComponent;
+    RootsPerComponent.Init(0, NumNodes);
+
+    for (UK2Node* Root : Roots) {
+        int32 Id = Numbering->GetNodeId(Root);
+        int32 Component = Id != INDEX_NONE ? FindComponent(Parents, Id) : INDEX_NONE;
+
+        RootComponents.Add(Component);
+        if (Component != INDEX_NONE) {
+            RootsPerComponent[Component] += 1;
+        }
+    }
+
+    TBitArray<> Independent(false, Roots.Num());
+    for (int32 i = 0; i < Roots.Num(); i++) {
+        int32 Component = RootComponents[i];
+        if (Component == INDEX_NONE || RootsPerComponent[Component] != 1 || OutsideComponents[Component]) {
+            continue;
+        }
+
+        // Roots without their own scope add their variables to the class scope
+        NodeKind Kind = ClassNodeTypeMapping(Roots[i]);
+        Independent[i] = Kind == NodeKind::Event || Kind == NodeKind::FunctionEntry;
+    }
+    return Independent;
+}
+
+void FGKEdGraphTransform::TakeSnapshots(TArray<FGKNodeSnapshot>& NodeSnapshots) {
+    NodeSnapshots.SetNum(Numbering->NumNodes());
+
+    for (int32 Id = 0; Id < Numbering->NumNodes(); Id++) {
+        UK2Node* Node = Cast<UK2Node>(Numbering->GetNode(Id));
+        if (Node == nullptr) {
+            continue;
+        }
+
+        FGKNodeSnapshot& Snapshot = NodeSnapshots[Id];
+
+        switch (ClassNodeTypeMapping(Node)) {
+        case NodeKind::Event:
+        case NodeKind::FunctionEntry:
+        case NodeKind::FunctionTerminator:
+            Snapshot.bOverride = IsOverride(Node);
+            Snapshot.Docstring = GetNodeDocstring(Node);
+            break;
+
+        case NodeKind::EnhancedInputAction:
+            Snapshot.Docstring = GetNodeDocstring(Node);
+            break;
+
+        case NodeKind::CallFunction:
+            Snapshot.FunctionName = GetFunctionName(CastChecked<UK2Node_CallFunction>(Node));
+            break;
+
+        case NodeKind::MacroInstance:
+            Snapshot.MacroGraph = GetMacroGraph(CastChecked<UK2Node_MacroInstance>(Node));
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+FGKNodeSnapshot const* FGKEdGraphTransform::FindSnapshot(UEdGraphNode* Node) const {
+    if (Snapshots == nullptr) {
+        return nullptr;
+    }
+
+    int32 Id = Numbering->GetNodeId(Node);
+    return Id != INDEX_NONE ? &(*Snapshots)[Id] : nullptr;
+}
+
+FString FGKEdGraphTransform::GetNodeDocstring(UK2Node* Node) const {
+    if (FGKNodeSnapshot const* Snapshot = FindSnapshot(Node)) {
+        return Snapshot->Docstring;
+    }
+
+    // Functions are documented by their metadata
+    if (UK2Node_FunctionEntry* Entry = Cast<UK2Node_FunctionEntry>(Node)) {
+        return Entry->MetaData.ToolTip.ToString();
+    }
+    return Node->GetTooltipText().ToString();
+}
+
+FName FGKEdGraphTransform::GetFunctionName(UK2Node_CallFunction* Node) const {
+    if (FGKNodeSnapshot const* Snapshot = FindSnapshot(Node)) {
+        return Snapshot->FunctionName;
+    }
+    return Node->GetFunctionName();
+}
+
+UEdGraph* FGKEdGraphTransform::GetMacroGraph(UK2Node_MacroInstance* Node) const {
+    if (FGKNodeSnapshot const* Snapshot = FindSnapshot(Node)) {
+        return Snapshot->MacroGraph;
+    }
+    return Node->GetMacroGraph();
+}
+
+bool FGKEdGraphTransform::IsOverride(UK2Node* Node) const {
+    if (FGKNodeSnapshot const* Snapshot = FindSnapshot(Node)) {
+        return Snapshot->bOverride;
+    }
+
+    UClass* ParentClass = Source ? Source->ParentClass : nullptr;
+    return ParentClass && ParentClass->FindFunctionByName(GetDefinedFunctionName(Node)) != nullptr;
+}
+
 
 FString FGKEdGraphTransform::Indentation() const {
     return FString::ChrN(IndentationLevel * 2, ' ');
@@ -268,45 +890,60 @@ void FGKEdGraphTransform::MacroInstance(UK2Node_MacroInstance* Node) {}
 
 
 
-FString FGKEdGraphTransform::MakeVariable(UEdGraphPin* Pin) {
+FStringView FGKEdGraphTransform::MakeVariable(UEdGraphPin* Pin) {
     return ResolveOutputPin(Pin);
 }
 
-FString FGKEdGraphTransform::GetVariable(UEdGraphPin* Pin) {
+FStringView FGKEdGraphTransform::GetVariable(UEdGraphPin* Pin) {
     return ResolveInputPin(Pin);
 }
 
 
-FString GetValue(UEdGraphPin* Pin) {
+void GetValue(UEdGraphPin* Pin, FStringBuilderBase& Value) {
     if (Pin->PinName == FName("WorldContextObject")) {
-        return "GetWorld()";
+        Value << TEXT("GetWorld()");
+        return;
     }
 
-    if (!Pin->DefaultValue.IsEmpty()) {
-        if (Pin->DefaultValue.Contains(",")) {
-            return FString::Printf(TEXT("(%s)"), *Pin->DefaultValue); 
-        }
-        return ToPythonValidValue(Pin->DefaultValue);
-    }
+    FGKLiteral::FromPin(Pin).AppendTo(Value);
+}
 
-    if (Pin->DefaultObject) {
-        FString ClassName = Pin->DefaultObject->GetClass()->GetName();
-        if (UBlueprintFunctionLibrary* Lib = Cast<UBlueprintFunctionLibrary>(Pin->DefaultObject)) {
-            return ClassName;
-        }
-        return ClassName + "(\"" + Pin->DefaultObject->GetPathName() + "\")";
-    }
 
-    if (!Pin->DefaultTextValue.IsEmpty()) {
-        return FString::Printf(TEXT("\"%s\""), *Pin->DefaultTextValue.ToString());
+void FGKEdGraphTransform::ResetTraversal() {
+    Super::ResetTraversal();
+
+    // Nothing else points into the arena once the variables are gone
+    PinToVariable.Init(FStringView(), Numbering->NumPins());
+    ExternalVariables.Reset();
+    Arena.Reset();
+}
+
+FStringView* FGKEdGraphTransform::FindVariable(UEdGraphPin* Pin) {
+    int32 Id = Numbering->GetPinId(Pin);
+    if (Id == INDEX_NONE) {
+        return ExternalVariables.Find(Pin);
     }
 
-    return FString();
+    if (PinToVariable[Id].IsEmpty()) {
+        return nullptr;
+    }
+    return &PinToVariable[Id];
 }
 
+void FGKEdGraphTransform::SetVariable(UEdGraphPin* Pin, FStringView Name) {
+    int32 Id = Numbering->GetPinId(Pin);
+
+    // Pins of macros and collapsed graphs
+    if (Id == INDEX_NONE) {
+        ExternalVariables.Add(Pin, Name);
+        return;
+    }
+    PinToVariable[Id] = Name;
+}
 
 TArray<FString> FGKEdGraphTransform::FindAllNames(UEdGraphPin* EndPin) {
-    TSet<UEdGraphPin*> Visited;
+    GKSCRIPT_SCOPE(STAT_GKScript_Naming);
+    FGKVisitedPins Visited(*Numbering);
     TSet<FString> Names;
 
     _FindAllNames(EndPin, Visited, Names);
@@ -314,12 +951,11 @@ TArray<FString> FGKEdGraphTransform::FindAllNames(UEdGraphPin* EndPin) {
     return Names.Array();
 }
 
-void FGKEdGraphTransform::_FindAllNames(UEdGraphPin* EndPin, TSet<UEdGraphPin*>& Visited, TSet<FString>& Names) {
-    bool bAlreadyIn = false;
-    Visited.Add(EndPin, &bAlreadyIn);
-    if (bAlreadyIn) {
+void FGKEdGraphTransform::_FindAllNames(UEdGraphPin* EndPin, FGKVisitedPins& Visited, TSet<FString>& Names) {
+    if (Visited.Mark(EndPin)) {
         return;
     }
+
     static TSet<FString> Forbidden = {
         TEXT("OutputPin"),
         TEXT("InputPin"),
@@ -347,8 +983,8 @@ void FGKEdGraphTransform::_FindAllNames(UEdGraphPin* EndPin, TSet<UEdGraphPin*>&
     }
 }
 
-FString FGKEdGraphTransform::ResolveOutputPin(UEdGraphPin* EndPin) {
-    FString* Result = PinToVariable.Find(EndPin);
+FStringView FGKEdGraphTransform::ResolveOutputPin(UEdGraphPin* EndPin) {
+    FStringView* Result = FindVariable(EndPin);
     if (Result) {
         return Result[0];
     }
@@ -384,27 +1020,37 @@ FString FGKEdGraphTransform::ResolveOutputPin(UEdGraphPin* EndPin) {
     }
 
     CurrentContext.Variables.Add(SelectedName);
-    PinToVariable.Add(EndPin, SelectedName);
-    return GenerateReturnVariable(*SelectedName, *GetType(EndPin));
+
+    FStringView Variable = Arena.Copy(SelectedName);
+    SetVariable(EndPin, Variable);
+    return GenerateReturnVariable(Variable, GetType(EndPin));
 }
 
 
 
 FGKResolvedPin FGKEdGraphTransform::ResolvePin(UEdGraphPin* StartPin, EEdGraphPinDirection Direction)
 {
+    GKSCRIPT_SCOPE(STAT_GKScript_ResolvePin);
     FGKResolvedPin Result;
     Result.StartPin = StartPin;
 
     TArray<UEdGraphPin*> Pins;
-    TMap<UEdGraphPin*, UEdGraphPin*> Visited;
+    FGKVisitedPins Visited(*Numbering);
     Pins.Add(StartPin);
 
     while (Pins.Num() > 0) {
         UEdGraphPin* Pin = Pins.Pop(false);
 
+        // Re route nodes can loop on themselves
+        if (Visited.Mark(Pin)) {
+            continue;
+        }
+
         // This is only possible if the root was not linked to anything in the first place
         if (Pin->LinkedTo.Num() == 0) {
-            Result.Value = GetValue(Pin);
+            TStringBuilder<128> Value;
+            GetValue(Pin, Value);
+            Result.Value = Arena.Copy(Value.ToView());
             break;
         }
 
@@ -414,11 +1060,6 @@ FGKResolvedPin FGKEdGraphTransform::ResolvePin(UEdGraphPin* StartPin, EEdGraphPi
                 continue;
             }
 
-            UEdGraphPin** WasVisited = Visited.Find(Link);
-            if (WasVisited != nullptr) {
-                Result.EndPin = WasVisited[0];
-            }
-
             // Re route nodes
             UEdGraphNode* NextGraphNode = Link->GetOwningNode();
             if (Cast<UK2Node_Knot>(NextGraphNode)) {
@@ -435,30 +1076,30 @@ FGKResolvedPin FGKEdGraphTransform::ResolvePin(UEdGraphPin* StartPin, EEdGraphPi
             }
 
             else if (auto Self = Cast<UK2Node_Self>(NextGraphNode)) {
-                Result.Value = FString(TEXT("self"));
+                Result.Value = TEXT("self");
                 Result.EndPin = Link;
                 break;
             }
             else if (auto Variable = Cast<UK2Node_VariableGet>(NextGraphNode))
             {
-                Result.Value = "self." + Variable->GetVarNameString();
+                Result.Value = Arena.Printf(TEXT("self.%s"), *Variable->GetVarNameString());
                 Result.EndPin = Link;
                 break;
             }
             else 
             {
                 // Input is coming from a graph
-                FString* Varname = PinToVariable.Find(Pin);
+                FStringView* Varname = FindVariable(Pin);
 
                 // Graph was not traversed yet
                 if (Varname == nullptr) {
                     Exec(Cast<UK2Node>(NextGraphNode));
-                    Varname = PinToVariable.Find(Link);
+                    Varname = FindVariable(Link);
                 }
 
                 Result.EndPin = Link;
                 Result.Node = NextGraphNode;
-                Result.Value = "Missing";
+                Result.Value = TEXT("Missing");
 
                 if (Varname != nullptr){
                     Result.Value = Varname[0];
@@ -470,13 +1111,13 @@ FGKResolvedPin FGKEdGraphTransform::ResolvePin(UEdGraphPin* StartPin, EEdGraphPi
 }
 
 
-FString FGKEdGraphTransform::ResolveInputPin(UEdGraphPin* EndPin) {
+FStringView FGKEdGraphTransform::ResolveInputPin(UEdGraphPin* EndPin) {
     TArray<UEdGraphPin*> Pins;
     Pins.Add(EndPin);
     ensure(EndPin->Direction == EGPD_Input);
 
     FString ArgName = EndPin->PinName.ToString();
-    FString Type = GetType(EndPin);
+    FString const& Type = GetType(EndPin);
 
     while (Pins.Num() > 0) {
         UEdGraphPin* Pin = Pins.Pop(false);
@@ -484,11 +1125,12 @@ FString FGKEdGraphTransform::ResolveInputPin(UEdGraphPin* EndPin) {
 
         // Default Value Pin
         if (Pin->LinkedTo.Num() == 0) {
-            FString Value = GetValue(Pin);
-            if (Value.IsEmpty()) {
-                return GenerateCallArgument(ArgName, Type, FString(TEXT("MissingLink()")));
+            TStringBuilder<128> Value;
+            GetValue(Pin, Value);
+            if (Value.Len() == 0) {
+                return GenerateCallArgument(ArgName, Type, TEXT("MissingLink()"));
             }
-            return GenerateCallArgument(ArgName, Type, Value);
+            return GenerateCallArgument(ArgName, Type, Value.ToView());
         }
 
         for (UEdGraphPin* Link : Pin->LinkedTo)
@@ -496,7 +1138,7 @@ FString FGKEdGraphTransform::ResolveInputPin(UEdGraphPin* EndPin) {
             // Downstream link
             if (Link->Direction == EGPD_Output) {
 
-                FString* Result2 = PinToVariable.Find(Link);
+                FStringView* Result2 = FindVariable(Link);
                 if (Result2 != nullptr) {
                     return GenerateCallArgument(ArgName, Type, Result2[0]);
                 }
@@ -515,27 +1157,27 @@ FString FGKEdGraphTransform::ResolveInputPin(UEdGraphPin* EndPin) {
                     continue;
                 } 
                 else if (auto Self = Cast<UK2Node_Self>(NextGraphNode)) {
-                    return GenerateCallArgument(ArgName, Type, FString(TEXT("self")));
+                    return GenerateCallArgument(ArgName, Type, TEXT("self"));
                 }
                 else if (auto Variable = Cast<UK2Node_VariableGet>(NextGraphNode))
                 {
-                    return GenerateCallArgument(ArgName, Type, *Variable->GetVarNameString());
+                    return GenerateCallArgument(ArgName, Type, Variable->GetVarNameString());
                 }
                 else 
                 {
                     // We found a graph to call
-                    FString* Result = PinToVariable.Find(Pin);
+                    FStringView* Result = FindVariable(Pin);
 
                     if (Result == nullptr) {
                         // Create a Variable using the output Node
                         Exec(Cast<UK2Node>(NextGraphNode));
-                        Result = PinToVariable.Find(Link);
+                        Result = FindVariable(Link);
                     }
 
                     if (Result != nullptr) {
                         return GenerateCallArgument(ArgName, Type, Result[0]);
                     } else {
-                        return GenerateCallArgument(ArgName, Type, FString(TEXT("MissingObject()")));
+                        return GenerateCallArgument(ArgName, Type, TEXT("MissingObject()"));
                     }
                     
                 }
@@ -543,12 +1185,12 @@ FString FGKEdGraphTransform::ResolveInputPin(UEdGraphPin* EndPin) {
         }
     }
 
-    return GenerateCallArgument(ArgName, Type, FString(TEXT("?")));
+    return GenerateCallArgument(ArgName, Type, TEXT("?"));
 }
 
 
 
-void FGKEdGraphTransform::GetInputOutputs(UK2Node* Node, FGKResolvedPin& Self, TArray<FGKResolvedPin>& Inputs, TArray<FString>& Outputs) {
+void FGKEdGraphTransform::GetInputOutputs(UK2Node* Node, FGKResolvedPin& Self, TArray<FGKResolvedPin>& Inputs, FGKArenaStrings& Outputs) {
     for (UEdGraphPin* Pin : Node->Pins) {
         // Ignore execution pins
         if (Pin->PinType.PinCategory == "execute") {
@@ -571,13 +1213,13 @@ void FGKEdGraphTransform::GetInputOutputs(UK2Node* Node, FGKResolvedPin& Self, T
             Inputs.Add(Resolved);
         }
         else if (Pin->Direction == EGPD_Output) {
-            FString Name = ResolveOutputPin(Pin);
+            FStringView Name = ResolveOutputPin(Pin);
             Outputs.Add(Name);
         }
     }
 }
 
-void FGKEdGraphTransform::GetInputOutputs(UK2Node* Node, UEdGraphPin*& Self, TArray<FString>& Inputs, TArray<FString>& Outputs) {
+void FGKEdGraphTransform::GetInputOutputs(UK2Node* Node, UEdGraphPin*& Self, FGKArenaStrings& Inputs, FGKArenaStrings& Outputs) {
     for (UEdGraphPin* Pin : Node->Pins) {
         // Ignore execution pins
         if (Pin->PinType.PinCategory == "exec") {
@@ -587,24 +1229,24 @@ void FGKEdGraphTransform::GetInputOutputs(UK2Node* Node, UEdGraphPin*& Self, TAr
         if (Pin->Direction == EGPD_Input) {
             if (Pin->PinName == "self") {
                 Self = Pin;
-                FString Name = ResolveInputPin(Pin);
-                PinToVariable.Add(Pin, Name);
+                FStringView Name = ResolveInputPin(Pin);
+                SetVariable(Pin, Name);
                 continue;
             }
 
             // TODO: We need to generate the code for the Arguments
-            FString Name = ResolveInputPin(Pin);
+            FStringView Name = ResolveInputPin(Pin);
 
             Inputs.Add(Name);
         }
         else if (Pin->Direction == EGPD_Output) {
-            FString Name = ResolveOutputPin(Pin);
+            FStringView Name = ResolveOutputPin(Pin);
             Outputs.Add(Name);
         }
     }
 }
 
-void FGKEdGraphTransform::GetInputOutputs(UK2Node* Node, TArray<FString>& Inputs, TArray<FString>& Outputs) {
+void FGKEdGraphTransform::GetInputOutputs(UK2Node* Node, FGKArenaStrings& Inputs, FGKArenaStrings& Outputs) {
     for (UEdGraphPin* Pin : Node->Pins) {
         // Ignore execution pins
         if (Pin->PinType.PinCategory == "exec") {
@@ -613,12 +1255,12 @@ void FGKEdGraphTransform::GetInputOutputs(UK2Node* Node, TArray<FString>& Inputs
 
         if (Pin->Direction == EGPD_Input) {
             // TODO: We need to generate the code for the Arguments
-            FString Name = ResolveInputPin(Pin);
+            FStringView Name = ResolveInputPin(Pin);
 
             Inputs.Add(Name);
         }
         else if (Pin->Direction == EGPD_Output) {
-            FString Name = ResolveOutputPin(Pin);
+            FStringView Name = ResolveOutputPin(Pin);
             Outputs.Add(Name);
         }
     }
@@ -626,20 +1268,24 @@ void FGKEdGraphTransform::GetInputOutputs(UK2Node* Node, TArray<FString>& Inputs
 
 void FGKEdGraphTransform::CallFunction(UK2Node_CallFunction* Node)
 {
-    CallFunction(*Node->GetFunctionName().ToString(), Node);
+    CallFunction(*GetFunctionName(Node).ToString(), Node);
 }
 
 void FGKEdGraphTransform::DynamicCast(UK2Node_DynamicCast* Node)
 {
-    TArray<FString> Args;
-    TArray<FString> Outs;
+    FGKArenaStrings Args;
+    FGKArenaStrings Outs;
 
     // TODO: We need to generate the code for the Arguments
     GetInputOutputs(Node, Args, Outs);
 
     // Get the outputs
-    GetNodeOutputs(Node, Outs);
-    WRITELINE("%s = Cast(%s, %s)", *Join(",", Outs), *Node->TargetType->GetName(), *Join(",", Args));
+    TArray<FString> Names;
+    GetNodeOutputs(Node, Names);
+    for (FString const& Name : Names) {
+        Outs.Add(Arena.Copy(Name));
+    }
+    WRITELINE("%s = Cast(%s, %s)", *Join(TEXT(","), Outs), *Node->TargetType->GetName(), *Join(TEXT(","), Args));
 
     // TODO: Handle the Cast Failed exec pin
     //
@@ -652,23 +1298,27 @@ void FGKEdGraphTransform::DynamicCast(UK2Node_DynamicCast* Node)
     // LogBCUtils: Display: >>> Name: 'As Floating Health' object(Links : 2)
     // LogBCUtils: Display: >>> Name: 'Success' bool(Links : 0)
 
-    Super::Exec(FindNextExecutionNode(Node));
+    ExecNext(FindNextExecutionNode(Node));
     return Return();
 }
 
 void FGKEdGraphTransform::Event(UK2Node_Event* Node)
 {
     WRITENODETYPE("# Event");
+
+    if (IsOverride(Node)) {
+        WRITELINE("@override");
+    }
     WRITELINE("def On_%s(self):", *Node->GetFunctionName().ToString());
     NEWSCOPE();
     {
         INDENT();
-        WRITELINE(DOCSTRING "%s" DOCSTRING, *FormatDocstring(Node->GetTooltipText().ToString()));
+        WRITELINE(DOCSTRING "%s" DOCSTRING, *FormatDocstring(GetNodeDocstring(Node)));
 
         Super::Exec(Node->GetThenPin());
     }
 
-    GENPRINT("\n");
+    Defer([this]() { GENPRINT("\n"); });
 }
 
 void FGKEdGraphTransform::VariableGet(UK2Node_VariableGet* Node) {
@@ -680,10 +1330,10 @@ void FGKEdGraphTransform::Self(UK2Node_Self* Node) {
 }
 
 void FGKEdGraphTransform::GetSubsystem(UK2Node_GetSubsystem* Node) {
-    FString VariableName = "Subsystem";
+    FStringView VariableName = TEXT("Subsystem");
 
     UEdGraphPin* OutputPin = Node->GetResultPin();
-    FString* Name = PinToVariable.Find(OutputPin);
+    FStringView* Name = FindVariable(OutputPin);
 
     if (Name != nullptr) {
         return;
@@ -692,22 +1342,21 @@ void FGKEdGraphTransform::GetSubsystem(UK2Node_GetSubsystem* Node) {
     UObject* Subsystem = OutputPin->PinType.PinSubCategoryObject.Get();
     UClass* Klass = Cast<UClass>(Subsystem);
 
-    WRITELINE("%s = GetSubsystem(ClassName=%s)", *VariableName, *Subsystem->GetName());
+    WRITELINE("%s = GetSubsystem(ClassName=%s)", VariableName.GetData(), *Subsystem->GetName());
 
-    PinToVariable.Add(OutputPin, VariableName);
+    SetVariable(OutputPin, VariableName);
     Super::Exec(Node->GetThenPin());
 }
 
 
-void FGKEdGraphTransform::CallFunction(FString FunctionName, UK2Node* Node) {
-    if (PreviousNodes.Contains(Node)) {
+void FGKEdGraphTransform::CallFunction(FStringView FunctionName, UK2Node* Node) {
+    if (MarkVisited(Node)) {
         GKSCRIPT_WARNING(TEXT("Already called"));
         return;
     }
-    PreviousNodes.Add(Node);
 
     TArray<FGKResolvedPin> ResolvedInputs;
-    TArray<FString> Outs;
+    FGKArenaStrings Outs;
 
     // Generate the code to compute the arguments
     // ExecuteArguments(Node);
@@ -716,27 +1365,31 @@ void FGKEdGraphTransform::CallFunction(FString FunctionName, UK2Node* Node) {
     FGKResolvedPin Self;
     GetInputOutputs(Node, Self, ResolvedInputs, Outs);
 
-    TArray<FString> Args;
+    FGKArenaStrings Args;
     for (auto& Input : ResolvedInputs) {
 
         FString ArgName = Input.StartPin->PinName.ToString();
-        FString Type = GetType(Input.StartPin);
+        FString const& Type = GetType(Input.StartPin);
 
         Args.Add(GenerateCallArgument(ArgName, Type, Input.Value));
     }
 
     if (Self.StartPin != nullptr) {
-        FString SelfType = "self";
+        FStringView SelfType = TEXT("self");
+        FString SelfClass;
 
         if (!Self.Value.IsEmpty()) {
             SelfType = Self.Value;
         }
 
         if (Self.StartPin->DefaultObject) {
-            SelfType = Self.StartPin->DefaultObject->GetClass()->GetName();
+            SelfClass = Self.StartPin->DefaultObject->GetClass()->GetName();
+            SelfType = SelfClass;
         }
 
-        FunctionName = FString::Printf(TEXT("%s.%s"), *SelfType, *FunctionName);
+        TStringBuilder<128> Qualified;
+        Qualified << SelfType << TEXT(".") << FunctionName;
+        FunctionName = Arena.Copy(Qualified.ToView());
     }
 
     ensure(!FunctionName.IsEmpty());
@@ -747,18 +1400,22 @@ void FGKEdGraphTransform::CallFunction(FString FunctionName, UK2Node* Node) {
         if (Args.Num() > 0) {
             {
                 INDENT();
-                ArgList = "\n" + Indentation() + Join(FString(",\n") + Indentation(), Args) + "\n";
+                FString Sep = TEXT(",\n") + Indentation();
+                ArgList = TEXT("\n") + Indentation() + Join(Sep, Args) + TEXT("\n");
             }
             ArgList += Indentation();
         }
     }
 
+    TStringBuilder<128> Function;
+    Function << FunctionName;
+
     if (Outs.Num() > 0)
     {
-        WRITELINE("%s = %s(%s)", *Join(", ", Outs), *FunctionName, *ArgList);
+        WRITELINE("%s = %s(%s)", *Join(TEXT(", "), Outs), *Function, *ArgList);
     }
     else {
-        WRITELINE("%s(%s)", *FunctionName, *ArgList);
+        WRITELINE("%s(%s)", *Function, *ArgList);
     }
 
 
@@ -766,11 +1423,10 @@ void FGKEdGraphTransform::CallFunction(FString FunctionName, UK2Node* Node) {
 }
 
 void FGKEdGraphTransform::EnhancedInputAction(UK2Node_EnhancedInputAction* Node) {
-    if (PreviousNodes.Contains(Node)) {
+    if (MarkVisited(Node)) {
         GKSCRIPT_WARNING(TEXT("Already called"));
         return;
     }
-    PreviousNodes.Add(Node);
 
     FString InputActionName = Node->InputAction->GetName();
 
@@ -778,27 +1434,28 @@ void FGKEdGraphTransform::EnhancedInputAction(UK2Node_EnhancedInputAction* Node)
     // MakeFunction(InputActionName, Node);
 
     TArray<UEdGraphPin*> PinArgs;
-    TArray<FString> Args;
-    Args.Add("self");
-    Args.Add("TriggerEvent");
+    FGKArenaStrings Args;
+    Args.Add(TEXT("self"));
+    Args.Add(TEXT("TriggerEvent"));
 
     for (auto Pin : Node->Pins) {
         if (Pin->Direction == EGPD_Output && Pin->PinType.PinCategory != "exec") {
+            FStringView PinName = Arena.Copy(Pin->PinName.ToString());
             PinArgs.Add(Pin);
-            Args.Add(Pin->PinName.ToString());
+            Args.Add(PinName);
 
-            PinToVariable.Add(Pin, Pin->PinName.ToString());
+            SetVariable(Pin, PinName);
         }
     }
     
     //*
    
     WRITENODETYPE("# EnhancedInputAction");
-    WRITELINE("def %s(%s):", *InputActionName, *Join(", ", Args));
+    WRITELINE("def %s(%s):", *InputActionName, *Join(TEXT(", "), Args));
 
     {
         INDENT();
-        WRITELINE(DOCSTRING "%s" DOCSTRING, *FormatDocstring(Node->GetTooltipText().ToString()));
+        WRITELINE(DOCSTRING "%s" DOCSTRING, *FormatDocstring(GetNodeDocstring(Node)));
 
         // FInputActionValue UEnhancedPlayerInput::GetActionValue(TObjectPtr<const UInputAction> ForAction) const;
         // FInputActionValue
@@ -807,11 +1464,11 @@ void FGKEdGraphTransform::EnhancedInputAction(UK2Node_EnhancedInputAction* Node)
         for (auto Pin : Node->Pins) {
             if (Pin->Direction == EGPD_Output && Pin->PinType.PinCategory == "exec") {
                 INDENT();
-                WRITELINE("case \"%s\":", *Pin->PinName.ToString());
+                Defer([this, Case = Pin->PinName.ToString()]() { WRITELINE("case \"%s\":", *Case); });
                 INDENT();
 
                 if (Pin->LinkedTo.Num() == 0) {
-                    WRITELINE("pass");
+                    Defer([this]() { WRITELINE("pass"); });
                 }
                 else {
                     Exec(Pin);
@@ -820,7 +1477,7 @@ void FGKEdGraphTransform::EnhancedInputAction(UK2Node_EnhancedInputAction* Node)
         }
 
         Super::Exec(Node->GetThenPin());
-        GENPRINT("\n");
+        Defer([this]() { GENPRINT("\n"); });
     }
     //*/
 }
@@ -829,7 +1486,7 @@ void FGKEdGraphTransform::EnhancedInputAction(UK2Node_EnhancedInputAction* Node)
 void FGKEdGraphTransform::MacroInstance(UK2Node_MacroInstance* Node) {
     
 
-    UEdGraph* MacroGraph = Node->GetMacroGraph();
+    UEdGraph* MacroGraph = GetMacroGraph(Node);
     UBlueprint* MacroLibray = Node->GetBlueprint();
 
     FString MacroName;
@@ -842,26 +1499,26 @@ void FGKEdGraphTransform::MacroInstance(UK2Node_MacroInstance* Node) {
         }
     }
 
-    TArray<FString> Args;
+    FGKArenaStrings Args;
     for (auto& In : ResolvedInputs) {
 
         FString ArgName = In.StartPin->PinName.ToString();
-        FString Type = GetType(In.StartPin);
+        FString const& Type = GetType(In.StartPin);
         Args.Add(GenerateCallArgument(ArgName, Type, In.Value));
     }
 
     // Macros are match
     // because they have multiple control flow
     WRITENODETYPE("# MacroInstance");
-    WRITELINE("match %s(%s):", *MacroName, *Join(", ", Args));
+    WRITELINE("match %s(%s):", *MacroName, *Join(TEXT(", "), Args));
     for (auto Pin : Node->Pins) {
         if (Pin->Direction == EGPD_Output){
             INDENT();
-            WRITELINE("case \"%s\":", *Pin->PinName.ToString());
+            Defer([this, Case = Pin->PinName.ToString()]() { WRITELINE("case \"%s\":", *Case); });
             INDENT();
 
             if (Pin->LinkedTo.Num() == 0) {
-                WRITELINE("pass");
+                Defer([this]() { WRITELINE("pass"); });
             } else {
                 Exec(Pin);
             }
@@ -871,13 +1528,13 @@ void FGKEdGraphTransform::MacroInstance(UK2Node_MacroInstance* Node) {
 
 void FGKEdGraphTransform::Tunnel(UK2Node_Tunnel* Node) {
     WRITENODETYPE("# Tunnel");
-    TArray<FString> Inputs;
-    TArray<FString> Outputs;
+    FGKArenaStrings Inputs;
+    FGKArenaStrings Outputs;
     GetInputOutputs(Node, Inputs, Outputs);
 
     auto Next = Node->GetThenPin();
     if (Next){
-        Super::Exec(Cast<UK2Node>(Next->GetOwningNode()));
+        Exec(Next);
     }
 }
 
@@ -887,7 +1544,7 @@ void FGKEdGraphTransform::Knot(UK2Node_Knot* Node) {
     int Count = 0;
     for (UEdGraphPin* Pin : Node->Pins) {
         if (Pin && Pin->Direction == EGPD_Output) {
-            Super::ExecGraphNode(Pin->GetOwningNode());
+            Exec(Pin);
             Count += 1;
         }
     }
@@ -903,29 +1560,27 @@ FString FGKEdGraphTransform::FormatDocstring(FString const& Docstring) {
 }
 
 
-void FGKEdGraphTransform::MakeFunction(FString FunctionName, UK2Node* Node) {
-    if (PreviousNodes.Contains(Node)) {
+void FGKEdGraphTransform::MakeFunction(FStringView FunctionName, UK2Node* Node) {
+    if (MarkVisited(Node)) {
         GKSCRIPT_WARNING(TEXT("Inifinite Loop"));
         return;
     }
-    PreviousNodes.Add(Node);
 
     NEWSCOPE();
 
     // Generate the code to compute the arguments
     // ExecuteArguments(Node);
 
-    TArray<FString> Inputs;
-    TArray<FString> Arguments;
-    Arguments.Add("self");
+    FGKArenaStrings Inputs;
+    FGKArenaStrings Arguments;
+    Arguments.Add(TEXT("self"));
 
     GetInputOutputs(Node, Inputs, Arguments);
 
-    UK2Node_FunctionEntry* Entry = Cast<UK2Node_FunctionEntry>(Node);
-    FString Tooltip = Node->GetTooltipText().ToString();
+    FString Tooltip = GetNodeDocstring(Node);
 
     // WRITELINE("# MakeFunction");
-    WRITELINE("def %s(%s):", *FunctionName, *Join(", ", Arguments));
+    WRITELINE("def %s(%s):", *FString(FunctionName), *Join(TEXT(", "), Arguments));
 
     {
         INDENT();
@@ -938,43 +1593,36 @@ void FGKEdGraphTransform::MakeFunction(FString FunctionName, UK2Node* Node) {
             WRITELINE("    pass");
         }
 
-        GENPRINT("\n");
+        Defer([this]() { GENPRINT("\n"); });
     }
 }
 
 void FGKEdGraphTransform::FunctionTerminator(UK2Node_FunctionTerminator* Node) 
 {
-    if (PreviousNodes.Contains(Node)) {
+    if (MarkVisited(Node)) {
         GKSCRIPT_WARNING(TEXT("Inifinite Loop"));
         return;
     }
-    PreviousNodes.Add(Node);
 
     NEWSCOPE();
 
     // Generate the code to compute the arguments
     // ExecuteArguments(Node);
 
-    TArray<FString> Inputs;
-    TArray<FString> Arguments;
-    Arguments.Add("self");
+    FGKArenaStrings Inputs;
+    FGKArenaStrings Arguments;
+    Arguments.Add(TEXT("self"));
 
     GetInputOutputs(Node, Inputs, Arguments);
 
-    FName FunctionName = Node->FunctionReference.GetMemberName();
-
-    UK2Node_FunctionEntry* Entry = Cast<UK2Node_FunctionEntry>(Node);
-    FString Tooltip = Node->GetTooltipText().ToString();
-
-    if (Entry) {
-        if (Entry->CustomGeneratedFunctionName != NAME_None) {
-            FunctionName = Entry->CustomGeneratedFunctionName;
-        }
-        Tooltip = Entry->MetaData.ToolTip.ToString();
-    }
+    FName FunctionName = GetDefinedFunctionName(Node);
+    FString Tooltip = GetNodeDocstring(Node);
 
     // WRITELINE("# FunctionTerminator");
-    WRITELINE("def %s(%s):", *FunctionName.ToString(), *Join(", ", Arguments));
+    if (IsOverride(Node)) {
+        WRITELINE("@override");
+    }
+    WRITELINE("def %s(%s):", *FunctionName.ToString(), *Join(TEXT(", "), Arguments));
 
     {
         INDENT();
@@ -987,32 +1635,32 @@ void FGKEdGraphTransform::FunctionTerminator(UK2Node_FunctionTerminator* Node)
             WRITELINE("    pass");
         }
 
-        GENPRINT("\n");
+        Defer([this]() { GENPRINT("\n"); });
     }
 }
 
 // Return Node
 void FGKEdGraphTransform::FunctionResult(UK2Node_FunctionResult* Node) 
 {
-    TArray<FString> Inputs;
-    TArray<FString> Outs;
+    FGKArenaStrings Inputs;
+    FGKArenaStrings Outs;
     GetInputOutputs(Node, Inputs, Outs);
 
     // 
     WRITENODETYPE("# FunctionResult");
-    TArray<FString> Values;
-    for(FString& Input: Inputs) {
-        WRITELINE(TEXT("%s"), *Input);
+    FGKArenaStrings Values;
+    for(FStringView Input: Inputs) {
+        WRITELINE(TEXT("%s"), Input.GetData());
 
         // Extract the variable names for the return statement
         for(int i = 0; i < Input.Len(); i++) {
             if (Input[i] == ' ' || Input[i] ==  ':') {
-                Values.Add(Input.LeftChop(Input.Len() - i));
+                Values.Add(Input.Left(i));
                 break;
             }
         }
     }
-    WRITELINE("return %s", *Join(", ", Values));
+    WRITELINE("return %s", *Join(TEXT(", "), Values));
 }
 
 void FGKEdGraphTransform::FunctionEntry(UK2Node_FunctionEntry* Node)
@@ -1024,7 +1672,7 @@ void FGKEdGraphTransform::FunctionEntry(UK2Node_FunctionEntry* Node)
 void FGKEdGraphTransform::IfThenElse(UK2Node_IfThenElse* Node)
 {
     // Compute Condition
-    FString Name = ResolveInputPin(Node->GetConditionPin());
+    FString Name(ResolveInputPin(Node->GetConditionPin()));
     int CharPos = 0;
     if (Name.FindChar(' ', CharPos)) {
         Name = Name.LeftChop(Name.Len() - CharPos);
@@ -1039,7 +1687,7 @@ void FGKEdGraphTransform::IfThenElse(UK2Node_IfThenElse* Node)
     }
 
     if (Node->GetElsePin()->LinkedTo.Num() > 0) {
-        WRITELINE("else:");
+        Defer([this]() { WRITELINE("else:"); });
         {
             INDENT();
             Exec(Node->GetElsePin());
@@ -1073,7 +1721,9 @@ void FGKEdGraphTransform::VariableSet(UK2Node_VariableSet* Node) {
     WRITELINE("self.%s = %s", *Variable, TEXT("Whatever"));
 
 
-    PinToVariable.Add(Output, Name);
+    if (Output) {
+        SetVariable(Output, Arena.Copy(Name));
+    }
 
     Exec(Node->GetThenPin());
 }
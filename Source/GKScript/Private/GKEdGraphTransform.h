@@ -2,7 +2,9 @@
 #pragma once
 
 // Gamekit
+#include "GKArena.h"
 #include "GKEdGraphVisitor.h"
+#include "GKFunctionCache.h"
 
 // Unreal Engine
 #include "Misc/Paths.h"
@@ -19,13 +21,21 @@ struct FGKCodeWriter {
         Write(TCHAR_TO_UTF8(*Output));
     }
 
+    // Code is kept in memory and written to the file on Close
     void OpenFile(FString Folder, FString ScriptName);
 
+    // Write to memory instead of a file
+    void OpenBuffer(TArray<ANSICHAR>& Bytes);
+
     void Write(const char* Bytes);
 
+    void Write(TArray<ANSICHAR> const& Bytes);
+
     void Close();
 
     void* FilePointer = nullptr;
+    TArray<ANSICHAR>* Buffer = nullptr;
+    TArray<ANSICHAR> FileBytes;     // Code of the open file
 };
 
 
@@ -36,11 +46,43 @@ struct FGKGenContext {
 };
 
 
+// Graph being emitted while its code is captured for FGKFunctionCache
+struct FGKPendingGraph {
+    uint64                  Key = 0;
+    FGKFunctionCacheEntry   Entry;
+    TArray<ANSICHAR>*       Buffer = nullptr;
+    TSet<FString>           Variables;      // Names taken in the scope before the graph
+};
+
+// What forked transforms read from the UObjects of a node, read on the game thread before going wide
+struct FGKNodeSnapshot {
+    FString     Docstring;
+    FName       FunctionName;
+    UEdGraph*   MacroGraph = nullptr;
+    bool        bOverride = false;
+};
+
+// Steps of the sliced generation, see GenerateSlice
+enum class EGKSliceStep : uint8 {
+    Class,      // Declaration and docstring
+    Defaults,
+    Graphs,
+    Done
+};
+
+// Steps of a sliced graph, see GenerateGraphSlice
+enum class EGKGraphSliceStep : uint8 {
+    Begin,
+    Key,        // Graph key, node by node
+    Cache,      // Cached code is written at once
+    Exec        // Numbering, roots and nodes, node by node
+};
+
 struct FGKResolvedPin {
     UEdGraphPin* StartPin = nullptr;
     UEdGraphPin* EndPin   = nullptr;
     UEdGraphNode* Node    = nullptr;
-    FString      Value;
+    FStringView  Value;
 };
 
 /*! Basic proof of concept turning Blueprint graph into code
@@ -65,35 +107,109 @@ struct FGKEdGraphTransform : public FGKEdGraphVisitor<FGKEdGraphTransform, void>
 
     FGKEdGraphTransform(class UBlueprint* Source, FString Folder, FString ScriptName);
 
+    // Emit parts of a Blueprint into a buffer, for previews
+    FGKEdGraphTransform(class UBlueprint* Source, TArray<ANSICHAR>& Output);
+
+    // Fork a transform that emits a single root into a buffer
+    FGKEdGraphTransform(FGKEdGraphTransform const& Parent, TArray<ANSICHAR>& Output);
+
     void Generate();
 
+    // Resumable Generate, returns true once the file is complete.
+    // Works one step at a time (class, defaults, then a node of a graph at a time)
+    // until EndTime (FPlatformTime::Seconds)
+    bool GenerateSlice(double EndTime);
+
+    // Resumable GenerateGraph, returns true once the graph is emitted.
+    // A graph deleted between two slices is dropped and reported as emitted
+    bool GenerateGraphSlice(UEdGraph* Graph, double EndTime);
+
+    // Class declaration and docstring, opens the class body
+    void BeginClass();
+    void EndClass();
+
+    // Variables, overridden defaults and components, only what differs from the parent
+    void GenerateDefaults();
+
+    void GenerateComponent(class USCS_Node* Node, FName Parent);
+
+    // Emit a graph, reuse the code generated for an identical graph if there is one
+    void GenerateGraph(UEdGraph* Graph);
+
+    // Emit all the roots of a graph, independent roots of large graphs are emitted in parallel
+    void EmitGraph(UEdGraph* Graph);
+
+    // Roots that can be emitted by a fork: they open their own scope
+    // and no other root reaches the nodes they reach
+    TBitArray<> FindIndependentRoots(TArray<UK2Node*> const& Roots);
+
+    void TakeSnapshots(TArray<FGKNodeSnapshot>& Snapshots);
+    FGKNodeSnapshot const* FindSnapshot(UEdGraphNode* Node) const;
+
+    // UObject reads of the node handlers, from the snapshot in forks
+    FString GetNodeDocstring(UK2Node* Node) const;
+    FName GetFunctionName(UK2Node_CallFunction* Node) const;
+    UEdGraph* GetMacroGraph(UK2Node_MacroInstance* Node) const;
+
+    // Function or event declared by the parent class
+    bool IsOverride(UK2Node* Node) const;
+
+    // Hash of the graph and of the transform state that changes its code
+    uint64 GetGraphKey(UEdGraph* Graph) const;
+
+    // Resumable GetGraphKey
+    void BeginGraphKey(UEdGraph* Graph, FGKGraphHasher& Hasher) const;
+
+    // Write the cached code of the graph and return true, or start capturing its code
+    bool BeginCachedGraph(UEdGraph* Graph);
+    bool BeginCachedGraph(UEdGraph* Graph, uint64 Key);
+
+    // Write the captured code of the graph, if any, and store it unless the graph changed while it was emitted
+    void EndCachedGraph(bool bStore = true);
+
     FString Indentation() const;
 
-    void GetInputOutputs(UK2Node* Node, TArray<FString>& Args, TArray<FString>& Outs);
-    void GetInputOutputs(UK2Node* Node, UEdGraphPin*& Self, TArray<FString>& Inputs, TArray<FString>& Outputs);
+    void GetInputOutputs(UK2Node* Node, FGKArenaStrings& Args, FGKArenaStrings& Outs);
+    void GetInputOutputs(UK2Node* Node, UEdGraphPin*& Self, FGKArenaStrings& Inputs, FGKArenaStrings& Outputs);
 
-    FString MakeVariable(UEdGraphPin* Pin);
-    FString GetVariable(UEdGraphPin* Pin);
+    FStringView MakeVariable(UEdGraphPin* Pin);
+    FStringView GetVariable(UEdGraphPin* Pin);
 
-    FString ResolveInputPin(UEdGraphPin* EndPin);
-    FString ResolveOutputPin(UEdGraphPin* EndPin);
+    FStringView ResolveInputPin(UEdGraphPin* EndPin);
+    FStringView ResolveOutputPin(UEdGraphPin* EndPin);
 
     FGKResolvedPin ResolvePin(UEdGraphPin* StartPin, EEdGraphPinDirection Direction);
-    void GetInputOutputs(UK2Node* Node, FGKResolvedPin& Self, TArray<FGKResolvedPin>& Inputs, TArray<FString>& Outputs);
 
+    // Nodes queued by the sliced traversal are emitted at the indentation they were queued at
+    int32 GetExecState() const {
+        return IndentationLevel;
+    }
+
+    void SetExecState(int32 State) {
+        IndentationLevel = State;
+    }
+
+    // Reset the per pin state, the roots of a graph share their variables
+    void ResetTraversal();
+
+    FStringView* FindVariable(UEdGraphPin* Pin);
+    void SetVariable(UEdGraphPin* Pin, FStringView Name);
+    void GetInputOutputs(UK2Node* Node, FGKResolvedPin& Self, TArray<FGKResolvedPin>& Inputs, FGKArenaStrings& Outputs);
 
-    void _FindAllNames(UEdGraphPin* EndPin, TSet<UEdGraphPin*>& Visited, TSet<FString>& Names);
+
+    void _FindAllNames(UEdGraphPin* EndPin, FGKVisitedPins& Visited, TSet<FString>& Names);
     TArray<FString> FindAllNames(UEdGraphPin* EndPin);
 
 
     // Helpers
     // -------
     FString FormatDocstring(FString const& Docstring);
-    FString GenerateCallArgument(FString const& Name, FString const& Type, FString const& Value);
-    FString GenerateReturnVariable(FString const& Name, FString const& Type);
+    FStringView GenerateCallArgument(FStringView Name, FString const& Type, FStringView Value);
+    FStringView GenerateReturnVariable(FStringView Name, FString const& Type);
+
+    void MakeFunction(FStringView FunctionName, UK2Node* Node);
 
-    void MakeFunction(FString FunctionName, UK2Node* Node);
-    void CallFunction(FString FunctionName, UK2Node* Node);
+    void CallFunction(FStringView FunctionName, UK2Node* Node);
 
     // Generate Transform Functions
     // ---------------------------
@@ -108,10 +224,22 @@ struct FGKEdGraphTransform : public FGKEdGraphVisitor<FGKEdGraphTransform, void>
 
     bool                        bShowTypeName = true;
     bool                        bDebugTypes = false;
+    bool                        bParallelRoots = true;
+    bool                        bFunctionCache = true;      // Reuse the code of identical graphs, see FGKFunctionCache
+    int                         ParallelRootThreshold = 16; // Minimum number of independent roots to go parallel
+    TArray<FGKNodeSnapshot> const* Snapshots = nullptr;     // Indexed by node id, set while forks are running
     class UBlueprint*           Source = nullptr;
+    TUniquePtr<FGKPendingGraph> PendingGraph;
+    TArray<TWeakObjectPtr<UEdGraph>> SliceGraphs; // Graphs of the sliced generation
+    int32                       SliceGraph = 0;
+    EGKSliceStep                SliceStep = EGKSliceStep::Class;
+    EGKGraphSliceStep           GraphSliceStep = EGKGraphSliceStep::Begin;
+    FGKGraphHasher              GraphHasher;      // Key of the sliced graph
     TArray<FGKGenContext>       Context;
     FGKCodeWriter               Writer;           // FileWriter
-    TMap<UEdGraphPin*, FString> PinToVariable;    // Convert Pins to variables
+    FGKArena                    Arena;            // Strings of the graph being emitted
+    TArray<FStringView>         PinToVariable;    // Convert Pins to variables, indexed by pin id
+    TMap<UEdGraphPin const*, FStringView> ExternalVariables; // Pins outside of the numbered graph
     int                         IndentationLevel; // Used to generate python code
                                                   // with the right indentation
 };
@@ -0,0 +1,271 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKEdGraphTypes.h"
+
+// Gamekit
+#include "GKScript.h"
+#include "GKScriptAst.h"
+#include "GKReflectionIndex.h"
+
+// Unreal Engine
+#include "EdGraphSchema_K2.h"
+
+
+FGKPinTypeKey::FGKPinTypeKey(FEdGraphPinType const& PinType):
+    Category(PinType.PinCategory),
+    SubCategoryObject(PinType.PinSubCategoryObject),
+    ContainerType(PinType.ContainerType),
+    ValueCategory(PinType.PinValueType.TerminalCategory),
+    ValueSubCategoryObject(PinType.PinValueType.TerminalSubCategoryObject)
+{
+    Hash = GetTypeHash(Category);
+    Hash = HashCombine(Hash, GetTypeHash(SubCategoryObject));
+    Hash = HashCombine(Hash, GetTypeHash(uint8(ContainerType)));
+
+    if (ContainerType == EPinContainerType::Map) {
+        Hash = HashCombine(Hash, GetTypeHash(ValueCategory));
+        Hash = HashCombine(Hash, GetTypeHash(ValueSubCategoryObject));
+    }
+}
+
+bool FGKPinTypeKey::operator== (FGKPinTypeKey const& Other) const {
+    if (Hash != Other.Hash || ContainerType != Other.ContainerType) {
+        return false;
+    }
+
+    if (Category != Other.Category || SubCategoryObject != Other.SubCategoryObject) {
+        return false;
+    }
+
+    // Only maps care about the value type
+    if (ContainerType == EPinContainerType::Map) {
+        return ValueCategory == Other.ValueCategory && ValueSubCategoryObject == Other.ValueSubCategoryObject;
+    }
+    return true;
+}
+
+
+FGKPinTypeNames& FGKPinTypeNames::Get() {
+    static FGKPinTypeNames Names;
+    return Names;
+}
+
+FString const& FGKPinTypeNames::GetName(FEdGraphPinType const& PinType) {
+    return FindOrAdd(PinType).Name;
+}
+
+FName FGKPinTypeNames::GetFName(FEdGraphPinType const& PinType) {
+    return FindOrAdd(PinType).Interned;
+}
+
+FGKPinTypeNames::FEntry const& FGKPinTypeNames::FindOrAdd(FEdGraphPinType const& PinType) {
+    FGKPinTypeKey Key(PinType);
+
+    {
+        FReadScopeLock ReadLock(Lock);
+        if (TUniquePtr<FEntry> const* Found = Entries.FindByHash(Key.Hash, Key)) {
+            return *Found[0];
+        }
+    }
+
+    FWriteScopeLock WriteLock(Lock);
+
+    // Another thread might have added it while we were waiting
+    TUniquePtr<FEntry>& Entry = Entries.FindOrAddByHash(Key.Hash, Key);
+    if (!Entry.IsValid()) {
+        Entry = MakeUnique<FEntry>();
+        Entry->Name = MakeName(PinType);
+        Entry->Interned = FName(*Entry->Name);
+    }
+    return *Entry;
+}
+
+namespace {
+
+FString GetTerminalName(FName Category, UObject* Object) {
+    if (Object) {
+        // The actual object of the CDO ?
+        return Object->GetName();
+    }
+
+    // PinCategory: struct, object, bool
+    return Category.ToString();
+}
+
+} // namespace
+
+FString FGKPinTypeNames::MakeName(FEdGraphPinType const& PinType) {
+    FString Name = GetTerminalName(PinType.PinCategory, PinType.PinSubCategoryObject.Get());
+
+    switch (PinType.ContainerType) {
+    case EPinContainerType::Array:
+        return FString::Printf(TEXT("list[%s]"), *Name);
+
+    case EPinContainerType::Set:
+        return FString::Printf(TEXT("set[%s]"), *Name);
+
+    case EPinContainerType::Map: {
+        FString Value = GetTerminalName(
+            PinType.PinValueType.TerminalCategory,
+            PinType.PinValueType.TerminalSubCategoryObject.Get()
+        );
+        return FString::Printf(TEXT("dict[%s, %s]"), *Name, *Value);
+    }
+
+    default:
+        return Name;
+    }
+}
+
+
+FGKPinTypeResolver& FGKPinTypeResolver::Get() {
+    static FGKPinTypeResolver Resolver;
+    return Resolver;
+}
+
+FGKPinTypeResolver::FGKPinTypeResolver() {
+    AddBuiltins();
+}
+
+void FGKPinTypeResolver::Reset() {
+    Terminals.Reset();
+    AddBuiltins();
+}
+
+void FGKPinTypeResolver::ForgetUnresolved() {
+    for (auto It = Terminals.CreateIterator(); It; ++It) {
+        if (It->Value.PinCategory.IsNone()) {
+            It.RemoveCurrent();
+        }
+    }
+}
+
+void FGKPinTypeResolver::AddBuiltins() {
+    auto Add = [this](FName Name, FName Category, FName SubCategory = NAME_None) {
+        FEdGraphPinType PinType;
+        PinType.PinCategory = Category;
+        PinType.PinSubCategory = SubCategory;
+        Terminals.Add(Name, PinType);
+    };
+
+    // Names written by FGKPinTypeNames
+    Add(UEdGraphSchema_K2::PC_Boolean, UEdGraphSchema_K2::PC_Boolean);
+    Add(UEdGraphSchema_K2::PC_Byte, UEdGraphSchema_K2::PC_Byte);
+    Add(UEdGraphSchema_K2::PC_Int, UEdGraphSchema_K2::PC_Int);
+    Add(UEdGraphSchema_K2::PC_Int64, UEdGraphSchema_K2::PC_Int64);
+    Add(UEdGraphSchema_K2::PC_Real, UEdGraphSchema_K2::PC_Real, UEdGraphSchema_K2::PC_Double);
+    Add(UEdGraphSchema_K2::PC_Name, UEdGraphSchema_K2::PC_Name);
+    Add(UEdGraphSchema_K2::PC_String, UEdGraphSchema_K2::PC_String);
+    Add(UEdGraphSchema_K2::PC_Text, UEdGraphSchema_K2::PC_Text);
+    Add(UEdGraphSchema_K2::PC_Wildcard, UEdGraphSchema_K2::PC_Wildcard);
+
+    // Python spellings
+    Add(TEXT("float"), UEdGraphSchema_K2::PC_Real, UEdGraphSchema_K2::PC_Double);
+    Add(TEXT("str"), UEdGraphSchema_K2::PC_String);
+}
+
+bool FGKPinTypeResolver::ResolveTerminal(FStringView Name, FEdGraphPinType& PinType) {
+    // Names that were never interned are not types
+    FName Key(Name, FNAME_Find);
+    if (Key.IsNone()) {
+        return false;
+    }
+
+    FEdGraphPinType* Found = Terminals.Find(Key);
+
+    // Reinstanced classes invalidate their entry
+    bool bStale = Found && !Found->PinCategory.IsNone() &&
+        !Found->PinSubCategoryObject.IsExplicitlyNull() && !Found->PinSubCategoryObject.IsValid();
+
+    if (Found == nullptr || bStale) {
+        FEdGraphPinType Resolved;
+        FGKReflectionIndex& Index = FGKReflectionIndex::Get();
+
+        if (UScriptStruct* Struct = Index.FindStruct(Name)) {
+            Resolved.PinCategory = UEdGraphSchema_K2::PC_Struct;
+            Resolved.PinSubCategoryObject = Struct;
+        }
+        else if (UClass* Class = Index.FindClass(Name)) {
+            Resolved.PinCategory = UEdGraphSchema_K2::PC_Object;
+            Resolved.PinSubCategoryObject = Class;
+        }
+        else if (UEnum* Enum = Index.FindEnum(Name)) {
+            Resolved.PinCategory = UEdGraphSchema_K2::PC_Byte;
+            Resolved.PinSubCategoryObject = Enum;
+        }
+
+        Found = &Terminals.Add(Key, Resolved);
+    }
+
+    if (Found->PinCategory.IsNone()) {
+        return false;
+    }
+
+    PinType = *Found;
+    return true;
+}
+
+bool FGKPinTypeResolver::ResolveContainer(FGKScriptAst const& Ast, int32 Annotation, FEdGraphPinType& PinType) {
+    int32 Container = Ast.GetChild(Annotation, 0);
+    int32 Index = Ast.GetChild(Annotation, 1);
+
+    if (Container == INDEX_NONE || Index == INDEX_NONE || Ast.Get(Container).Kind != EGKAstKind::Name) {
+        return false;
+    }
+
+    FStringView ContainerName = Ast.GetValue(Container);
+
+    // dict[Key, Value]
+    if (ContainerName == TEXTVIEW("dict")) {
+        if (Ast.Get(Index).Kind != EGKAstKind::Tuple || Ast.GetChildren(Index).Num() != 2) {
+            return false;
+        }
+
+        FEdGraphPinType Value;
+        if (!Resolve(Ast, Ast.GetChild(Index, 0), PinType) || !Resolve(Ast, Ast.GetChild(Index, 1), Value)) {
+            return false;
+        }
+
+        // Nested containers are not supported by Blueprints
+        if (PinType.IsContainer() || Value.IsContainer()) {
+            return false;
+        }
+
+        PinType.ContainerType = EPinContainerType::Map;
+        PinType.PinValueType = FEdGraphTerminalType::FromPinType(Value);
+        return true;
+    }
+
+    EPinContainerType ContainerType = EPinContainerType::None;
+    if (ContainerName == TEXTVIEW("list")) {
+        ContainerType = EPinContainerType::Array;
+    }
+    else if (ContainerName == TEXTVIEW("set")) {
+        ContainerType = EPinContainerType::Set;
+    }
+
+    if (ContainerType == EPinContainerType::None || !Resolve(Ast, Index, PinType) || PinType.IsContainer()) {
+        return false;
+    }
+
+    PinType.ContainerType = ContainerType;
+    return true;
+}
+
+bool FGKPinTypeResolver::Resolve(FGKScriptAst const& Ast, int32 Annotation, FEdGraphPinType& PinType) {
+    if (Annotation == INDEX_NONE) {
+        return false;
+    }
+
+    switch (Ast.Get(Annotation).Kind) {
+    case EGKAstKind::Name:
+        return ResolveTerminal(Ast.GetValue(Annotation), PinType);
+
+    case EGKAstKind::Subscript:
+        return ResolveContainer(Ast, Annotation, PinType);
+
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,101 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Unreal Engine
+#include "CoreMinimal.h"
+#include "EdGraph/EdGraphPin.h"
+#include "Misc/ScopeRWLock.h"
+
+struct FGKScriptAst;
+
+
+// Identity of a pin type as far as its name is concerned
+struct FGKPinTypeKey {
+    FGKPinTypeKey(FEdGraphPinType const& PinType);
+
+    bool operator== (FGKPinTypeKey const& Other) const;
+
+    friend uint32 GetTypeHash(FGKPinTypeKey const& Key) {
+        return Key.Hash;
+    }
+
+    FName                   Category;
+    TWeakObjectPtr<UObject> SubCategoryObject;
+    EPinContainerType       ContainerType;
+    FName                   ValueCategory;
+    TWeakObjectPtr<UObject> ValueSubCategoryObject;
+    uint32                  Hash;
+};
+
+
+/*! Interned type names for pin types
+ *
+ * Names are computed once per distinct pin type and live for the whole session,
+ * the returned references can be kept around by the callers.
+ *
+ * Containers are named the same way annotations are written in scripts:
+ * ``list[Vector]``, ``set[Name]``, ``dict[Name, Actor]``
+ *
+ * .. note::
+ *
+ *    Lookups are thread safe, the table is shared by all transforms
+ */
+struct FGKPinTypeNames {
+    static FGKPinTypeNames& Get();
+
+    FString const& GetName(FEdGraphPinType const& PinType);
+
+    FName GetFName(FEdGraphPinType const& PinType);
+
+private:
+    struct FEntry {
+        FString Name;
+        FName   Interned;
+    };
+
+    FEntry const& FindOrAdd(FEdGraphPinType const& PinType);
+
+    static FString MakeName(FEdGraphPinType const& PinType);
+
+    FRWLock                                    Lock;
+    TMap<FGKPinTypeKey, TUniquePtr<FEntry>>    Entries;    // Entries are heap allocated so references
+                                                           // survive a rehash of the map
+};
+
+
+/*! Pin types from script annotations, the inverse of FGKPinTypeNames
+ *
+ * Terminal types are memoized by name for the whole session, the builtin categories
+ * are registered up front and every other name is resolved once through FGKReflectionIndex.
+ * Containers are composed from their terminals: ``list[Vector]`` is one lookup.
+ *
+ * Entries whose class or struct was garbage collected, after a Blueprint recompile,
+ * are resolved again on the next lookup.
+ *
+ * .. note::
+ *
+ *    Like the reflection index, it is used on the game thread
+ */
+struct FGKPinTypeResolver {
+    static FGKPinTypeResolver& Get();
+
+    // Annotation is a Name, or a Subscript for containers
+    bool Resolve(FGKScriptAst const& Ast, int32 Annotation, FEdGraphPinType& PinType);
+
+    bool ResolveTerminal(FStringView Name, FEdGraphPinType& PinType);
+
+    // Names that did not resolve are looked up again, a new Blueprint can define them
+    void ForgetUnresolved();
+
+    void Reset();
+
+private:
+    FGKPinTypeResolver();
+
+    void AddBuiltins();
+
+    bool ResolveContainer(FGKScriptAst const& Ast, int32 Annotation, FEdGraphPinType& PinType);
+
+    TMap<FName, FEdGraphPinType> Terminals;    // Unknown names are stored with no category
+};
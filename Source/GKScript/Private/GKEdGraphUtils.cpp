@@ -3,6 +3,9 @@
 // Include
 #include "GKEdGraphUtils.h"
 
+// Gamekit
+#include "GKScriptStats.h"
+
 // Unreal Engine
 #include "K2Node.h"
 
@@ -62,21 +65,22 @@ UK2Node* FindNextExecutionNode(UK2Node* Node) {
 }
 
 
+bool IsRoot(UK2Node* Node) {
+    // Roots do not have input pints
+    if ((Node->GetThenPin() != nullptr && Node->GetExecPin() == nullptr)) {
+        return true;
+    }
+
+    return Node->IsA<UK2Node_EnhancedInputAction>();
+}
+
 TArray<UK2Node*> FindRoots(UEdGraph* Graph) {
+    GKSCRIPT_SCOPE(STAT_GKScript_FindRoots);
     TArray<UK2Node*> Roots;
 
     for (UEdGraphNode* GraphNode : Graph->Nodes) {
         auto K2Node = Cast<UK2Node>(GraphNode);
-        if (K2Node == nullptr) {
-            continue;
-        }
-
-        // Roots do not have input pints
-        if ((K2Node->GetThenPin() != nullptr && K2Node->GetExecPin() == nullptr)) {
-            Roots.Add(K2Node);
-        }
-
-        if (UK2Node_EnhancedInputAction* Action = Cast<UK2Node_EnhancedInputAction>(K2Node)) {
+        if (K2Node != nullptr && IsRoot(K2Node)) {
             Roots.Add(K2Node);
         }
     }
@@ -84,27 +88,36 @@ TArray<UK2Node*> FindRoots(UEdGraph* Graph) {
     return Roots;
 }
 
-FString Join(FString Sep, TArray<FString> Strings) {
+template <typename StringType>
+FString JoinStrings(FStringView Sep, TArrayView<const StringType> Strings) {
     int Size = Sep.Len() * (Strings.Num() - 1);
 
-    for (FString& String : Strings) {
+    for (StringType const& String : Strings) {
         Size += String.Len();
     }
 
     FString Result;
     Result.Reserve(Size);
 
-    for (int i = 0; i < Strings.Num() - 1; i++) {
-        Result += Strings[i];
-        Result += Sep;
-    }
+    for (int i = 0; i < Strings.Num(); i++) {
+        if (i > 0) {
+            Result.Append(Sep.GetData(), Sep.Len());
+        }
 
-    if (Strings.Num() >= 1) {
-        Result += Strings[Strings.Num() - 1];
+        FStringView String = Strings[i];
+        Result.Append(String.GetData(), String.Len());
     }
     return Result;
 }
 
+FString Join(FStringView Sep, TArray<FString> const& Strings) {
+    return JoinStrings<FString>(Sep, Strings);
+}
+
+FString Join(FStringView Sep, TArrayView<const FStringView> Strings) {
+    return JoinStrings<FStringView>(Sep, Strings);
+}
+
 int CountInputPins(TArray<UEdGraphPin*> const& Pins) {
     int Count = 0;
     for (auto Pin : Pins) {
@@ -11,8 +11,13 @@ void GetNodeOutputs(class UK2Node* Node, TArray<FString>& Outs);
 
 UK2Node* FindNextExecutionNode(UK2Node* Node);
 
+// Node without an input exec pin the traversal starts from
+bool IsRoot(class UK2Node* Node);
+
 TArray<class UK2Node*> FindRoots(class UEdGraph* Graph);
 
-FString Join(FString Sep, TArray<FString> Strings);
+FString Join(FStringView Sep, TArray<FString> const& Strings);
+
+FString Join(FStringView Sep, TArrayView<const FStringView> Strings);
 
 int CountInputPins(TArray<class UEdGraphPin*> const& Pins);
@@ -4,6 +4,9 @@
 
 // Gamekit
 #include "GKScript.h"
+#include "GKScriptStats.h"
+#include "GKEdGraphNumbering.h"
+#include "GKEdGraphUtils.h"
 
 // Unreal Engine
 #include "K2Node.h"
@@ -25,10 +28,8 @@
 #include "K2Node_IfThenElse.h"
 #include "K2Node_VariableSet.h"
 #include "K2Node_PromotableOperator.h"
+#include "HAL/PlatformTime.h"
 
-template <typename Impl, typename Return, typename... Args>
-struct FGKEdGraphVisitor {
-    
 #define UK2NODES(NODE)\
     NODE(CallFunction)\
     NODE(VariableGet)\
@@ -48,6 +49,12 @@ struct FGKEdGraphVisitor {
     NODE(VariableSet)\
     NODE(PromotableOperator)
 
+// Emission time per node kind, inclusive of the nodes visited from it
+UK2NODES(GKSCRIPT_DECLARE_NODE_STAT)
+
+template <typename Impl, typename Return, typename... Args>
+struct FGKEdGraphVisitor {
+
     enum class NodeKind {
         Unknown,
         // Generate Node Enums
@@ -100,13 +107,45 @@ struct FGKEdGraphVisitor {
                 }
             
             } else {
-                ExecGraphNode(Node, args...);
+                ExecNext(Node, args...);
             }
         }
 
         return Return();
     }
 
+    // Continue the traversal with the next node of the execution thread.
+    // Queued behind the node being traversed during a slice
+    Return ExecNext(UEdGraphNode* Node, Args... args) {
+        if (Node == nullptr) {
+            return Return();
+        }
+
+        UK2Node* K2Node = Cast<UK2Node>(Node);
+        if (!bDeferExec || K2Node == nullptr) {
+            return ExecGraphNode(Node, args...);
+        }
+
+        FGKExecWork& Work = ExecQueue.AddDefaulted_GetRef();
+        Work.Node = K2Node;
+        Work.Arguments = TTuple<Args...>(args...);
+        Work.State = static_cast<Impl&>(*this).GetExecState();
+        return Return();
+    }
+
+    // Run Func once the nodes queued before it are traversed, at once outside of a slice
+    template <typename FuncType>
+    void Defer(FuncType&& Func) {
+        if (!bDeferExec) {
+            Func();
+            return;
+        }
+
+        FGKExecWork& Work = ExecQueue.AddDefaulted_GetRef();
+        Work.Resume = Forward<FuncType>(Func);
+        Work.State = static_cast<Impl&>(*this).GetExecState();
+    }
+
     Return ExecGraphNode(UEdGraphNode* Node, Args... args) { 
         UK2Node* K2Node = Cast<UK2Node>(Node);
 
@@ -161,6 +200,8 @@ struct FGKEdGraphVisitor {
         #define NODE(Name)\
             case NodeKind::Name: {\
                 if (auto NodeCast = Cast<UK2Node_##Name>(Node)) {\
+                    GKSCRIPT_SCOPE(STAT_GKScript_Node_##Name);\
+                    INC_DWORD_STAT(STAT_GKScript_NodesEmitted);\
                     GKSCRIPT_VERBOSE(TEXT("%s+-> %s"), *GetDepthViz(), TEXT(#Name))\
                     return static_cast<Impl&>(*this).Name(NodeCast, args...);\
                 }\
@@ -195,7 +236,189 @@ struct FGKEdGraphVisitor {
     #undef NODE
     // clang-format on
 
-    int Depth = 0;
-    TSet<UEdGraphNode*> PreviousNodes;
+    // Number the graph before traversing it, resets the per node state
+    void BeginGraph(UEdGraph* Graph) {
+        OwnedNumbering.Build(Graph);
+        BeginGraph(OwnedNumbering);
+    }
+
+    // Traverse a graph numbered by another visitor
+    void BeginGraph(FGKGraphNumbering const& GraphNumbering) {
+        Numbering = &GraphNumbering;
+        static_cast<Impl&>(*this).ResetTraversal();
+    }
+
+    // The roots of a graph share the per node state, a node reached from two roots is visited once
+    void ResetTraversal() {
+        PreviousNodes.Init(false, Numbering->NumNodes());
+        ExternalNodes.Reset();
+    }
+
+    // Returns true if the node was already visited, marks it as visited otherwise
+    bool MarkVisited(UEdGraphNode* Node) {
+        int32 Id = Numbering->GetNodeId(Node);
+
+        // Nodes of macros and collapsed graphs are still protected against loops
+        if (Id == INDEX_NONE) {
+            bool bVisited = false;
+            ExternalNodes.Add(Node, &bVisited);
+            return bVisited;
+        }
+
+        bool bVisited = PreviousNodes[Id];
+        PreviousNodes[Id] = true;
+        return bVisited;
+    }
+
+    // State of the implementation restored before a queued node runs
+    int32 GetExecState() const {
+        return 0;
+    }
+
+    void SetExecState(int32 State) {}
+
+    // Time sliced traversal
+    // ---------------------
+    //
+    // Nodes are the unit of work, a slice traverses nodes until its deadline
+    // and the next slice resumes from the first node left.
+    // Used on the game thread, where a whole graph could take more than a frame.
+    //
+    // The graph is numbered and its roots are found node by node, then the nodes
+    // are traversed from an explicit stack instead of recursing along the execution thread:
+    // the nodes a node continues to (ExecNext) and the work it defers (Defer)
+    // are queued in order, and pushed on top of the stack once it returns.
+    // Nodes deleted between two slices are skipped and flagged in bStaleNodes
+    void BeginSlicedGraph(UEdGraph* Graph, Args... args) {
+        OwnedNumbering.BeginBuild(Graph);
+
+        SlicedGraph = Graph;
+        SlicePhase = ESlicePhase::Numbering;
+        SliceCursor = 0;
+        SliceArguments = TTuple<Args...>(args...);
+        SliceState = static_cast<Impl&>(*this).GetExecState();
+        ExecStack.Reset();
+        ExecQueue.Reset();
+        bStaleNodes = false;
+    }
+
+    // Returns true once every node was traversed, EndTime is in FPlatformTime::Seconds
+    bool ExecSlice(double EndTime) {
+        Impl& Visitor = static_cast<Impl&>(*this);
+
+        while (true) {
+            switch (SlicePhase) {
+            case ESlicePhase::Numbering:
+                if (!OwnedNumbering.BuildSlice(EndTime)) {
+                    return false;
+                }
+                BeginGraph(OwnedNumbering);
+                SlicePhase = ESlicePhase::Roots;
+                break;
+
+            case ESlicePhase::Roots: {
+                UEdGraph* Graph = SlicedGraph.Get();
+                if (Graph == nullptr || SliceCursor >= Graph->Nodes.Num()) {
+                    FlushExecQueue();
+                    SlicePhase = ESlicePhase::Exec;
+                    break;
+                }
+
+                UK2Node* Node = Cast<UK2Node>(Graph->Nodes[SliceCursor]);
+                SliceCursor += 1;
+
+                if (Node != nullptr && IsRoot(Node)) {
+                    FGKExecWork& Work = ExecQueue.AddDefaulted_GetRef();
+                    Work.Node = Node;
+                    Work.Arguments = SliceArguments;
+                    Work.State = SliceState;
+                }
+                break;
+            }
+
+            default: {
+                if (ExecStack.Num() == 0) {
+                    Visitor.SetExecState(SliceState);
+                    return true;
+                }
+
+                FGKExecWork Work = ExecStack.Pop(false);
+                Visitor.SetExecState(Work.State);
+
+                bDeferExec = true;
+                if (Work.Resume) {
+                    Work.Resume();
+                } else if (UK2Node* Node = Work.Node.Get()) {
+                    Work.Arguments.ApplyAfter([this](UK2Node* Next, Args... A) { Exec(Next, A...); }, Node);
+                } else {
+                    bStaleNodes = true;
+                }
+                bDeferExec = false;
+
+                FlushExecQueue();
+                break;
+            }
+            }
+
+            if (FPlatformTime::Seconds() >= EndTime) {
+                Visitor.SetExecState(SliceState);
+                return false;
+            }
+        }
+    }
+
+    // Drop the nodes left, the deferred work still runs to unwind the state it holds
+    void AbortSlice() {
+        Impl& Visitor = static_cast<Impl&>(*this);
+
+        while (ExecStack.Num() > 0) {
+            FGKExecWork Work = ExecStack.Pop(false);
+
+            if (Work.Resume) {
+                Visitor.SetExecState(Work.State);
+                Work.Resume();
+            }
+        }
+
+        Visitor.SetExecState(SliceState);
+        bStaleNodes = true;
+    }
+
+    // The first work queued ends up on top
+    void FlushExecQueue() {
+        for (int32 i = ExecQueue.Num() - 1; i >= 0; i--) {
+            ExecStack.Push(MoveTemp(ExecQueue[i]));
+        }
+        ExecQueue.Reset();
+    }
+
+    enum class ESlicePhase : uint8 {
+        Numbering,
+        Roots,
+        Exec
+    };
+
+    // A node to traverse or deferred work
+    struct FGKExecWork {
+        TWeakObjectPtr<UK2Node>  Node;
+        TFunction<void()>        Resume;
+        TTuple<Args...>          Arguments;
+        int32                    State = 0;     // GetExecState when it was queued
+    };
+
+    int                      Depth = 0;
+    TWeakObjectPtr<UEdGraph> SlicedGraph;          // Graph of the sliced traversal
+    ESlicePhase              SlicePhase = ESlicePhase::Numbering;
+    int32                    SliceCursor = 0;      // Next node of the graph to check for roots
+    TTuple<Args...>          SliceArguments;       // Passed to the roots
+    int32                    SliceState = 0;       // GetExecState when the sliced traversal started
+    TArray<FGKExecWork>      ExecStack;            // Work left, the top runs next, kept across frames
+    TArray<FGKExecWork>      ExecQueue;            // Work queued by the node being traversed
+    bool                     bDeferExec = false;   // Set while a slice traverses a node
+    bool                     bStaleNodes = false;  // A node was deleted during the sliced traversal
+    FGKGraphNumbering const* Numbering = nullptr;  // Node & Pin ids of the graph being traversed
+    FGKGraphNumbering        OwnedNumbering;       // Numbering built by this visitor
+    TBitArray<>              PreviousNodes;        // Visited nodes, indexed by node id
+    TSet<UEdGraphNode*>      ExternalNodes;        // Visited nodes outside of the numbered graph
 };
 
@@ -0,0 +1,373 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKFunctionCache.h"
+
+// Gamekit
+#include "GKScript.h"
+#include "GKScriptStats.h"
+
+// Unreal Engine
+#include "EdGraph/EdGraph.h"
+#include "EdGraph/EdGraphNode.h"
+#include "EdGraph/EdGraphPin.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Hash/CityHash.h"
+#include "K2Node_CallFunction.h"
+#include "K2Node_DynamicCast.h"
+#include "K2Node_EnhancedInputAction.h"
+#include "K2Node_Event.h"
+#include "K2Node_FunctionTerminator.h"
+#include "K2Node_MacroInstance.h"
+#include "K2Node_Variable.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Tasks/Task.h"
+
+
+namespace {
+
+const uint32 GKFunctionCacheMagic = 0x43464B47;    // GKFC
+
+// Bump when the generated code changes
+const uint32 GKFunctionCacheFormat = 3;
+
+TAutoConsoleVariable<int32> CVarGKScriptFunctionCacheMaxMB(
+    TEXT("GKScript.FunctionCacheMaxMB"),
+    256,
+    TEXT("Size of the on disk function cache, in MiB, least recently used entries are evicted past it"),
+    ECVF_Default
+);
+
+uint64 Combine(uint64 Hash, uint64 Value) {
+    return CityHash128to64({Hash, Value});
+}
+
+uint64 HashString(FStringView Value) {
+    return CityHash64((const char*)Value.GetData(), Value.Len() * sizeof(TCHAR));
+}
+
+uint64 HashName(FName Name) {
+    return HashString(Name.ToString());
+}
+
+uint64 HashObject(UObject const* Object) {
+    return Object ? HashString(Object->GetPathName()) : 0;
+}
+
+uint64 HashMember(FMemberReference const& Reference) {
+    uint64 Hash = HashName(Reference.GetMemberName());
+    return Combine(Hash, HashObject(Reference.GetMemberParentClass()));
+}
+
+// What the node does, independently of where it is
+uint64 HashTarget(UEdGraphNode* Node) {
+    if (UK2Node_CallFunction* Call = Cast<UK2Node_CallFunction>(Node)) {
+        return HashMember(Call->FunctionReference);
+    }
+    if (UK2Node_Event* Event = Cast<UK2Node_Event>(Node)) {
+        return Combine(HashMember(Event->EventReference), HashName(Event->CustomFunctionName));
+    }
+    if (UK2Node_FunctionTerminator* Terminator = Cast<UK2Node_FunctionTerminator>(Node)) {
+        return HashMember(Terminator->FunctionReference);
+    }
+    if (UK2Node_Variable* Variable = Cast<UK2Node_Variable>(Node)) {
+        return HashMember(Variable->VariableReference);
+    }
+    if (UK2Node_DynamicCast* Cast = ::Cast<UK2Node_DynamicCast>(Node)) {
+        return HashObject(Cast->TargetType);
+    }
+    if (UK2Node_EnhancedInputAction* Input = Cast<UK2Node_EnhancedInputAction>(Node)) {
+        return HashObject(Input->InputAction);
+    }
+    if (UK2Node_MacroInstance* Macro = Cast<UK2Node_MacroInstance>(Node)) {
+        return HashObject(Macro->GetMacroGraph());
+    }
+    return 0;
+}
+
+uint64 HashPin(UEdGraphPin* Pin) {
+    FEdGraphPinType const& Type = Pin->PinType;
+
+    uint64 Hash = HashName(Pin->PinName);
+    Hash = Combine(Hash, uint64(Pin->Direction));
+    Hash = Combine(Hash, HashName(Type.PinCategory));
+    Hash = Combine(Hash, HashName(Type.PinSubCategory));
+    Hash = Combine(Hash, HashObject(Type.PinSubCategoryObject.Get()));
+    Hash = Combine(Hash, uint64(Type.ContainerType));
+    Hash = Combine(Hash, HashName(Type.PinValueType.TerminalCategory));
+    Hash = Combine(Hash, HashObject(Type.PinValueType.TerminalSubCategoryObject.Get()));
+
+    // Literals, only unconnected inputs use them
+    Hash = Combine(Hash, HashString(Pin->DefaultValue));
+    Hash = Combine(Hash, HashObject(Pin->DefaultObject));
+    Hash = Combine(Hash, HashString(Pin->DefaultTextValue.ToString()));
+    return Hash;
+}
+
+} // namespace
+
+
+uint64 FGKGraphHash::HashNode(UEdGraphNode* Node) {
+    uint64 Hash = HashObject(Node->GetClass());
+    Hash = Combine(Hash, HashTarget(Node));
+
+    for (UEdGraphPin* Pin : Node->Pins) {
+        Hash = Combine(Hash, HashPin(Pin));
+    }
+    return Hash;
+}
+
+uint64 FGKGraphHash::Hash(UEdGraph* Graph, TFunctionRef<uint64(UEdGraphNode*)> Extra) {
+    FGKGraphHasher Hasher;
+    Hasher.Begin(Graph, [&Extra](UEdGraphNode* Node) { return Extra(Node); });
+    Hasher.Slice(MAX_dbl);
+    return Hasher.GetHash();
+}
+
+
+void FGKGraphHasher::Begin(UEdGraph* InGraph, TFunction<uint64(UEdGraphNode*)> InExtra) {
+    Graph = InGraph;
+    Extra = MoveTemp(InExtra);
+    Restart();
+}
+
+void FGKGraphHasher::Restart() {
+    UEdGraph* Source = Graph.Get();
+
+    GraphNodes = Source ? Source->Nodes.Num() : 0;
+    Cursor = 0;
+    Round = INDEX_NONE;
+    Distinct = 0;
+    Nodes.Reset();
+    NodeIndices.Reset();
+    Hashes.Reset();
+    Refined.Reset();
+    Result = 0;
+}
+
+bool FGKGraphHasher::Slice(double EndTime) {
+    UEdGraph* Source = Graph.Get();
+    if (Source == nullptr) {
+        return true;
+    }
+
+    if (Source->Nodes.Num() != GraphNodes) {
+        Restart();
+    }
+
+    // First pass, each node on its own
+    while (Round == INDEX_NONE) {
+        if (Cursor >= Source->Nodes.Num()) {
+            TSet<uint64> Unique(Hashes);
+            Distinct = Unique.Num();
+            Round = 0;
+            Cursor = 0;
+            break;
+        }
+
+        UEdGraphNode* Node = Source->Nodes[Cursor];
+        Cursor += 1;
+
+        if (Node != nullptr) {
+            NodeIndices.Add(Node, Nodes.Num());
+            Nodes.Add(Node);
+            Hashes.Add(Combine(FGKGraphHash::HashNode(Node), Extra(Node)));
+        }
+
+        if (FPlatformTime::Seconds() >= EndTime) {
+            return false;
+        }
+    }
+
+    // Refine the hashes from the links, a round reaches one node further.
+    // Once a round does not tell more nodes apart the next ones would not either
+    while (Round < Nodes.Num()) {
+        if (Cursor < Nodes.Num()) {
+            UEdGraphNode* Node = Nodes[Cursor].Get();
+
+            // Replaced by another node between two slices, the next slice starts over
+            if (Node == nullptr) {
+                Restart();
+                return false;
+            }
+
+            Links.Reset();
+            for (UEdGraphPin* Pin : Node->Pins) {
+                uint64 From = HashName(Pin->PinName);
+
+                for (UEdGraphPin* Linked : Pin->LinkedTo) {
+                    int32 const* To = NodeIndices.Find(Linked->GetOwningNode());
+                    if (To == nullptr) {
+                        continue;
+                    }
+                    Links.Add(Combine(From, Combine(Hashes[*To], HashName(Linked->PinName))));
+                }
+            }
+
+            Links.Sort();
+
+            uint64 Hash = Hashes[Cursor];
+            for (uint64 Link : Links) {
+                Hash = Combine(Hash, Link);
+            }
+            Refined.Add(Hash);
+            Cursor += 1;
+
+            if (FPlatformTime::Seconds() >= EndTime) {
+                return false;
+            }
+            continue;
+        }
+
+        int32 Before = Distinct;
+        TSet<uint64> Unique(Refined);
+        Distinct = Unique.Num();
+
+        Swap(Hashes, Refined);
+        Refined.Reset();
+        Cursor = 0;
+        Round += 1;
+
+        if (Distinct <= Before) {
+            break;
+        }
+    }
+
+    TArray<uint64> Sorted = Hashes;
+    Sorted.Sort();
+
+    Result = (uint64(GKFunctionCacheMagic) << 32) | GKFunctionCacheFormat;
+    for (uint64 Hash : Sorted) {
+        Result = Combine(Result, Hash);
+    }
+
+    // Done, later slices return the same result
+    Graph = nullptr;
+    return true;
+}
+
+
+FGKFunctionCache& FGKFunctionCache::Get() {
+    static FGKFunctionCache Cache;
+    return Cache;
+}
+
+FGKFunctionCache::FGKFunctionCache() {
+    CacheDir = FPaths::ProjectSavedDir() / TEXT("GKScript") / TEXT("FunctionCache");
+}
+
+FString FGKFunctionCache::GetPath(uint64 Key) const {
+    return CacheDir / FString::Printf(TEXT("%016llx.gkfn"), Key);
+}
+
+bool FGKFunctionCache::Load(uint64 Key, FGKFunctionCacheEntry& Entry) const {
+    GKSCRIPT_SCOPE(STAT_GKScript_FunctionCache);
+    FString Path = GetPath(Key);
+
+    TArray<uint8> Bytes;
+    if (!IFileManager::Get().FileExists(*Path) || !FFileHelper::LoadFileToArray(Bytes, *Path)) {
+        return false;
+    }
+
+    FMemoryReader Reader(Bytes);
+    uint32 Magic = 0;
+    uint32 Format = 0;
+    uint64 StoredKey = 0;
+    Reader << Magic << Format << StoredKey;
+
+    if (Magic != GKFunctionCacheMagic || Format != GKFunctionCacheFormat || StoredKey != Key) {
+        return false;
+    }
+
+    Reader << Entry.Text;
+    Reader << Entry.Variables;
+
+    // A corrupted entry is a miss, not a crash
+    if (Reader.IsError()) {
+        return false;
+    }
+
+    // Entries are evicted least recently used first
+    IFileManager::Get().SetTimeStamp(*Path, FDateTime::UtcNow());
+    return true;
+}
+
+void FGKFunctionCache::Trim() const {
+    GKSCRIPT_SCOPE(STAT_GKScript_FunctionCache);
+    int64 MaxBytes = int64(FMath::Max(CVarGKScriptFunctionCacheMaxMB.GetValueOnAnyThread(), 0)) * 1024 * 1024;
+
+    struct FEntry {
+        FString   Path;
+        FDateTime TimeStamp;
+        int64     Size;
+    };
+
+    TArray<FEntry> Entries;
+    int64 Total = 0;
+
+    IFileManager::Get().IterateDirectoryStat(*CacheDir, [&](const TCHAR* Path, FFileStatData const& Stat) {
+        if (!Stat.bIsDirectory && FStringView(Path).EndsWith(TEXT(".gkfn"))) {
+            Entries.Add({Path, Stat.ModificationTime, Stat.FileSize});
+            Total += Stat.FileSize;
+        }
+        return true;
+    });
+
+    if (Total <= MaxBytes) {
+        return;
+    }
+
+    Entries.Sort([](FEntry const& A, FEntry const& B) {
+        return A.TimeStamp < B.TimeStamp;
+    });
+
+    int32 NumEvicted = 0;
+    for (FEntry const& Entry : Entries) {
+        if (Total <= MaxBytes) {
+            break;
+        }
+        if (IFileManager::Get().Delete(*Entry.Path, false, false, true)) {
+            Total -= Entry.Size;
+            NumEvicted += 1;
+        }
+    }
+    GKSCRIPT_LOG(TEXT("Evicted %d function cache entries, %.1f MiB left"), NumEvicted, Total / (1024.0 * 1024.0));
+}
+
+void FGKFunctionCache::TrimAsync() const {
+    UE::Tasks::Launch(UE_SOURCE_LOCATION, [this]() {
+        Trim();
+    });
+}
+
+bool FGKFunctionCache::Store(uint64 Key, FGKFunctionCacheEntry const& Entry) const {
+    GKSCRIPT_SCOPE(STAT_GKScript_FunctionCache);
+    TArray<uint8> Bytes;
+    FMemoryWriter Writer(Bytes);
+
+    uint32 Magic = GKFunctionCacheMagic;
+    uint32 Format = GKFunctionCacheFormat;
+    Writer << Magic << Format << Key;
+    Writer << const_cast<FGKFunctionCacheEntry&>(Entry).Text;
+    Writer << const_cast<FGKFunctionCacheEntry&>(Entry).Variables;
+
+    // Readers never see a partial file
+    FString Path = GetPath(Key);
+    FString TempPath = FString::Printf(TEXT("%s.%u.%u.tmp"), *Path, FPlatformProcess::GetCurrentProcessId(), FPlatformTLS::GetCurrentThreadId());
+
+    if (!FFileHelper::SaveArrayToFile(Bytes, *TempPath)) {
+        GKSCRIPT_WARNING(TEXT("Could not write %s"), *TempPath);
+        return false;
+    }
+
+    if (!IFileManager::Get().Move(*Path, *TempPath, true, true, false, true)) {
+        IFileManager::Get().Delete(*TempPath, false, false, true);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Unreal Engine
+#include "CoreMinimal.h"
+
+class UEdGraph;
+class UEdGraphNode;
+
+
+/*! Structural hash of a graph
+ *
+ * Each node is hashed from its kind, its target (function, variable, event, cast, macro)
+ * and its pins: name, direction, type and default value.
+ * Node hashes are then refined from their links, each round mixes in the sorted
+ * (pin name, linked node hash, linked pin name) of every link, until the rounds stop
+ * telling nodes apart. A node hash ends up covering everything reachable from it,
+ * two identical nodes leading to different code hash differently.
+ *
+ * Node hashes are sorted before being combined so the hash does not depend on the order
+ * of the nodes, their GUIDs, their position nor the Blueprint the graph belongs to.
+ *
+ * Two copies of the same helper hash to the same value, changing any node, default or link
+ * changes the hash of the graph.
+ */
+struct FGKGraphHash {
+    // Extra is mixed in the hash of every node, for state outside the graph that changes the output
+    static uint64 Hash(UEdGraph* Graph, TFunctionRef<uint64(UEdGraphNode*)> Extra);
+
+    static uint64 HashNode(UEdGraphNode* Node);
+};
+
+
+/*! Resumable FGKGraphHash::Hash, for the game thread
+ *
+ * Hashes a node per step, in the first pass and in every refinement round.
+ * Nodes are only reached through weak pointers between two slices,
+ * the hash starts over if the graph lost or gained nodes in between.
+ */
+struct FGKGraphHasher {
+    void Begin(UEdGraph* Graph, TFunction<uint64(UEdGraphNode*)> Extra);
+
+    // Returns true once the hash is complete, EndTime is in FPlatformTime::Seconds
+    bool Slice(double EndTime);
+
+    uint64 GetHash() const {
+        return Result;
+    }
+
+private:
+    void Restart();
+
+    TWeakObjectPtr<UEdGraph>              Graph;
+    TFunction<uint64(UEdGraphNode*)>      Extra;
+    int32                                 GraphNodes = 0;       // Nodes of the graph when the hash started
+    int32                                 Cursor = 0;           // Next node of the pass
+    int32                                 Round = INDEX_NONE;   // Refinement round, none during the first pass
+    int32                                 Distinct = 0;         // Distinct hashes after the last pass
+    TArray<TWeakObjectPtr<UEdGraphNode>>  Nodes;
+    TMap<UEdGraphNode const*, int32>      NodeIndices;          // Keys are never dereferenced
+    TArray<uint64>                        Hashes;               // By node index
+    TArray<uint64>                        Refined;              // Hashes of the round in progress
+    TArray<uint64>                        Links;
+    uint64                                Result = 0;
+};
+
+
+struct FGKFunctionCacheEntry {
+    TArray<ANSICHAR>                Text;
+    TArray<FString>                 Variables;  // Names the graph added to the enclosing scope
+};
+
+
+/*! On disk cache of generated code, keyed by graph hash
+ *
+ * Entries are stored in ``Saved/GKScript/FunctionCache``, one file per graph hash,
+ * the cache is shared by every Blueprint and kept between runs.
+ * It is trimmed to ``GKScript.FunctionCacheMaxMB`` when a generation starts, least recently used first.
+ *
+ * Entries are written to a temporary file and renamed, the cache can be used
+ * from several threads and processes at once.
+ */
+class FGKFunctionCache
+{
+    public:
+    static FGKFunctionCache& Get();
+
+    bool Load(uint64 Key, FGKFunctionCacheEntry& Entry) const;
+
+    bool Store(uint64 Key, FGKFunctionCacheEntry const& Entry) const;
+
+    // Evict the least recently used entries until the cache fits its budget
+    void Trim() const;
+
+    // Trim on a worker, the editor does not wait on the file system
+    void TrimAsync() const;
+
+    FString GetPath(uint64 Key) const;
+
+    FString CacheDir;
+
+    private:
+    FGKFunctionCache();
+};
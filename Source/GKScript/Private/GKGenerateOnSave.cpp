@@ -0,0 +1,226 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKGenerateOnSave.h"
+
+// Gamekit
+#include "GKBackgroundWrite.h"
+#include "GKFunctionCache.h"
+#include "GKScript.h"
+#include "GKScriptStats.h"
+
+// Unreal Engine
+#include "Engine/Blueprint.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectHash.h"
+
+
+namespace {
+
+TAutoConsoleVariable<bool> CVarGKScriptGenerateOnSave(
+    TEXT("GKScript.GenerateOnSave"),
+    true,
+    TEXT("Regenerate the code of Blueprints when their package is saved"),
+    ECVF_Default
+);
+
+TAutoConsoleVariable<float> CVarGKScriptSaveDebounceSeconds(
+    TEXT("GKScript.SaveDebounceSeconds"),
+    2.f,
+    TEXT("Minimum time between two generations of the same Blueprint on save, saves in between are coalesced"),
+    ECVF_Default
+);
+
+} // namespace
+
+
+FGKGenerateOnSave& FGKGenerateOnSave::Get() {
+    static FGKGenerateOnSave GenerateOnSave;
+    return GenerateOnSave;
+}
+
+void FGKGenerateOnSave::Register() {
+    SavedHandle = UPackage::PackageSavedWithContextEvent.AddRaw(this, &FGKGenerateOnSave::OnPackageSaved);
+}
+
+void FGKGenerateOnSave::Unregister() {
+    UPackage::PackageSavedWithContextEvent.Remove(SavedHandle);
+    SavedHandle.Reset();
+
+    FTSTicker::GetCoreTicker().RemoveTicker(WakeHandle);
+    WakeHandle.Reset();
+
+    Job.Reset();
+    Transform.Reset();
+    Pending.Reset();
+}
+
+void FGKGenerateOnSave::OnPackageSaved(FString const& PackageFileName, UPackage* Package, FObjectPostSaveContext Context) {
+    if (!CVarGKScriptGenerateOnSave.GetValueOnGameThread() || IsRunningCommandlet()) {
+        return;
+    }
+
+    // Autosaves and cooks do not touch the mirror
+    if (Context.IsProceduralSave() || (Context.GetSaveFlags() & SAVE_FromAutosave) != 0) {
+        return;
+    }
+
+    UBlueprint* Blueprint = nullptr;
+    ForEachObjectWithPackage(Package, [&Blueprint](UObject* Object) {
+        Blueprint = Cast<UBlueprint>(Object);
+        return Blueprint == nullptr;
+    }, false);
+
+    if (Blueprint && Blueprint->GeneratedClass) {
+        Enqueue(Blueprint);
+    }
+}
+
+void FGKGenerateOnSave::Enqueue(UBlueprint* Blueprint) {
+    FName PackageName = Blueprint->GetOutermost()->GetFName();
+    double Now = FPlatformTime::Seconds();
+    double Window = FMath::Max(CVarGKScriptSaveDebounceSeconds.GetValueOnGameThread(), 0.f);
+
+    // Wait for the save storm to settle, and never generate twice in the same window
+    double DueTime = Now + Window;
+    if (double const* Last = LastGenerated.Find(PackageName)) {
+        DueTime = FMath::Max(DueTime, *Last + Window);
+    }
+
+    FRequest& Request = Pending.FindOrAdd(PackageName);
+    Request.Blueprint = Blueprint;
+    Request.DueTime = DueTime;
+    SET_DWORD_STAT(STAT_GKScript_GenerateOnSaveQueue, Pending.Num());
+
+    Schedule();
+}
+
+void FGKGenerateOnSave::Schedule() {
+    // The running job picks the request up once it is due
+    if (Job.IsValid() && !Job->IsDone()) {
+        return;
+    }
+
+    FTSTicker::GetCoreTicker().RemoveTicker(WakeHandle);
+    WakeHandle.Reset();
+
+    if (Pending.Num() == 0) {
+        return;
+    }
+
+    double DueTime = TNumericLimits<double>::Max();
+    for (TPair<FName, FRequest> const& Item : Pending) {
+        DueTime = FMath::Min(DueTime, Item.Value.DueTime);
+    }
+
+    // Sleep until the first request is due instead of ticking every frame
+    float Delay = float(FMath::Max(DueTime - FPlatformTime::Seconds(), 0.0));
+    WakeHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateRaw(this, &FGKGenerateOnSave::Wake), Delay
+    );
+}
+
+bool FGKGenerateOnSave::Wake(float DeltaTime) {
+    WakeHandle.Reset();
+    FGKFunctionCache::Get().TrimAsync();
+
+    Job = FGKTimeSlicedJob::Start(
+        [this](double EndTime) {
+            return Step(EndTime);
+        },
+        [this](bool bCancelled) {
+            if (!bCancelled) {
+                Schedule();
+            }
+        }
+    );
+    return false;
+}
+
+FName FGKGenerateOnSave::FindDue(double Now) const {
+    FName Due;
+    double DueTime = Now;
+
+    for (TPair<FName, FRequest> const& Item : Pending) {
+        if (Item.Value.DueTime <= DueTime) {
+            Due = Item.Key;
+            DueTime = Item.Value.DueTime;
+        }
+    }
+    return Due;
+}
+
+bool FGKGenerateOnSave::Step(double EndTime) {
+    GKSCRIPT_SCOPE(STAT_GKScript_GenerateOnSave);
+
+    while (true) {
+        if (Transform.IsValid()) {
+            UBlueprint* Blueprint = CurrentBlueprint.Get();
+
+            if (Blueprint == nullptr) {
+                Transform.Reset();
+                continue;
+            }
+
+            // Edited since it was saved, the nodes being traversed might be gone
+            if (Blueprint->GetOutermost()->IsDirty()) {
+                GKSCRIPT_VERBOSE(TEXT("%s: modified during generation, queued again"), *Current.ToString());
+                Transform.Reset();
+                Enqueue(Blueprint);
+                continue;
+            }
+
+            if (!Transform->GenerateSlice(EndTime)) {
+                return false;
+            }
+
+            Transform.Reset();
+            Write(Blueprint);
+            LastGenerated.Add(Current, FPlatformTime::Seconds());
+            INC_DWORD_STAT(STAT_GKScript_GeneratedOnSave);
+
+            if (FPlatformTime::Seconds() >= EndTime) {
+                return false;
+            }
+        }
+
+        FName Next = FindDue(FPlatformTime::Seconds());
+        if (Next.IsNone()) {
+            // Done, the requests left are scheduled once the job finishes
+            return true;
+        }
+
+        FRequest Request = Pending.FindAndRemoveChecked(Next);
+        SET_DWORD_STAT(STAT_GKScript_GenerateOnSaveQueue, Pending.Num());
+
+        UBlueprint* Blueprint = Request.Blueprint.Get();
+        if (Blueprint == nullptr || Blueprint->GeneratedClass == nullptr) {
+            continue;
+        }
+
+        // Not saved yet, wait for another debounce window
+        if (Blueprint->GetOutermost()->IsDirty()) {
+            GKSCRIPT_VERBOSE(TEXT("%s: modified since it was saved, queued again"), *Next.ToString());
+            Enqueue(Blueprint);
+            continue;
+        }
+
+        Current = Next;
+        CurrentBlueprint = Blueprint;
+
+        Output.Reset();
+        Transform = MakeUnique<FGKEdGraphTransform>(Blueprint, Output);
+        Transform->Writer.Write("import unreal\n");
+    }
+}
+
+void FGKGenerateOnSave::Write(UBlueprint* Blueprint) {
+    FString FilePath = FPaths::Combine(FPaths::ProjectContentDir(), Destination, Blueprint->GetName() + TEXT(".us"));
+
+    // Off the game thread, the save already hitched enough.
+    // Writes of the same file land in the order they were generated
+    FGKBackgroundWrite::Get().Write(FilePath, MoveTemp(Output));
+}
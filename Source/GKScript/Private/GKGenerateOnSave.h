@@ -0,0 +1,70 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Gamekit
+#include "GKEdGraphTransform.h"
+#include "GKTimeSlice.h"
+
+// Unreal Engine
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "UObject/ObjectSaveContext.h"
+
+class UBlueprint;
+
+
+/*! Regenerate the code of a Blueprint when its package is saved
+ *
+ * Saves only queue the Blueprint, repeated saves of the same package are coalesced
+ * and a Blueprint is generated at most once per ``GKScript.SaveDebounceSeconds``.
+ * Generation is time sliced on the game thread (``GKScript.TimeSliceMs``),
+ * the file is written by a background task, after the previous write of the same file.
+ * Nothing ticks while the queued requests wait for their debounce window.
+ *
+ * A Blueprint edited before or while it is generated is queued again for another debounce
+ * window, its code is only generated once the package is saved.
+ * ``GKScript.GenerateOnSave 0`` disables it.
+ */
+class FGKGenerateOnSave
+{
+    public:
+    static FGKGenerateOnSave& Get();
+
+    void Register();
+    void Unregister();
+
+    void Enqueue(UBlueprint* Blueprint);
+
+    FString Destination = TEXT("GKScript");
+
+    private:
+    void OnPackageSaved(FString const& PackageFileName, UPackage* Package, FObjectPostSaveContext Context);
+
+    // Start the job when the first request is due
+    void Schedule();
+
+    bool Wake(float DeltaTime);
+
+    bool Step(double EndTime);
+
+    // Earliest request past its debounce window
+    FName FindDue(double Now) const;
+
+    void Write(UBlueprint* Blueprint);
+
+    struct FRequest {
+        TWeakObjectPtr<UBlueprint>  Blueprint;
+        double                      DueTime = 0;
+    };
+
+    TMap<FName, FRequest>               Pending;        // By package name
+    TMap<FName, double>                 LastGenerated;
+    FName                               Current;
+    TWeakObjectPtr<UBlueprint>          CurrentBlueprint;
+    TArray<ANSICHAR>                    Output;         // Written by Transform
+    TUniquePtr<FGKEdGraphTransform>     Transform;
+    TSharedPtr<FGKTimeSlicedJob>        Job;
+    FTSTicker::FDelegateHandle          WakeHandle;
+    FDelegateHandle                     SavedHandle;
+};
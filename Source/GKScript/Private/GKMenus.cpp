@@ -5,7 +5,7 @@
 
 // Gamekit
 #include "GKScript.h"
-#include "GKBlueprintTraverse.h"
+#include "GKAsyncGeneration.h"
 
 // Unreal Engine
 #include "ContentBrowserModule.h"
@@ -15,13 +15,8 @@
 #define LOCTEXT_NAMESPACE "FGKScriptModule"
 
 void GenerateStructsForSelectedBlueprints(const TArray<FAssetData> SelectedAssets, bool bGenerateNativeStruct) {
-	for (const FAssetData& AssetData : SelectedAssets) {
-		UBlueprint* Blueprint = Cast<UBlueprint>(AssetData.GetAsset());
-		if (Blueprint && Blueprint->GeneratedClass)
-		{
-			GeneratePythonFromBlueprint(Blueprint, FString("GKScript"));
-		}
-	}
+	// Loaded and generated in the background, progress and cancel are in the notification
+	FGKAsyncGeneration::Start(SelectedAssets, FString("GKScript"));
 }
 
 void AddBlueprintCodeActionMenu(FMenuBuilder& MenuBuilder, TArray<FAssetData> SelectedAssets) {
@@ -0,0 +1,182 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKPythonInterpreter.h"
+
+// Gamekit
+#include "GKScript.h"
+
+// Python
+#if WITH_PYTHON
+THIRD_PARTY_INCLUDES_START
+PRAGMA_DISABLE_REGISTER_WARNINGS
+extern "C" {
+#    include "Python.h"
+#    include "pyarena.h"
+}
+PRAGMA_ENABLE_REGISTER_WARNINGS
+THIRD_PARTY_INCLUDES_END
+#endif // WITH_PYTHON
+
+
+FGKPythonInterpreter& FGKPythonInterpreter::Get() {
+    static FGKPythonInterpreter Interpreter;
+    return Interpreter;
+}
+
+bool FGKPythonInterpreter::Initialize() {
+#if WITH_PYTHON
+    FScopeLock Lock(&Mutex);
+
+    if (bReady) {
+        return true;
+    }
+
+    // PythonScriptPlugin is already running one
+    if (Py_IsInitialized()) {
+        GKSCRIPT_VERBOSE(TEXT("Reusing the editor python interpreter"));
+        bReady = true;
+        return true;
+    }
+
+    GKSCRIPT_VERBOSE(TEXT("Starting an embedded python interpreter"));
+    Py_InitializeEx(0);
+    bOwnsInterpreter = true;
+
+    // Release the GIL, every user goes through FGKPythonGIL
+    MainThreadState = PyEval_SaveThread();
+    bReady = true;
+    return true;
+#else
+    GKSCRIPT_WARNING(TEXT("Python is not available"));
+    return false;
+#endif
+}
+
+void FGKPythonInterpreter::Shutdown() {
+#if WITH_PYTHON
+    FScopeLock Lock(&Mutex);
+
+    if (bOwnsInterpreter && bReady) {
+        PyEval_RestoreThread((PyThreadState*)MainThreadState);
+        ArenaPool.LogStats();
+        ArenaPool.Empty();
+        Py_Finalize();
+    }
+    else if (bReady && Py_IsInitialized()) {
+        FGKPythonGIL GIL;
+        ArenaPool.LogStats();
+        ArenaPool.Empty();
+    }
+
+    MainThreadState = nullptr;
+    bOwnsInterpreter = false;
+    bReady = false;
+#endif
+}
+
+
+FGKPythonGIL::FGKPythonGIL(): State(0) {
+#if WITH_PYTHON
+    State = (int)PyGILState_Ensure();
+#endif
+}
+
+FGKPythonGIL::~FGKPythonGIL() {
+#if WITH_PYTHON
+    PyGILState_Release((PyGILState_STATE)State);
+#endif
+}
+
+
+struct _arena* FGKPyArenaPool::Acquire() {
+    NumAcquired += 1;
+
+#if WITH_PYTHON
+    FEntry Entry;
+    if (Pooled.Num() > 0) {
+        Entry = Pooled.Pop(false);
+    } else {
+        Entry.Arena = PyArena_New();
+        NumCreated += 1;
+    }
+
+    if (Entry.Arena) {
+        Leased.Add(Entry.Arena, Entry.Load);
+    }
+    return Entry.Arena;
+#else
+    return nullptr;
+#endif
+}
+
+void FGKPyArenaPool::Release(struct _arena* Arena, int64 SourceSize) {
+#if WITH_PYTHON
+    if (Arena == nullptr) {
+        return;
+    }
+
+    int64 Load = SourceSize;
+    if (int64 const* Previous = Leased.Find(Arena)) {
+        Load += *Previous;
+    }
+    Leased.Remove(Arena);
+
+    PeakLoad = FMath::Max(PeakLoad, Load);
+
+    // Full arenas are not worth keeping around, nor any arena once the batch is over
+    if (BatchDepth == 0 || Load >= MaxArenaLoad || Pooled.Num() >= MaxPooled) {
+        PyArena_Free(Arena);
+        return;
+    }
+
+    FEntry Entry;
+    Entry.Arena = Arena;
+    Entry.Load = Load;
+    Pooled.Add(Entry);
+#endif
+}
+
+void FGKPyArenaPool::BeginBatch() {
+    BatchDepth += 1;
+}
+
+void FGKPyArenaPool::EndBatch() {
+    BatchDepth -= 1;
+
+    if (BatchDepth == 0) {
+        Empty();
+    }
+}
+
+void FGKPyArenaPool::Empty() {
+#if WITH_PYTHON
+    for (FEntry& Entry : Pooled) {
+        PyArena_Free(Entry.Arena);
+    }
+#endif
+    Pooled.Reset();
+}
+
+void FGKPyArenaPool::LogStats() const {
+    if (NumAcquired == 0) {
+        return;
+    }
+
+    GKSCRIPT_LOG(TEXT("PyArena pool: %d parses, %d arenas created, at most %.1f KiB of source parsed into one arena"),
+        NumAcquired,
+        NumCreated,
+        double(PeakLoad) / 1024.0
+    );
+}
+
+
+FGKPyArenaBatch::FGKPyArenaBatch() {
+    FGKPythonGIL GIL;
+    FGKPythonInterpreter::Get().GetArenaPool().BeginBatch();
+}
+
+FGKPyArenaBatch::~FGKPyArenaBatch() {
+    FGKPythonGIL GIL;
+    FGKPythonInterpreter::Get().GetArenaPool().EndBatch();
+}
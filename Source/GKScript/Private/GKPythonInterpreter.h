@@ -0,0 +1,128 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Unreal Engine
+#include "CoreMinimal.h"
+
+// PyArena
+struct _arena;
+
+
+/*! Small pool of PyArena reused from one parse to the next of a batch
+ *
+ * CPython cannot reset an arena, instead a released arena goes back to the pool
+ * and serves the next parses of the batch until the amount of source parsed into it
+ * reaches ``MaxArenaLoad``, then it is freed and a new one is made.
+ * CPython does not tell how much memory an arena holds, the source size is the bound,
+ * keep it small: every AST and python object parsed into the arena stays alive with it.
+ *
+ * Arenas are only pooled while a batch is open (FGKPyArenaBatch), the pool is emptied
+ * when the batch ends. Outside of a batch an arena is freed as soon as it is released.
+ *
+ * .. note::
+ *
+ *    The pool is protected by the GIL, hold it when acquiring or releasing.
+ *    ASTs parsed into an arena are valid until the arena is released.
+ */
+class FGKPyArenaPool
+{
+    public:
+    struct _arena* Acquire();
+
+    void Release(struct _arena* Arena, int64 SourceSize);
+
+    void BeginBatch();
+    void EndBatch();
+
+    // Free the pooled arenas
+    void Empty();
+
+    void LogStats() const;
+
+    int64 MaxArenaLoad = 256 * 1024;
+    int32 MaxPooled = 1;            // Batches parse one file at a time
+
+    private:
+    struct FEntry {
+        struct _arena* Arena = nullptr;
+        int64          Load  = 0;      // Bytes of source parsed into the arena
+    };
+
+    TArray<FEntry> Pooled;
+    TMap<struct _arena*, int64> Leased;
+    int32 BatchDepth  = 0;
+    int64 PeakLoad    = 0;
+    int32 NumCreated  = 0;
+    int32 NumAcquired = 0;
+};
+
+
+/*! Pool the arenas of the parses made in this scope
+ *
+ * Takes the GIL to open and close the batch, the pooled arenas are freed
+ * when the outermost batch ends.
+ */
+struct FGKPyArenaBatch {
+    FGKPyArenaBatch();
+
+    ~FGKPyArenaBatch();
+
+    FGKPyArenaBatch(FGKPyArenaBatch const&) = delete;
+    FGKPyArenaBatch& operator= (FGKPyArenaBatch const&) = delete;
+};
+
+
+/*! Embedded Python interpreter shared by every python visitor
+ *
+ * The interpreter started by the editor (PythonScriptPlugin) is reused when it is running.
+ * Otherwise one is started on first use and kept until the module shuts down,
+ * importing N scripts boots the interpreter at most once.
+ *
+ * .. note::
+ *
+ *    The GIL is released once the interpreter is ready,
+ *    use FGKPythonGIL before touching any python object.
+ */
+class FGKPythonInterpreter
+{
+    public:
+    static FGKPythonInterpreter& Get();
+
+    // Make sure an interpreter is running, returns false if python is not available
+    bool Initialize();
+
+    // Finalize the interpreter if it was started by us
+    void Shutdown();
+
+    bool IsReady() const {
+        return bReady;
+    }
+
+    FGKPyArenaPool& GetArenaPool() {
+        return ArenaPool;
+    }
+
+    private:
+    FGKPyArenaPool   ArenaPool;
+    FCriticalSection Mutex;
+    bool  bReady = false;
+    bool  bOwnsInterpreter = false;
+    void* MainThreadState = nullptr;     // PyThreadState saved when we release the GIL
+};
+
+
+/*! Hold the GIL for the current scope
+ *
+ * Can be used from any thread, nested guards are fine.
+ */
+struct FGKPythonGIL {
+    FGKPythonGIL();
+
+    ~FGKPythonGIL();
+
+    FGKPythonGIL(FGKPythonGIL const&) = delete;
+    FGKPythonGIL& operator= (FGKPythonGIL const&) = delete;
+
+    int State;  // PyGILState_STATE
+};
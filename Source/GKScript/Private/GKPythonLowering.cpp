@@ -0,0 +1,431 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKPythonLowering.h"
+
+// Gamekit
+#include "GKScriptStats.h"
+
+
+namespace {
+
+EGKAstOp LowerOperator(operator_ty Op) {
+    switch (Op) {
+    case Add:  return EGKAstOp::Add;
+    case Sub:  return EGKAstOp::Sub;
+    case Mult: return EGKAstOp::Mult;
+    case Div:  return EGKAstOp::Div;
+    case Mod:  return EGKAstOp::Mod;
+    default:   return EGKAstOp::None;
+    }
+}
+
+EGKAstOp LowerCompare(cmpop_ty Op) {
+    switch (Op) {
+    case Eq:    return EGKAstOp::Eq;
+    case NotEq: return EGKAstOp::NotEq;
+    case Lt:    return EGKAstOp::Lt;
+    case LtE:   return EGKAstOp::LtE;
+    case Gt:    return EGKAstOp::Gt;
+    case GtE:   return EGKAstOp::GtE;
+    case Is:    return EGKAstOp::Is;
+    case IsNot: return EGKAstOp::IsNot;
+    case In:    return EGKAstOp::In;
+    case NotIn: return EGKAstOp::NotIn;
+    }
+    return EGKAstOp::None;
+}
+
+} // namespace
+
+
+FGKPythonLowering::FGKPythonLowering(FGKScriptAst& Ast, FGKScriptParseError& Error):
+    Builder(Ast), Error(Error)
+{}
+
+bool FGKPythonLowering::Parse(const char* Source, FGKScriptAst& Ast, FGKScriptParseError& Error) {
+    GKSCRIPT_SCOPE(STAT_GKScript_PythonParse);
+    FGKPythonLowering Lowering(Ast, Error);
+
+    if (!Lowering.ParsePythoCode(Source)) {
+        Error.Line = Lowering.ParseErrorLine;
+        Error.Message = Lowering.ParseError;
+        Ast.Reset();
+        return false;
+    }
+
+    if (Lowering.bFailed || Ast.Root == INDEX_NONE) {
+        Ast.Reset();
+        return false;
+    }
+    return true;
+}
+
+int FGKPythonLowering::mod_module(mod_ty node_, int depth) {
+    FGKScriptAst& Ast = Builder.Ast;
+    FGKStmtList Body;
+    LowerStatements(node_->v.Module.body, Body);
+
+    if (!bFailed) {
+        Ast.Root = Builder.AddNode(EGKAstKind::Module, INDEX_NONE, Body, 1);
+    }
+    return 1;
+}
+
+int32 FGKPythonLowering::Intern(PyObject* Str) {
+    if (Str == NULL) {
+        return INDEX_NONE;
+    }
+
+    Py_ssize_t Size = 0;
+    const char* Data = PyUnicode_AsUTF8AndSize(Str, &Size);
+    if (Data == NULL) {
+        PyErr_Clear();
+        return INDEX_NONE;
+    }
+
+    FUTF8ToTCHAR Converted(Data, int32(Size));
+    return Builder.Intern(FStringView(Converted.Get(), Converted.Length()));
+}
+
+int32 FGKPythonLowering::Fail(const TCHAR* Message, int32 Line) {
+    if (!bFailed) {
+        Error.Line = Line;
+        Error.Column = 0;
+        Error.Message = Message;
+        bFailed = true;
+    }
+    return INDEX_NONE;
+}
+
+void FGKPythonLowering::LowerStatements(asdl_seq* Stmts, FGKStmtList& Body) {
+    for (int i = 0; i < asdl_seq_LEN(Stmts) && !bFailed; i++) {
+        stmt_ty Stmt = (stmt_ty)asdl_seq_GET(Stmts, i);
+
+        if (Stmt->kind != Import_kind) {
+            Body.Add(Lower(Stmt));
+            continue;
+        }
+
+        // import a, b becomes import a; import b
+        for (int j = 0; j < asdl_seq_LEN(Stmt->v.Import.names); j++) {
+            alias_ty Alias = (alias_ty)asdl_seq_GET(Stmt->v.Import.names, j);
+            Body.Add(Builder.AddNode(EGKAstKind::Import, Intern(Alias->name), {}, Stmt->lineno));
+        }
+    }
+}
+
+int32 FGKPythonLowering::LowerBlock(asdl_seq* Stmts, int32 Line) {
+    FGKStmtList Body;
+    LowerStatements(Stmts, Body);
+    return Builder.AddNode(EGKAstKind::Block, INDEX_NONE, Body, Line);
+}
+
+int32 FGKPythonLowering::LowerExprs(asdl_seq* Exprs, int32 Line) {
+    TArray<int32, TInlineAllocator<8>> Elts;
+
+    for (int i = 0; i < asdl_seq_LEN(Exprs); i++) {
+        Elts.Add(Lower((expr_ty)asdl_seq_GET(Exprs, i)));
+    }
+    return Builder.AddNode(EGKAstKind::Block, INDEX_NONE, Elts, Line);
+}
+
+int32 FGKPythonLowering::LowerArguments(arguments_ty Args, int32 Line) {
+    if (Args->vararg || Args->kwarg || asdl_seq_LEN(Args->kwonlyargs) > 0) {
+        return Fail(TEXT("*args, **kwargs and keyword only arguments are not supported"), Line);
+    }
+
+    int NumPositional = asdl_seq_LEN(Args->posonlyargs) + asdl_seq_LEN(Args->args);
+    int FirstDefault = NumPositional - asdl_seq_LEN(Args->defaults);
+
+    TArray<int32, TInlineAllocator<8>> Arguments;
+
+    for (int i = 0; i < NumPositional; i++) {
+        int NumPosOnly = asdl_seq_LEN(Args->posonlyargs);
+        arg_ty Arg = i < NumPosOnly ? (arg_ty)asdl_seq_GET(Args->posonlyargs, i)
+                                    : (arg_ty)asdl_seq_GET(Args->args, i - NumPosOnly);
+
+        int32 Default = INDEX_NONE;
+        if (i >= FirstDefault) {
+            Default = Lower((expr_ty)asdl_seq_GET(Args->defaults, i - FirstDefault));
+        }
+
+        int32 Kids[] = {Lower(Arg->annotation), Default};
+        Arguments.Add(Builder.AddNode(EGKAstKind::Arg, Intern(Arg->arg), Kids, Arg->lineno));
+    }
+
+    return Builder.AddNode(EGKAstKind::Block, INDEX_NONE, Arguments, Line);
+}
+
+int32 FGKPythonLowering::Lower(stmt_ty Node) {
+    if (Node == NULL || bFailed) {
+        return INDEX_NONE;
+    }
+
+    int32 Line = Node->lineno;
+
+    switch (Node->kind) {
+    case ClassDef_kind: {
+        if (asdl_seq_LEN(Node->v.ClassDef.keywords) > 0) {
+            return Fail(TEXT("class keywords are not supported"), Line);
+        }
+
+        int32 Kids[] = {
+            LowerExprs(Node->v.ClassDef.bases, Line),
+            LowerExprs(Node->v.ClassDef.decorator_list, Line),
+            LowerBlock(Node->v.ClassDef.body, Line),
+        };
+        return Builder.AddNode(EGKAstKind::ClassDef, Intern(Node->v.ClassDef.name), Kids, Line);
+    }
+    case FunctionDef_kind: {
+        int32 Kids[] = {
+            LowerExprs(Node->v.FunctionDef.decorator_list, Line),
+            LowerArguments(Node->v.FunctionDef.args, Line),
+            Lower(Node->v.FunctionDef.returns),
+            LowerBlock(Node->v.FunctionDef.body, Line),
+        };
+        return Builder.AddNode(EGKAstKind::FunctionDef, Intern(Node->v.FunctionDef.name), Kids, Line);
+    }
+    case Return_kind: {
+        int32 Kids[] = {Lower(Node->v.Return.value)};
+        return Builder.AddNode(EGKAstKind::Return, INDEX_NONE, Kids, Line);
+    }
+    case Assign_kind: {
+        // a = b = c is one Assign with two targets
+        asdl_seq* Targets = Node->v.Assign.targets;
+        TArray<int32, TInlineAllocator<4>> Kids;
+
+        for (int i = 0; i < asdl_seq_LEN(Targets); i++) {
+            Kids.Add(Lower((expr_ty)asdl_seq_GET(Targets, i)));
+        }
+        Kids.Add(Lower(Node->v.Assign.value));
+        return Builder.AddNode(EGKAstKind::Assign, INDEX_NONE, Kids, Line);
+    }
+    case AugAssign_kind: {
+        EGKAstOp Op = LowerOperator(Node->v.AugAssign.op);
+        if (Op == EGKAstOp::None) {
+            return Fail(TEXT("unsupported operator"), Line);
+        }
+
+        int32 Kids[] = {Lower(Node->v.AugAssign.target), Lower(Node->v.AugAssign.value)};
+        return Builder.AddNode(EGKAstKind::AugAssign, INDEX_NONE, Kids, Line, uint8(Op));
+    }
+    case AnnAssign_kind: {
+        int32 Kids[] = {
+            Lower(Node->v.AnnAssign.target),
+            Lower(Node->v.AnnAssign.annotation),
+            Lower(Node->v.AnnAssign.value),
+        };
+        return Builder.AddNode(EGKAstKind::AnnAssign, INDEX_NONE, Kids, Line);
+    }
+    case If_kind: {
+        int32 Kids[] = {
+            Lower(Node->v.If.test),
+            LowerBlock(Node->v.If.body, Line),
+            LowerBlock(Node->v.If.orelse, Line),
+        };
+        return Builder.AddNode(EGKAstKind::If, INDEX_NONE, Kids, Line);
+    }
+#if PY_VERSION_HEX >= 0x030A0000
+    case Match_kind: {
+        TArray<int32, TInlineAllocator<8>> Kids;
+        Kids.Add(Lower(Node->v.Match.subject));
+
+        for (int i = 0; i < asdl_seq_LEN(Node->v.Match.cases); i++) {
+            match_case_ty Case = (match_case_ty)asdl_seq_GET(Node->v.Match.cases, i);
+            if (Case->guard) {
+                return Fail(TEXT("case guards are not supported"), Line);
+            }
+
+            int32 CaseKids[] = {LowerPattern(Case->pattern), LowerBlock((asdl_seq*)Case->body, Line)};
+            Kids.Add(Builder.AddNode(EGKAstKind::Case, INDEX_NONE, CaseKids, Case->pattern->lineno));
+        }
+        return Builder.AddNode(EGKAstKind::Match, INDEX_NONE, Kids, Line);
+    }
+#endif
+    case Expr_kind: {
+        int32 Kids[] = {Lower(Node->v.Expr.value)};
+        return Builder.AddNode(EGKAstKind::ExprStmt, INDEX_NONE, Kids, Line);
+    }
+    case Pass_kind:
+        return Builder.AddNode(EGKAstKind::Pass, INDEX_NONE, {}, Line);
+    case ImportFrom_kind: {
+        TArray<int32, TInlineAllocator<8>> Names;
+        for (int i = 0; i < asdl_seq_LEN(Node->v.ImportFrom.names); i++) {
+            alias_ty Alias = (alias_ty)asdl_seq_GET(Node->v.ImportFrom.names, i);
+            Names.Add(Builder.AddNode(EGKAstKind::Name, Intern(Alias->name), {}, Line));
+        }
+        return Builder.AddNode(EGKAstKind::ImportFrom, Intern(Node->v.ImportFrom.module), Names, Line);
+    }
+    default:
+        break;
+    }
+
+    return Fail(TEXT("statement is not supported by the .us dialect"), Line);
+}
+
+int32 FGKPythonLowering::Lower(expr_ty Node) {
+    if (Node == NULL || bFailed) {
+        return INDEX_NONE;
+    }
+
+    int32 Line = Node->lineno;
+
+    switch (Node->kind) {
+    case Name_kind:
+        return Builder.AddNode(EGKAstKind::Name, Intern(Node->v.Name.id), {}, Line);
+    case Attribute_kind: {
+        int32 Kids[] = {Lower(Node->v.Attribute.value)};
+        return Builder.AddNode(EGKAstKind::Attribute, Intern(Node->v.Attribute.attr), Kids, Line);
+    }
+    case Call_kind: {
+        TArray<int32, TInlineAllocator<16>> Kids;
+        Kids.Add(Lower(Node->v.Call.func));
+
+        for (int i = 0; i < asdl_seq_LEN(Node->v.Call.args); i++) {
+            Kids.Add(Lower((expr_ty)asdl_seq_GET(Node->v.Call.args, i)));
+        }
+
+        for (int i = 0; i < asdl_seq_LEN(Node->v.Call.keywords); i++) {
+            keyword_ty Keyword = (keyword_ty)asdl_seq_GET(Node->v.Call.keywords, i);
+            if (Keyword->arg == NULL) {
+                return Fail(TEXT("**kwargs is not supported"), Line);
+            }
+
+            int32 Value[] = {Lower(Keyword->value)};
+            Kids.Add(Builder.AddNode(EGKAstKind::Keyword, Intern(Keyword->arg), Value, Line));
+        }
+        return Builder.AddNode(EGKAstKind::Call, INDEX_NONE, Kids, Line);
+    }
+    case Constant_kind:
+        return LowerConstant(Node);
+    case Tuple_kind:
+    case List_kind: {
+        asdl_seq* Elts = Node->kind == Tuple_kind ? Node->v.Tuple.elts : Node->v.List.elts;
+        TArray<int32, TInlineAllocator<8>> Kids;
+
+        for (int i = 0; i < asdl_seq_LEN(Elts); i++) {
+            Kids.Add(Lower((expr_ty)asdl_seq_GET(Elts, i)));
+        }
+
+        EGKAstKind Kind = Node->kind == Tuple_kind ? EGKAstKind::Tuple : EGKAstKind::List;
+        return Builder.AddNode(Kind, INDEX_NONE, Kids, Line);
+    }
+    case Subscript_kind: {
+        int32 Kids[] = {Lower(Node->v.Subscript.value), Lower(Node->v.Subscript.slice)};
+        return Builder.AddNode(EGKAstKind::Subscript, INDEX_NONE, Kids, Line);
+    }
+    case UnaryOp_kind: {
+        EGKAstOp Op = Node->v.UnaryOp.op == USub ? EGKAstOp::USub :
+                      Node->v.UnaryOp.op == Not  ? EGKAstOp::Not  : EGKAstOp::None;
+
+        // +a is a
+        if (Node->v.UnaryOp.op == UAdd) {
+            return Lower(Node->v.UnaryOp.operand);
+        }
+        if (Op == EGKAstOp::None) {
+            return Fail(TEXT("unsupported operator"), Line);
+        }
+
+        int32 Kids[] = {Lower(Node->v.UnaryOp.operand)};
+        return Builder.AddNode(EGKAstKind::UnaryOp, INDEX_NONE, Kids, Line, uint8(Op));
+    }
+    case BinOp_kind: {
+        EGKAstOp Op = LowerOperator(Node->v.BinOp.op);
+        if (Op == EGKAstOp::None) {
+            return Fail(TEXT("unsupported operator"), Line);
+        }
+
+        int32 Kids[] = {Lower(Node->v.BinOp.left), Lower(Node->v.BinOp.right)};
+        return Builder.AddNode(EGKAstKind::BinOp, INDEX_NONE, Kids, Line, uint8(Op));
+    }
+    case BoolOp_kind: {
+        // Folded to the left like the native parser
+        EGKAstOp Op = Node->v.BoolOp.op == And ? EGKAstOp::And : EGKAstOp::Or;
+        asdl_seq* Values = Node->v.BoolOp.values;
+
+        int32 Left = Lower((expr_ty)asdl_seq_GET(Values, 0));
+        for (int i = 1; i < asdl_seq_LEN(Values); i++) {
+            int32 Kids[] = {Left, Lower((expr_ty)asdl_seq_GET(Values, i))};
+            Left = Builder.AddNode(EGKAstKind::BoolOp, INDEX_NONE, Kids, Line, uint8(Op));
+        }
+        return Left;
+    }
+    case Compare_kind: {
+        int32 Left = Lower(Node->v.Compare.left);
+
+        for (int i = 0; i < asdl_seq_LEN(Node->v.Compare.comparators); i++) {
+            EGKAstOp Op = LowerCompare((cmpop_ty)asdl_seq_GET(Node->v.Compare.ops, i));
+            if (Op == EGKAstOp::None) {
+                return Fail(TEXT("unsupported operator"), Line);
+            }
+
+            int32 Kids[] = {Left, Lower((expr_ty)asdl_seq_GET(Node->v.Compare.comparators, i))};
+            Left = Builder.AddNode(EGKAstKind::Compare, INDEX_NONE, Kids, Line, uint8(Op));
+        }
+        return Left;
+    }
+    default:
+        break;
+    }
+
+    return Fail(TEXT("expression is not supported by the .us dialect"), Line);
+}
+
+int32 FGKPythonLowering::LowerConstant(expr_ty Node) {
+    PyObject* Value = Node->v.Constant.value;
+    int32 Line = Node->lineno;
+
+    auto MakeConstant = [&](EGKAstConstant Type, int32 Str) {
+        return Builder.AddNode(EGKAstKind::Constant, Str, {}, Line, uint8(Type));
+    };
+
+    if (Value == Py_None) {
+        return MakeConstant(EGKAstConstant::None, INDEX_NONE);
+    }
+    if (Value == Py_True) {
+        return MakeConstant(EGKAstConstant::True, INDEX_NONE);
+    }
+    if (Value == Py_False) {
+        return MakeConstant(EGKAstConstant::False, INDEX_NONE);
+    }
+    if (Value == Py_Ellipsis) {
+        return Builder.AddNode(EGKAstKind::Name, Builder.Intern(TEXT("...")), {}, Line);
+    }
+    if (PyUnicode_Check(Value)) {
+        return MakeConstant(EGKAstConstant::String, Intern(Value));
+    }
+
+    if (PyLong_Check(Value) || PyFloat_Check(Value)) {
+        PyObject* Repr = PyObject_Repr(Value);
+        int32 Str = Intern(Repr);
+        Py_XDECREF(Repr);
+        return MakeConstant(PyLong_Check(Value) ? EGKAstConstant::Int : EGKAstConstant::Real, Str);
+    }
+
+    return Fail(TEXT("constant is not supported by the .us dialect"), Line);
+}
+
+#if PY_VERSION_HEX >= 0x030A0000
+int32 FGKPythonLowering::LowerPattern(pattern_ty Pattern) {
+    switch (Pattern->kind) {
+    case MatchValue_kind:
+        return Lower(Pattern->v.MatchValue.value);
+    case MatchSingleton_kind: {
+        PyObject* Value = Pattern->v.MatchSingleton.value;
+        EGKAstConstant Type = Value == Py_True ? EGKAstConstant::True :
+                              Value == Py_False ? EGKAstConstant::False : EGKAstConstant::None;
+        return Builder.AddNode(EGKAstKind::Constant, INDEX_NONE, {}, Pattern->lineno, uint8(Type));
+    }
+    case MatchAs_kind:
+        if (Pattern->v.MatchAs.pattern == NULL) {
+            int32 Name = Pattern->v.MatchAs.name ? Intern(Pattern->v.MatchAs.name) : Builder.Intern(TEXT("_"));
+            return Builder.AddNode(EGKAstKind::Name, Name, {}, Pattern->lineno);
+        }
+        break;
+    default:
+        break;
+    }
+    return Fail(TEXT("pattern is not supported by the .us dialect"), Pattern->lineno);
+}
+#endif
@@ -0,0 +1,48 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Gamekit
+#include "GKScriptAst.h"
+#include "GKScriptParser.h"
+#include "GKPythonVisitor.h"
+
+
+/*! Parse a script with CPython and lower its AST into an FGKScriptAst
+ *
+ * The CPython AST dies with its arena, the lowered AST is owned by the engine
+ * and outlives the interpreter.
+ * Constructs outside of the .us dialect are reported as errors.
+ */
+class FGKPythonLowering : public PythonASTVisitor
+{
+    public:
+    FGKPythonLowering(FGKScriptAst& Ast, FGKScriptParseError& Error);
+
+    // Same contract as FGKScriptParser::Parse
+    static bool Parse(const char* Source, FGKScriptAst& Ast, FGKScriptParseError& Error);
+
+    int mod_module(mod_ty node_, int depth) override;
+
+    private:
+    using FGKStmtList = TArray<int32, TInlineAllocator<16>>;
+
+    // Some statements lower to several nodes, ``import a, b`` is two Imports
+    void  LowerStatements(asdl_seq* Stmts, FGKStmtList& Body);
+    int32 Lower(stmt_ty Node);
+    int32 Lower(expr_ty Node);
+    int32 LowerArguments(arguments_ty Args, int32 Line);
+    int32 LowerBlock(asdl_seq* Stmts, int32 Line);
+    int32 LowerExprs(asdl_seq* Exprs, int32 Line);
+    int32 LowerConstant(expr_ty Node);
+#if PY_VERSION_HEX >= 0x030A0000
+    int32 LowerPattern(pattern_ty Pattern);
+#endif
+
+    int32 Intern(PyObject* Str);
+    int32 Fail(const TCHAR* Message, int32 Line);
+
+    FGKScriptAstBuilder  Builder;
+    FGKScriptParseError& Error;
+    bool                 bFailed = false;
+};
@@ -3,13 +3,20 @@
 #include "GKPythonTransform.h"
 
 // Gamekit
-
+#include "GKScript.h"
+#include "GKEdGraphTypes.h"
+#include "GKReflectionIndex.h"
+#include "GKScriptStats.h"
 
 // Unreal Engine
 #include "EdGraph/EdGraphNode.h"
 #include "EdGraphSchema_K2.h"
 #include "Factories/BlueprintFactory.h"
 #include "AssetToolsModule.h"
+#include "Hash/CityHash.h"
+#include "Kismet2/BlueprintEditorUtils.h"
+#include "Misc/PackageName.h"
+#include "UObject/MetaData.h"
 
 
 #include "K2Node.h"
@@ -32,6 +39,22 @@
 
 //
 
+// Hash of the function AST the graph was built from
+static const FName GKScriptHashKey = TEXT("GKScriptHash");
+
+// Set on every graph built from a script, hashed or not
+static const FName GKScriptGraphKey = TEXT("GKScriptGraph");
+
+// Bump when the graphs built from the same script change
+static const uint32 GKLoweringVersion = 2;
+
+// Warnings about the script, a function that had some is not stamped with its hash
+#define GKLOWERING_WARNING(Format, ...)             \
+    {                                               \
+        NumWarnings += 1;                           \
+        GKSCRIPT_WARNING(Format, __VA_ARGS__);      \
+    }
+
 struct FGKContextGuard {
     FGKContextGuard(FGKPythonTransform& Transform) :
         Transform(Transform)
@@ -47,140 +70,574 @@ struct FGKContextGuard {
 };
 
 FGKPythonTransform::FGKPythonTransform(FString OutputPath, class UBlueprint* Dest):
-    OutputPath(OutputPath), Destination(Dest)
+    OutputPath(OutputPath), Destination(Dest), CurrentGraph(nullptr)
 {
     TransformStack.Add(FGKTransfromContext());
 }
 
-FString PythonFString(PyObject* Object) {
-    return FString(PyBytes_AsString(Object));
+EObjectFlags FGKPythonTransform::GetObjectFlags() const {
+    // Batch imports cannot be undone, nothing goes in the transaction buffer
+    return bBatch ? RF_NoFlags : RF_Transactional;
 }
 
-FName PythonFName(PyObject* Object) {
-    return FName(PyBytes_AsString(Object));
+void FGKPythonTransform::AddNode(UEdGraphNode* Node) {
+    // Batch imports notify once per Blueprint, when it is compiled
+    if (bBatch) {
+        CurrentGraph->Nodes.Add(Node);
+        return;
+    }
+    CurrentGraph->AddNode(Node, true, false);
 }
 
-// Expression
-int FGKPythonTransform::call(expr_ty node_, int depth) {
-    //
+template <typename T>
+T* FGKPythonTransform::SpawnNode(int32 Node, bool bPure) {
+    FGKTransfromContext& Context = GetContext();
+
+    T* GraphNode = NewObject<T>(CurrentGraph, NAME_None, GetObjectFlags());
+    GraphNode->NodePosX = Context.Column * 320;
+    GraphNode->NodePosY = bPure ? 160 : 0;
+    if (!bPure) {
+        Context.Column += 1;
+    }
+
+    AddNode(GraphNode);
+    return GraphNode;
+}
+
+void FGKPythonTransform::FinishNode(UEdGraphNode* Node) {
+    Node->CreateNewGuid();
+    Node->PostPlacedNewNode();
+    Node->AllocateDefaultPins();
+}
+
+bool FGKPythonTransform::Link(UEdGraphPin* Output, UEdGraphPin* Input, int32 Node) {
+    if (Output == nullptr || Input == nullptr || !CurrentGraph->GetSchema()->TryCreateConnection(Output, Input)) {
+        GKLOWERING_WARNING(TEXT("Line %d: could not connect %s to %s"),
+            Ast->Get(Node).Line,
+            Output ? *Output->GetName() : TEXT("None"),
+            Input ? *Input->GetName() : TEXT("None")
+        );
+        return false;
+    }
+    return true;
+}
+
+void FGKPythonTransform::ChainExec(UEdGraphPin* Exec, UEdGraphPin* Then, int32 Node) {
+    FGKTransfromContext& Context = GetContext();
+
+    for (UEdGraphPin* Previous : Context.ExecPins) {
+        Link(Previous, Exec, Node);
+    }
+
+    Context.ExecPins.Reset();
+    if (Then != nullptr) {
+        Context.ExecPins.Add(Then);
+    }
+}
+
+bool FGKPythonTransform::ConnectValue(int32 Node, UEdGraphPin* Input) {
+    if (Node == INDEX_NONE || Input == nullptr) {
+        return false;
+    }
+
+    FGKAstNode const& Expr = Ast->Get(Node);
+    UEdGraphSchema const* Schema = CurrentGraph->GetSchema();
+
+    switch (Expr.Kind) {
+    case EGKAstKind::Constant: {
+        FString Value;
+        switch (EGKAstConstant(Expr.Op)) {
+        case EGKAstConstant::True:  Value = TEXT("true"); break;
+        case EGKAstConstant::False: Value = TEXT("false"); break;
+        case EGKAstConstant::None:  break;
+        default:                    Value = FString(Ast->GetValue(Node)); break;
+        }
+        Schema->TrySetDefaultValue(*Input, Value);
+        return true;
+    }
+    case EGKAstKind::Name:
+    case EGKAstKind::Attribute:
+    case EGKAstKind::Call: {
+        UEdGraphPin* Output = LowerValue(Node);
+        return Output != nullptr && Link(Output, Input, Node);
+    }
+    default:
+        break;
+    }
+
+    GKLOWERING_WARNING(TEXT("Line %d: %s expressions are not supported yet"), Expr.Line, ::ToString(Expr.Kind));
+    return false;
+}
+
+UEdGraphPin* FGKPythonTransform::LowerValue(int32 Node) {
+    FGKAstNode const& Expr = Ast->Get(Node);
+
+    switch (Expr.Kind) {
+    case EGKAstKind::Name:
+    case EGKAstKind::Attribute: {
+        // self.Name and Name are the same member
+        if (Expr.Kind == EGKAstKind::Attribute && !IsSelf(Ast->GetChild(Node, 0))) {
+            break;
+        }
+
+        FName Name = FName(Ast->GetValue(Node));
+        if (UEdGraphPin** Arg = GetContext().ArgNameToPin.Find(Name)) {
+            return *Arg;
+        }
+
+        if (Name == TEXT("self")) {
+            UK2Node_Self* Self = SpawnNode<UK2Node_Self>(Node, true);
+            FinishNode(Self);
+            return Self->FindPin(UEdGraphSchema_K2::PN_Self);
+        }
+
+        UK2Node_VariableGet* Get = SpawnNode<UK2Node_VariableGet>(Node, true);
+        Get->VariableReference.SetSelfMember(Name);
+        FinishNode(Get);
+        return Get->GetValuePin();
+    }
+    case EGKAstKind::Call: {
+        UK2Node_CallFunction* Call = LowerCall(Node);
+        return Call ? Call->GetReturnValuePin() : nullptr;
+    }
+    default:
+        break;
+    }
+
+    GKLOWERING_WARNING(TEXT("Line %d: %s expressions are not supported yet"), Expr.Line, ::ToString(Expr.Kind));
+    return nullptr;
+}
+
+bool FGKPythonTransform::IsSelf(int32 Node) const {
+    FGKAstNode const& Expr = Ast->Get(Node);
+    return Expr.Kind == EGKAstKind::Name && Ast->GetValue(Node).Equals(TEXT("self"), ESearchCase::CaseSensitive);
+}
+
+UClass* FGKPythonTransform::GetSelfClass() const {
+    // Functions and variables of the Blueprint live on its skeleton until it is compiled
+    return Destination->SkeletonGeneratedClass ? Destination->SkeletonGeneratedClass.Get() : Destination->ParentClass.Get();
+}
+
+UClass* FGKPythonTransform::GetPinClass(UEdGraphPin* Pin) const {
+    if (Pin->PinType.PinSubCategory == UEdGraphSchema_K2::PSC_Self) {
+        return GetSelfClass();
+    }
+    return Cast<UClass>(Pin->PinType.PinSubCategoryObject.Get());
+}
+
+UK2Node_CallFunction* FGKPythonTransform::LowerCall(int32 Node) {
+    // f(), self.f(), Library.f() or Object.f()
+    int32 Func = Ast->GetChild(Node, 0);
+    EGKAstKind FuncKind = Ast->Get(Func).Kind;
+    if (FuncKind != EGKAstKind::Name && FuncKind != EGKAstKind::Attribute) {
+        GKLOWERING_WARNING(TEXT("Line %d: only named functions can be called"), Ast->Get(Node).Line);
+        return nullptr;
+    }
+
+    FStringView FunctionName = Ast->GetValue(Func);
+    UFunction* Function = nullptr;
+    UEdGraphPin* Target = nullptr;
+
+    int32 Receiver = FuncKind == EGKAstKind::Attribute ? Ast->GetChild(Func, 0) : INDEX_NONE;
+
+    if (Receiver == INDEX_NONE || IsSelf(Receiver)) {
+        // Members first, then every Blueprint callable function
+        Function = FGKReflectionIndex::Get().FindFunction(FunctionName, GetSelfClass());
+    } else if (UClass* Class = Ast->Get(Receiver).Kind == EGKAstKind::Name ? FGKReflectionIndex::Get().FindClass(Ast->GetValue(Receiver)) : nullptr) {
+        // Library.f(), static functions of a class
+        Function = Class->FindFunctionByName(FName(FunctionName));
+    } else {
+        // Object.f(), resolved on the type of the object
+        Target = LowerValue(Receiver);
+        if (Target == nullptr) {
+            return nullptr;
+        }
+
+        UClass* Class = GetPinClass(Target);
+        if (Class == nullptr) {
+            GKLOWERING_WARNING(TEXT("Line %d: %s is called on a value that is not an object"), Ast->Get(Node).Line, *FString(FunctionName));
+            return nullptr;
+        }
+        Function = Class->FindFunctionByName(FName(FunctionName));
+    }
+
+    if (Function == nullptr) {
+        GKLOWERING_WARNING(TEXT("Line %d: unknown function %s"), Ast->Get(Node).Line, *FString(FunctionName));
+        return nullptr;
+    }
+
+    bool bPure = Function->HasAnyFunctionFlags(FUNC_BlueprintPure);
+
+    UK2Node_CallFunction* Call = SpawnNode<UK2Node_CallFunction>(Node, bPure);
+    Call->SetFromFunction(Function);
+    FinishNode(Call);
+
+    if (Target != nullptr) {
+        Link(Target, Call->FindPin(UEdGraphSchema_K2::PN_Self, EGPD_Input), Node);
+    }
+
+    // Positional arguments follow the declaration order of the parameters
+    TArray<UEdGraphPin*, TInlineAllocator<8>> Params;
+    for (UEdGraphPin* Pin : Call->Pins) {
+        if (Pin->Direction == EGPD_Input && !Pin->bHidden &&
+            Pin->PinType.PinCategory != UEdGraphSchema_K2::PC_Exec &&
+            Pin->PinName != UEdGraphSchema_K2::PN_Self) {
+            Params.Add(Pin);
+        }
+    }
+
+    TArrayView<const int32> Args = Ast->GetChildren(Node);
+    for (int32 i = 1, Positional = 0; i < Args.Num(); i++) {
+        int32 Arg = Args[i];
+
+        if (Ast->Get(Arg).Kind == EGKAstKind::Keyword) {
+            ConnectValue(Ast->GetChild(Arg, 0), Call->FindPin(FName(Ast->GetValue(Arg)), EGPD_Input));
+            continue;
+        }
+
+        if (!Params.IsValidIndex(Positional)) {
+            GKLOWERING_WARNING(TEXT("Line %d: too many arguments for %s"), Ast->Get(Node).Line, *Function->GetName());
+            break;
+        }
+        ConnectValue(Arg, Params[Positional++]);
+    }
+
+    // Arguments are evaluated first, impure calls among them are already chained
+    if (!bPure) {
+        ChainExec(Call->GetExecPin(), Call->GetThenPin(), Node);
+    }
+    return Call;
+}
+
+int FGKPythonTransform::Transform(FGKScriptAst const& Script) {
+    Ast = &Script;
+    int Result = Exec(Script.Root);
+    Ast = nullptr;
+    return Result;
+}
+
+int FGKPythonTransform::IgnoreStatement(int32 Node) {
+    // Class bodies only hold functions for now
+    GKLOWERING_WARNING(TEXT("Line %d: statements outside of a function are ignored"), Ast->Get(Node).Line);
     return 0;
 }
 
+// Expression
+int FGKPythonTransform::Call(int32 Node) {
+    // Statement calls, the result is discarded
+    if (CurrentGraph == nullptr) {
+        return IgnoreStatement(Node);
+    }
+
+    return LowerCall(Node) != nullptr;
+}
+
 
 // Statement
-int FGKPythonTransform::classdef(stmt_ty node_, int depth) {
+int FGKPythonTransform::ClassDef(int32 Node) {
+    GKSCRIPT_SCOPE(STAT_GKScript_BuildClass);
     // Nested classes are not supported
     ensure(Destination == nullptr);
 
     // Resolve BaseClass
-    asdl_seq* Bases = node_->v.ClassDef.bases;
-    ensure(asdl_seq_LEN(Bases) == 1);
-    expr_ty BaseClass = (expr_ty) asdl_seq_GET(Bases, 0);
-    ensure(BaseClass->kind == Name_kind);
-    FString BaseClassName = PythonFString(BaseClass->v.Name.id);
-
-    // Deprecated
-    UClass* BaseClassType = FindObject<UClass>(ANY_PACKAGE, *BaseClassName);
-    // ----
-
-    // Get ready to instantiate the blueprint
-    UBlueprintFactory* Factory = NewObject<UBlueprintFactory>();
-    Factory->ParentClass = BaseClassType;
-    Factory->BlueprintType = EBlueprintType::BPTYPE_Normal;
-    Factory->bSkipClassPicker = true;
+    TArrayView<const int32> Bases = Ast->GetChildren(Ast->GetChild(Node, 0));
+    if (!ensure(Bases.Num() == 1) || !ensure(Ast->Get(Bases[0]).Kind == EGKAstKind::Name)) {
+        return 0;
+    }
+    UClass* BaseClassType = FGKReflectionIndex::Get().FindClass(Ast->GetValue(Bases[0]));
+    if (BaseClassType == nullptr) {
+        GKSCRIPT_ERROR(TEXT("Line %d: unknown base class %s"), Ast->Get(Node).Line, *FString(Ast->GetValue(Bases[0])));
+        return 0;
+    }
 
     // -----------------------------
     // Save the class as a blueprint
-    identifier name_obj = node_->v.ClassDef.name;
-    FString ClassName = FString(PyBytes_AsString(name_obj));
+    FString ClassName = FString(Ast->GetValue(Node));
 
     const FString SavePackagePath = FPaths::GetPath(OutputPath);
     const FString SaveAssetName = FPaths::GetBaseFilename(ClassName);
+    const FString PackageName = SavePackagePath / SaveAssetName;
+
+    bModified = false;
+
+    if (FindPackage(nullptr, *PackageName) || FPackageName::DoesPackageExist(PackageName)) {
+        // Re-import, only the functions that changed are rebuilt
+        {
+            GKSCRIPT_SCOPE(STAT_GKScript_Load);
+            Destination = LoadObject<UBlueprint>(nullptr, *(PackageName + TEXT(".") + SaveAssetName));
+        }
+
+        if (Destination != nullptr && Destination->ParentClass != BaseClassType) {
+            Destination->Modify();
+            Destination->ParentClass = BaseClassType;
+            bModified = true;
+        }
+    } else {
+        // Get ready to instantiate the blueprint
+        UBlueprintFactory* Factory = NewObject<UBlueprintFactory>();
+        Factory->ParentClass = BaseClassType;
+        Factory->BlueprintType = EBlueprintType::BPTYPE_Normal;
+        Factory->bSkipClassPicker = true;
+
+        // 1 Class = 1 Blueprint
+        IAssetTools& AssetTools = FModuleManager::GetModuleChecked<FAssetToolsModule>("AssetTools").Get();
+        Destination = Cast<UBlueprint>(
+            AssetTools.CreateAsset(
+                SaveAssetName,
+                SavePackagePath,
+                UBlueprint::StaticClass(),
+                Factory
+            )
+        );
+        bModified = true;
 
-    // 1 Class = 1 Blueprint
-    IAssetTools& AssetTools = FModuleManager::GetModuleChecked<FAssetToolsModule>("AssetTools").Get();
-    Destination = Cast<UBlueprint>(
-        AssetTools.CreateAsset(
-            SaveAssetName,
-            SavePackagePath,
-            UBlueprint::StaticClass(),
-            Factory
-        )
-    );
-
-    UEdGraph* NewGraph = NewObject<UEdGraph>(
-        Destination,
-        NAME_None,
-        RF_Transactional
-    );
-    NewGraph->Schema = UEdGraphSchema_K2::StaticClass();
-    Destination->FunctionGraphs.Add(NewGraph);
-    CurrentGraph = NewGraph;
+        // Scripts imported later can derive from it
+        FGKReflectionIndex::Get().AddBlueprint(Destination);
+    }
+
+    if (Destination == nullptr) {
+        GKSCRIPT_ERROR(TEXT("Could not create %s"), *PackageName);
+        return 0;
+    }
 
     // Build the Blueprint Graph/Nodes
-    auto result = visit(node_->v.ClassDef.body, depth);
+    ScriptFunctions.Reset();
+    auto result = Exec(Ast->GetChild(Node, 2));
+
+    // Functions removed from the script, graphs made in the editor are kept
+    TArray<UEdGraph*> Removed;
+    for (UEdGraph* Graph : Destination->FunctionGraphs) {
+        if (!ScriptFunctions.Contains(Graph->GetFName()) && IsScriptGraph(Graph)) {
+            Removed.Add(Graph);
+        }
+    }
+    for (UEdGraph* Graph : Removed) {
+        RemoveFunctionGraph(Graph);
+    }
+
+    if (bModified) {
+        Blueprints.Add(Destination);
+
+        if (!bBatch) {
+            FBlueprintEditorUtils::MarkBlueprintAsStructurallyModified(Destination);
+        }
+    } else {
+        GKSCRIPT_VERBOSE(TEXT("%s is up to date"), *PackageName);
+        NumUnchanged += 1;
+    }
+
     Destination = nullptr;
     return result;
 }
 
-int FGKPythonTransform::functiondef(stmt_ty node_, int depth) 
+FString FGKPythonTransform::GetScriptHash(UEdGraph* Graph) {
+    UMetaData* MetaData = Graph->GetOutermost()->GetMetaData();
+    return MetaData->GetValue(Graph, GKScriptHashKey);
+}
+
+void FGKPythonTransform::SetScriptHash(UEdGraph* Graph, FString const& Hash) {
+    UMetaData* MetaData = Graph->GetOutermost()->GetMetaData();
+    MetaData->SetValue(Graph, GKScriptHashKey, *Hash);
+}
+
+bool FGKPythonTransform::IsScriptGraph(UEdGraph* Graph) {
+    UMetaData* MetaData = Graph->GetOutermost()->GetMetaData();
+
+    // Graphs imported before the marker only have their hash
+    return MetaData->HasValue(Graph, GKScriptGraphKey) || MetaData->HasValue(Graph, GKScriptHashKey);
+}
+
+void FGKPythonTransform::RemoveFunctionGraph(UEdGraph* Graph) {
+    Graph->GetOutermost()->GetMetaData()->RemoveValue(Graph, GKScriptHashKey);
+    Graph->GetOutermost()->GetMetaData()->RemoveValue(Graph, GKScriptGraphKey);
+
+    // The Blueprint is compiled once, after every function was patched
+    FBlueprintEditorUtils::RemoveGraph(Destination, Graph, EGraphRemoveFlags::MarkTransient);
+    bModified = true;
+}
+
+int FGKPythonTransform::FunctionDef(int32 Node) 
 {
-    ensure(CurrentGraph != nullptr);
+    GKSCRIPT_SCOPE(STAT_GKScript_BuildFunction);
     ensure(Destination != nullptr);
 
     FGKContextGuard _(*this);
 
     // use decorators to know the type of graph to add
-    node_->v.FunctionDef.decorator_list;
+    // Ast->GetChild(Node, 0);
+
+    FName FunctionName = FName(Ast->GetValue(Node));
+    ScriptFunctions.Add(FunctionName);
+
+    // Functions are matched by name, unchanged functions keep their graph as is.
+    // Calls and members are resolved against the parent class, the graph depends on it as well
+    FString Scope = FString::Printf(TEXT("%u:%s"), GKLoweringVersion, *GetPathNameSafe(Destination->ParentClass));
+    uint64 ScopeHash = CityHash64((const char*)*Scope, Scope.Len() * sizeof(TCHAR));
+    FString Hash = FString::Printf(TEXT("%016llx"), CityHash128to64({Ast->Hash(Node), ScopeHash}));
+
+    UEdGraph** Existing = Destination->FunctionGraphs.FindByPredicate([FunctionName](UEdGraph* Graph) {
+        return Graph->GetFName() == FunctionName;
+    });
+
+    if (Existing != nullptr) {
+        if (GetScriptHash(*Existing) == Hash) {
+            return 1;
+        }
+        RemoveFunctionGraph(*Existing);
+    }
+    bModified = true;
+
+    UEdGraph* Graph = NewObject<UEdGraph>(Destination, FunctionName, GetObjectFlags());
+    Graph->Schema = UEdGraphSchema_K2::StaticClass();
 
-    UK2Node_FunctionTerminator* NewNode = NewObject<UK2Node_FunctionTerminator>(
-        CurrentGraph,
-        NAME_None, 
-        RF_Transactional
-    );
-    CurrentGraph->AddNode(NewNode);
+    if (bBatch) {
+        // AddFunctionGraph marks the Blueprint as modified and refreshes it for every function
+        Destination->FunctionGraphs.Add(Graph);
+        Graph->GetSchema()->CreateFunctionGraphTerminators(*Graph, (UClass*)nullptr);
+    } else {
+        FBlueprintEditorUtils::AddFunctionGraph<UClass>(Destination, Graph, true, nullptr);
+    }
+    CurrentGraph = Graph;
+    Graph->GetOutermost()->GetMetaData()->SetValue(Graph, GKScriptGraphKey, TEXT("1"));
+    int32 Warnings = NumWarnings;
+
+    UK2Node_FunctionEntry* Entry = nullptr;
+    for (UEdGraphNode* GraphNode : Graph->Nodes) {
+        Entry = Cast<UK2Node_FunctionEntry>(GraphNode);
+        if (Entry) {
+            break;
+        }
+    }
+    if (!ensure(Entry != nullptr)) {
+        CurrentGraph = nullptr;
+        return 0;
+    }
 
-    // Arguments are input pins
-    arguments_ty args = node_->v.FunctionDef.args;
+    // Arguments are output pins of the entry node
+    TArrayView<const int32> Args = Ast->GetChildren(Ast->GetChild(Node, 1));
 
-    for (int i = 0; i < asdl_seq_LEN(args->posonlyargs); i++) {
-        arg_ty elt = (arg_ty)asdl_seq_GET(args->posonlyargs, i);
+    for (int32 Arg : Args) {
+        FName PinName = FName(Ast->GetValue(Arg));
+        if (PinName == TEXT("self")) {
+            continue;
+        }
 
-        expr_ty annotation = elt->annotation;
-        FName PinName = PythonFName(elt->arg);
+        int32 Annotation = Ast->GetChild(Arg, 0);
 
+        // Untyped arguments are left for the user to fix in the editor
         FEdGraphPinType PinType;
-        /*
-        PinType.PinCategory = ;
-        PinType.PinSubCategory = ;
-        PinType.PinSubCategoryObject = ;
-        PinType.PinSubCategoryMemberReference = ;
-        PinType.FEdGraphTerminalType = ;
-        PinType.ContainerType = ;
-        */
-
-        UEdGraphPin* ArgPin = NewNode->CreatePin(
-            EEdGraphPinDirection::EGPD_Input,
-            PinType,
-            PinName,
-            i
-        );
-        GetContext().ArgNameToPin[PinName] = ArgPin;
+        if (!FGKPinTypeResolver::Get().Resolve(*Ast, Annotation, PinType)) {
+            GKLOWERING_WARNING(TEXT("Line %d: could not resolve the type of %s"), Ast->Get(Arg).Line, *PinName.ToString());
+            PinType.PinCategory = UEdGraphSchema_K2::PC_Wildcard;
+        }
+
+        UEdGraphPin* ArgPin = Entry->CreateUserDefinedPin(PinName, PinType, EGPD_Output, false);
+        GetContext().ArgNameToPin.Add(PinName, ArgPin);
     }
 
+    GetContext().ExecPins.Add(Entry->FindPinChecked(UEdGraphSchema_K2::PN_Then));
+    GetContext().Returns = Ast->GetChild(Node, 2);
+    GetContext().Column = 1;
+
     // Build the graph
-    auto result = visit(node_->v.FunctionDef.body, depth);
+    auto result = Exec(Ast->GetChild(Node, 3));
+
+    // Incomplete graphs are built again on the next import, what was missing might exist by then
+    if (NumWarnings == Warnings) {
+        SetScriptHash(Graph, Hash);
+    }
 
     CurrentGraph = nullptr;
     return result;
 }
-int FGKPythonTransform::returnstmt(stmt_ty node_, int depth) {
+
+int FGKPythonTransform::Return(int32 Node) {
+    if (CurrentGraph == nullptr) {
+        return IgnoreStatement(Node);
+    }
+
+    FGKTransfromContext& Context = GetContext();
+
+    UK2Node_FunctionResult* Result = SpawnNode<UK2Node_FunctionResult>(Node);
+    FinishNode(Result);
+
+    int32 Value = Ast->GetChild(Node, 0);
+    if (Value != INDEX_NONE) {
+        FEdGraphPinType PinType;
+        if (!FGKPinTypeResolver::Get().Resolve(*Ast, Context.Returns, PinType)) {
+            GKLOWERING_WARNING(TEXT("Line %d: could not resolve the return type"), Ast->Get(Node).Line);
+            PinType.PinCategory = UEdGraphSchema_K2::PC_Wildcard;
+        }
+
+        UEdGraphPin* ReturnPin = Result->CreateUserDefinedPin(UEdGraphSchema_K2::PN_ReturnValue, PinType, EGPD_Input, false);
+        ConnectValue(Value, ReturnPin);
+    }
+
+    // Statements after a return are unreachable
+    ChainExec(Result->GetExecPin(), nullptr, Node);
     return 1;
 }
-int FGKPythonTransform::assign(stmt_ty node_, int depth) {
-    // Create variables
+
+int FGKPythonTransform::Assign(int32 Node) {
+    if (CurrentGraph == nullptr) {
+        return IgnoreStatement(Node);
+    }
+
+    TArrayView<const int32> Kids = Ast->GetChildren(Node);
+    int32 Value = Kids.Last();
+
+    // a = b = c sets every target to c
+    for (int32 Target : Kids.LeftChop(1)) {
+        FGKAstNode const& Expr = Ast->Get(Target);
+        bool bSelf = Expr.Kind == EGKAstKind::Attribute &&
+                     Ast->GetValue(Ast->GetChild(Target, 0)).Equals(TEXT("self"), ESearchCase::CaseSensitive);
+
+        if (Expr.Kind != EGKAstKind::Name && !bSelf) {
+            GKLOWERING_WARNING(TEXT("Line %d: only member variables can be assigned"), Expr.Line);
+            continue;
+        }
+
+        FName Name = FName(Ast->GetValue(Target));
+        if (GetContext().ArgNameToPin.Contains(Name)) {
+            GKLOWERING_WARNING(TEXT("Line %d: arguments cannot be assigned"), Expr.Line);
+            continue;
+        }
+
+        UK2Node_VariableSet* Set = SpawnNode<UK2Node_VariableSet>(Target);
+        Set->VariableReference.SetSelfMember(Name);
+        FinishNode(Set);
+
+        ConnectValue(Value, Set->FindPin(Name, EGPD_Input));
+        ChainExec(Set->GetExecPin(), Set->GetThenPin(), Target);
+    }
+    return 1;
+}
+
+int FGKPythonTransform::If(int32 Node) {
+    if (CurrentGraph == nullptr) {
+        return IgnoreStatement(Node);
+    }
+
+    UK2Node_IfThenElse* Branch = SpawnNode<UK2Node_IfThenElse>(Node);
+    FinishNode(Branch);
+
+    ConnectValue(Ast->GetChild(Node, 0), Branch->GetConditionPin());
+    ChainExec(Branch->GetExecPin(), Branch->GetThenPin(), Node);
+
+    int32 Column = GetContext().Column;
+
+    Exec(Ast->GetChild(Node, 1));
+    TArray<UEdGraphPin*> ThenEnds = MoveTemp(GetContext().ExecPins);
+
+    // Both branches join on the next statement
+    GetContext().ExecPins = {Branch->GetElsePin()};
+    GetContext().Column = Column;
+
+    Exec(Ast->GetChild(Node, 2));
+    GetContext().ExecPins.Append(ThenEnds);
     return 1;
 }
-int FGKPythonTransform::ifstmt(stmt_ty node_, int depth) {
+
+int FGKPythonTransform::Pass(int32 Node) {
     return 1;
 }
@@ -2,28 +2,81 @@
 
 #pragma once
 
-#include "GKPythonVisitor.h"
+// Gamekit
+#include "GKScriptAstVisitor.h"
 
+class UBlueprint;
+class UEdGraph;
+class UEdGraphNode;
+class UEdGraphPin;
 
 
-
-/* Transform a python script into Blueprint
+/* Transform a parsed script into Blueprint
+ *
+ * Works on the engine owned FGKScriptAst, the script can come from
+ * the native parser or from CPython through FGKPythonLowering.
  */
-class FGKPythonTransform : public PythonASTVisitor 
+class FGKPythonTransform : public FGKScriptAstVisitor<FGKPythonTransform, int>
 {
     public:
 
     FGKPythonTransform(FString OutputPath, class UBlueprint* Dest=nullptr);
 
+    int Transform(FGKScriptAst const& Script);
+
+    EObjectFlags GetObjectFlags() const;
+
+    void AddNode(UEdGraphNode* Node);
+
+    // Create a node in the current graph, configure it then call FinishNode
+    template <typename T>
+    T* SpawnNode(int32 Node, bool bPure = false);
+
+    void FinishNode(UEdGraphNode* Node);
+
+    bool Link(UEdGraphPin* Output, UEdGraphPin* Input, int32 Node);
+
+    // Append a node to the exec chain, Then becomes the end of the chain
+    void ChainExec(UEdGraphPin* Exec, UEdGraphPin* Then, int32 Node);
+
+    // Feed the value of an expression to an input pin
+    bool ConnectValue(int32 Node, UEdGraphPin* Input);
+
+    // Output pin holding the value of a name, a member or a call
+    UEdGraphPin* LowerValue(int32 Node);
+
+    bool IsSelf(int32 Node) const;
+
+    // Class the Blueprint functions and variables are looked up in
+    UClass* GetSelfClass() const;
+
+    // Class of an object pin, nullptr for other pins
+    UClass* GetPinClass(UEdGraphPin* Pin) const;
+
+    class UK2Node_CallFunction* LowerCall(int32 Node);
+
+    int IgnoreStatement(int32 Node);
+
+    // Per function hash stored in the package metadata, empty for graphs made in the editor
+    static FString GetScriptHash(UEdGraph* Graph);
+
+    static void SetScriptHash(UEdGraph* Graph, FString const& Hash);
+
+    // Built from a script, removed when the script no longer defines it
+    static bool IsScriptGraph(UEdGraph* Graph);
+
+    void RemoveFunctionGraph(UEdGraph* Graph);
+
     // Expression
-    int call(expr_ty node_, int depth)override;
+    int Call(int32 Node);
 
     // Statement
-    int classdef(stmt_ty node_, int depth)override;
-    int functiondef(stmt_ty node_, int depth)override;
-    int returnstmt(stmt_ty node_, int depth)override;
-    int assign(stmt_ty node_, int depth) override;
-    int ifstmt(stmt_ty node_, int depth) override;
+    int ClassDef(int32 Node);
+    int FunctionDef(int32 Node);
+    int Return(int32 Node);
+    int Assign(int32 Node);
+    int If(int32 Node);
+    int Pass(int32 Node);
 
 
 
@@ -31,10 +84,30 @@ class FGKPythonTransform : public PythonASTVisitor
     class UBlueprint* Destination;
     class UEdGraph* CurrentGraph;
 
+    // Batch imports skip the transaction buffer and the per node notifications,
+    // Blueprints are compiled once by the caller
+    bool bBatch = false;
+
+    // Blueprints created or patched by the transform, they need a compile
+    TArray<UBlueprint*> Blueprints;
+
+    // Blueprints already up to date with their script
+    int32 NumUnchanged = 0;
+
+    // Script warnings, lowering a function without new ones makes it up to date
+    int32 NumWarnings = 0;
+
+    // Functions of the current class, the others are removed
+    TSet<FName> ScriptFunctions;
+    bool        bModified = false;
+
 
-    // 
+    // State of the function being built
     struct FGKTransfromContext {
         TMap<FName, UEdGraphPin*> ArgNameToPin;
+        TArray<UEdGraphPin*>      ExecPins;         // Ends of the exec chain, several after an if
+        int32                     Returns = INDEX_NONE;
+        int32                     Column  = 0;
     };
 
     TArray<FGKTransfromContext> TransformStack;
@@ -42,4 +115,4 @@ class FGKPythonTransform : public PythonASTVisitor
     FGKTransfromContext& GetContext() {
         return TransformStack.Last();
     }
-};
\ No newline at end of file
+};
@@ -2,6 +2,9 @@
 
 #include "GKPythonVisitor.h"
 
+// Gamekit
+#include "GKPythonInterpreter.h"
+
 // Python
 
 #if WITH_PYTHON
@@ -61,27 +64,74 @@ int visit_withitem(PythonASTVisitor *visitor, withitem_ty node_, int depth);
 int visit_excepthandler(PythonASTVisitor *visitor, excepthandler_ty node_, int depth);
 int visit_body(PythonASTVisitor *visitor, asdl_seq *stmts, int depth);
 
-PythonASTVisitor::PythonASTVisitor() { Py_Initialize(); }
+// The interpreter is shared, it outlives the visitors
+PythonASTVisitor::PythonASTVisitor() { FGKPythonInterpreter::Get().Initialize(); }
 
-PythonASTVisitor::~PythonASTVisitor() { Py_Finalize(); }
+PythonASTVisitor::~PythonASTVisitor() {}
 
-void PythonASTVisitor::ParsePythoCode(const char *str)
+bool PythonASTVisitor::ParsePythoCode(const char *str)
 {
-    PyArena *arena;
+    if (!FGKPythonInterpreter::Get().IsReady())
+    {
+        ParseError = TEXT("Python is not available");
+        return false;
+    }
+
+    // The AST holds python objects, keep the GIL until we are done with it
+    FGKPythonGIL GIL;
+    FGKPyArenaPool& Pool = FGKPythonInterpreter::Get().GetArenaPool();
 
-    arena = PyArena_New();
+    PyArena *arena = Pool.Acquire();
     if (arena == NULL)
     {
-        return;
+        PyErr_Clear();
+        ParseError = TEXT("Could not allocate a PyArena");
+        return false;
     }
 
     PyCompilerFlags *flags = nullptr;
 
     mod_ty module = PyPegen_ASTFromString(str, "<string>", Py_file_input, flags, arena);
 
-    visit(module, 0);
+    if (module != NULL)
+    {
+        visit(module, 0);
+    }
+    else
+    {
+        // SyntaxError(msg, (filename, lineno, offset, text))
+        PyObject *type, *value, *traceback;
+        PyErr_Fetch(&type, &value, &traceback);
+        PyErr_NormalizeException(&type, &value, &traceback);
+
+        ParseError = TEXT("invalid syntax");
+        ParseErrorLine = 0;
+
+        if (value != NULL)
+        {
+            PyObject *message = PyObject_Str(value);
+            if (message != NULL && PyUnicode_Check(message))
+            {
+                ParseError = UTF8_TO_TCHAR(PyUnicode_AsUTF8(message));
+            }
+            Py_XDECREF(message);
+
+            PyObject *lineno = PyObject_GetAttrString(value, "lineno");
+            if (lineno != NULL && PyLong_Check(lineno))
+            {
+                ParseErrorLine = (int)PyLong_AsLong(lineno);
+            }
+            Py_XDECREF(lineno);
+        }
+
+        Py_XDECREF(type);
+        Py_XDECREF(value);
+        Py_XDECREF(traceback);
+        PyErr_Clear();
+    }
 
-    PyArena_Free(arena);
+    Pool.Release(arena, FCStringAnsi::Strlen(str));
+    return module != NULL;
 }
 
 int PythonASTVisitor::visit(mod_ty node_, int depth) { return visit_mod(this, node_, depth); }
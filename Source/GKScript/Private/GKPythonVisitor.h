@@ -13,8 +13,6 @@ extern "C" {
 }
 PRAGMA_ENABLE_REGISTER_WARNINGS
 THIRD_PARTY_INCLUDES_END
-
-DECLARE_STATS_GROUP(TEXT("Python"), STATGROUP_Python, STATCAT_Advanced);
 #endif // WITH_PYTHON
 
 
@@ -27,7 +25,11 @@ class PythonASTVisitor
 
     virtual ~PythonASTVisitor();
 
-    void ParsePythoCode(const char *str);
+    // Returns false on syntax errors, see ParseError
+    bool ParsePythoCode(const char *str);
+
+    FString ParseError;
+    int     ParseErrorLine = 0;
 
     // Module
     virtual int mod_module(mod_ty node_, int depth);
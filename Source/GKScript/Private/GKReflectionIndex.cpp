@@ -0,0 +1,232 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKReflectionIndex.h"
+
+// Gamekit
+#include "GKScript.h"
+#include "GKEdGraphTypes.h"
+#include "GKScriptStats.h"
+
+// Unreal Engine
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/Blueprint.h"
+#include "Misc/PackageName.h"
+#include "UObject/Class.h"
+#include "UObject/UObjectIterator.h"
+
+
+namespace {
+
+const TCHAR* GetKindName(EGKReflectionKind Kind) {
+    switch (Kind) {
+    case EGKReflectionKind::Class:    return TEXT("class");
+    case EGKReflectionKind::Struct:   return TEXT("struct");
+    case EGKReflectionKind::Enum:     return TEXT("enum");
+    case EGKReflectionKind::Function: return TEXT("function");
+    default:                          return TEXT("unknown");
+    }
+}
+
+// Names that were never interned cannot be in the index
+FName FindName(FStringView Name) {
+    return FName(Name, FNAME_Find);
+}
+
+} // namespace
+
+
+UObject* FGKReflectionEntry::Resolve() {
+    if (UObject* Found = Object.Get()) {
+        return Found;
+    }
+
+    if (Path.IsNull()) {
+        return nullptr;
+    }
+
+    UObject* Loaded = Path.TryLoad();
+    Object = Loaded;
+    return Loaded;
+}
+
+
+FGKReflectionIndex& FGKReflectionIndex::Get() {
+    static FGKReflectionIndex Index;
+    return Index;
+}
+
+void FGKReflectionIndex::Reset() {
+    for (TMap<FName, FGKReflectionEntry>& Map : Entries) {
+        Map.Reset();
+    }
+    bBuilt = false;
+}
+
+void FGKReflectionIndex::Add(EGKReflectionKind Kind, FName Name, UObject* Object) {
+    FGKReflectionEntry& Entry = GetEntries(Kind).FindOrAdd(Name);
+
+    if (Entry.Count == 0) {
+        Entry.Object = Object;
+        Entry.Path = FSoftObjectPath(Object);
+        Entry.Count = 1;
+        return;
+    }
+
+    // Same definition seen twice, loaded Blueprint and asset registry
+    if (Entry.Object.Get() == Object || Entry.Path == FSoftObjectPath(Object)) {
+        return;
+    }
+
+    Entry.Other = FSoftObjectPath(Object);
+    Entry.Count += 1;
+}
+
+void FGKReflectionIndex::Add(EGKReflectionKind Kind, FName Name, FSoftObjectPath const& Path) {
+    FGKReflectionEntry& Entry = GetEntries(Kind).FindOrAdd(Name);
+
+    if (Entry.Count == 0) {
+        Entry.Path = Path;
+        Entry.Count = 1;
+        return;
+    }
+
+    if (Entry.Path == Path) {
+        return;
+    }
+
+    Entry.Other = Path;
+    Entry.Count += 1;
+}
+
+void FGKReflectionIndex::Build() {
+    GKSCRIPT_SCOPE(STAT_GKScript_ReflectionIndex);
+    double Start = FPlatformTime::Seconds();
+    bBuilt = true;
+
+    // Native classes, Blueprint classes come from the asset registry
+    for (TObjectIterator<UClass> It; It; ++It) {
+        UClass* Class = *It;
+
+        if (Class->HasAnyClassFlags(CLASS_CompiledFromBlueprint | CLASS_NewerVersionExists)) {
+            continue;
+        }
+
+        Add(EGKReflectionKind::Class, Class->GetFName(), Class);
+
+        // Only what a graph can call
+        for (TFieldIterator<UFunction> FuncIt(Class, EFieldIteratorFlags::ExcludeSuper); FuncIt; ++FuncIt) {
+            UFunction* Function = *FuncIt;
+
+            if (Function->HasAnyFunctionFlags(FUNC_BlueprintCallable | FUNC_BlueprintEvent)) {
+                Add(EGKReflectionKind::Function, Function->GetFName(), Function);
+            }
+        }
+    }
+
+    for (TObjectIterator<UScriptStruct> It; It; ++It) {
+        Add(EGKReflectionKind::Struct, It->GetFName(), *It);
+    }
+
+    for (TObjectIterator<UEnum> It; It; ++It) {
+        Add(EGKReflectionKind::Enum, It->GetFName(), *It);
+    }
+
+    // Blueprint classes, without loading them
+    IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+    FARFilter Filter;
+    Filter.ClassPaths.Add(UBlueprint::StaticClass()->GetClassPathName());
+    Filter.bRecursiveClasses = true;
+
+    TArray<FAssetData> Assets;
+    AssetRegistry.GetAssets(Filter, Assets);
+
+    for (FAssetData const& Asset : Assets) {
+        FString GeneratedClassPath;
+        if (!Asset.GetTagValue(FBlueprintTags::GeneratedClassPath, GeneratedClassPath)) {
+            continue;
+        }
+
+        FSoftObjectPath ClassPath(FPackageName::ExportTextPathToObjectPath(GeneratedClassPath));
+        Add(EGKReflectionKind::Class, Asset.AssetName, ClassPath);
+        Add(EGKReflectionKind::Class, FName(ClassPath.GetAssetName()), ClassPath);
+    }
+
+    GKSCRIPT_VERBOSE(TEXT("Reflection index: %d classes, %d structs, %d enums, %d functions in %.2f ms"),
+        GetEntries(EGKReflectionKind::Class).Num(),
+        GetEntries(EGKReflectionKind::Struct).Num(),
+        GetEntries(EGKReflectionKind::Enum).Num(),
+        GetEntries(EGKReflectionKind::Function).Num(),
+        (FPlatformTime::Seconds() - Start) * 1000.0
+    );
+}
+
+void FGKReflectionIndex::AddBlueprint(UBlueprint* Blueprint) {
+    // Annotations that named it before it existed were cached as unknown
+    FGKPinTypeResolver::Get().ForgetUnresolved();
+
+    if (!bBuilt || Blueprint == nullptr || Blueprint->GeneratedClass == nullptr) {
+        return;
+    }
+
+    Add(EGKReflectionKind::Class, Blueprint->GetFName(), Blueprint->GeneratedClass);
+    Add(EGKReflectionKind::Class, Blueprint->GeneratedClass->GetFName(), Blueprint->GeneratedClass);
+}
+
+UObject* FGKReflectionIndex::Find(FStringView Name, EGKReflectionKind Kind) {
+    if (!bBuilt) {
+        Build();
+    }
+
+    FName Key = FindName(Name);
+    if (Key.IsNone()) {
+        return nullptr;
+    }
+
+    FGKReflectionEntry* Entry = GetEntries(Kind).Find(Key);
+    if (Entry == nullptr) {
+        return nullptr;
+    }
+
+    if (Entry->IsAmbiguous()) {
+        GKSCRIPT_WARNING(TEXT("%s %s is ambiguous, %d definitions: %s, %s"),
+            GetKindName(Kind),
+            *Key.ToString(),
+            Entry->Count,
+            *Entry->Path.ToString(),
+            *Entry->Other.ToString()
+        );
+        return nullptr;
+    }
+
+    return Entry->Resolve();
+}
+
+UClass* FGKReflectionIndex::FindClass(FStringView Name) {
+    return Cast<UClass>(Find(Name, EGKReflectionKind::Class));
+}
+
+UScriptStruct* FGKReflectionIndex::FindStruct(FStringView Name) {
+    return Cast<UScriptStruct>(Find(Name, EGKReflectionKind::Struct));
+}
+
+UEnum* FGKReflectionIndex::FindEnum(FStringView Name) {
+    return Cast<UEnum>(Find(Name, EGKReflectionKind::Enum));
+}
+
+UFunction* FGKReflectionIndex::FindFunction(FStringView Name, UClass* Scope) {
+    // Members shadow the global functions, FindFunctionByName is a map lookup per class
+    if (Scope != nullptr) {
+        FName Key = FindName(Name);
+        if (Key.IsNone()) {
+            return nullptr;
+        }
+
+        if (UFunction* Function = Scope->FindFunctionByName(Key, EIncludeSuperFlag::IncludeSuper)) {
+            return Function;
+        }
+    }
+
+    return Cast<UFunction>(Find(Name, EGKReflectionKind::Function));
+}
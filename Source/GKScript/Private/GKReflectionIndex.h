@@ -0,0 +1,88 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Unreal Engine
+#include "CoreMinimal.h"
+#include "UObject/SoftObjectPath.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class UBlueprint;
+
+
+enum class EGKReflectionKind : uint8 {
+    Class,
+    Struct,
+    Enum,
+    Function,
+    Count
+};
+
+struct FGKReflectionEntry {
+    // Resolve the entry, Blueprint classes are loaded on first use
+    UObject* Resolve();
+
+    bool IsAmbiguous() const {
+        return Count > 1;
+    }
+
+    TWeakObjectPtr<UObject> Object;
+    FSoftObjectPath         Path;       // Blueprint classes that are not loaded yet
+    FSoftObjectPath         Other;      // Another definition, for the ambiguity report
+    int32                   Count = 0;
+};
+
+
+/*! Name to reflected type lookup for the script import
+ *
+ * Built once, on first use, from reflection (native classes, structs, enums, Blueprint callable functions)
+ * and from the asset registry (Blueprint classes, without loading them).
+ * Every name a script can reference is a single hash lookup on its FName,
+ * names that were never interned are rejected without touching the maps.
+ *
+ * Blueprints are indexed under their asset name and their generated class name,
+ * ``BP_Controller`` and ``BP_Controller_C`` resolve to the same class.
+ *
+ * A name defined more than once for the same kind is ambiguous, the lookup fails
+ * and reports both definitions instead of picking one at random like ``FindObject(ANY_PACKAGE)``.
+ *
+ * .. note::
+ *
+ *    The index is built and used on the game thread
+ */
+class FGKReflectionIndex
+{
+    public:
+    static FGKReflectionIndex& Get();
+
+    UObject* Find(FStringView Name, EGKReflectionKind Kind);
+
+    UClass* FindClass(FStringView Name);
+
+    UScriptStruct* FindStruct(FStringView Name);
+
+    UEnum* FindEnum(FStringView Name);
+
+    // Functions of Scope and its parents first, then every Blueprint callable function
+    UFunction* FindFunction(FStringView Name, UClass* Scope = nullptr);
+
+    // Register a Blueprint created after the index was built
+    void AddBlueprint(UBlueprint* Blueprint);
+
+    // Drop the index, it is rebuilt on the next lookup
+    void Reset();
+
+    private:
+    void Build();
+
+    void Add(EGKReflectionKind Kind, FName Name, UObject* Object);
+
+    void Add(EGKReflectionKind Kind, FName Name, FSoftObjectPath const& Path);
+
+    TMap<FName, FGKReflectionEntry>& GetEntries(EGKReflectionKind Kind) {
+        return Entries[uint8(Kind)];
+    }
+
+    TMap<FName, FGKReflectionEntry> Entries[uint8(EGKReflectionKind::Count)];
+    bool                            bBuilt = false;
+};
@@ -6,7 +6,12 @@
 DEFINE_LOG_CATEGORY(LogGKScript)
 
 // Gamekit
+#include "GKClassDefaults.h"
+#include "GKCodePreview.h"
+#include "GKGenerateOnSave.h"
 #include "GKMenus.h"
+#include "GKPythonInterpreter.h"
+#include "GKScriptBytecode.h"
 
 // Unreal Engine
 #include "Engine/Blueprint.h"
@@ -19,10 +24,19 @@ DEFINE_LOG_CATEGORY(LogGKScript)
 void FGKScriptModule::StartupModule()
 {
     ExtendContentBrowserAssetSelection();
+    RegisterLazyGraphSynthesis();
+    FGKClassDefaults::Get().Register();
+    FGKCodePreview::Get().Register();
+    FGKGenerateOnSave::Get().Register();
 }
 
 void FGKScriptModule::ShutdownModule()
 {
+    FGKGenerateOnSave::Get().Unregister();
+    FGKCodePreview::Get().Unregister();
+    FGKClassDefaults::Get().Unregister();
+    UnregisterLazyGraphSynthesis();
+    FGKPythonInterpreter::Get().Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,167 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKScriptAst.h"
+
+// Unreal Engine
+#include "Hash/CityHash.h"
+
+
+const TCHAR* ToString(EGKAstKind Kind) {
+    switch (Kind) {
+    #define NODE(Name) case EGKAstKind::Name: return TEXT(#Name);
+        GKAST_KINDS(NODE)
+    #undef NODE
+    }
+    return TEXT("Unknown");
+}
+
+const TCHAR* ToString(EGKAstOp Op) {
+    switch (Op) {
+    case EGKAstOp::None:  return TEXT("");
+    case EGKAstOp::Add:   return TEXT("+");
+    case EGKAstOp::Sub:   return TEXT("-");
+    case EGKAstOp::Mult:  return TEXT("*");
+    case EGKAstOp::Div:   return TEXT("/");
+    case EGKAstOp::Mod:   return TEXT("%");
+    case EGKAstOp::USub:  return TEXT("-");
+    case EGKAstOp::Not:   return TEXT("not");
+    case EGKAstOp::And:   return TEXT("and");
+    case EGKAstOp::Or:    return TEXT("or");
+    case EGKAstOp::Eq:    return TEXT("==");
+    case EGKAstOp::NotEq: return TEXT("!=");
+    case EGKAstOp::Lt:    return TEXT("<");
+    case EGKAstOp::LtE:   return TEXT("<=");
+    case EGKAstOp::Gt:    return TEXT(">");
+    case EGKAstOp::GtE:   return TEXT(">=");
+    case EGKAstOp::Is:    return TEXT("is");
+    case EGKAstOp::IsNot: return TEXT("is not");
+    case EGKAstOp::In:    return TEXT("in");
+    case EGKAstOp::NotIn: return TEXT("not in");
+    }
+    return TEXT("?");
+}
+
+void FGKScriptAst::Reset() {
+    Nodes.Reset();
+    Children.Reset();
+    Strings.Reset();
+    Root = INDEX_NONE;
+}
+
+int32 FGKScriptAst::AddNode(EGKAstKind Kind, int32 Value, TArrayView<const int32> Kids, int32 Line, uint8 Op) {
+    FGKAstNode Node;
+    Node.Kind = Kind;
+    Node.Op = Op;
+    Node.Value = Value;
+    Node.First = Children.Num();
+    Node.Num = Kids.Num();
+    Node.Line = Line;
+
+    Children.Append(Kids.GetData(), Kids.Num());
+    return Nodes.Add(Node);
+}
+
+FArchive& operator<<(FArchive& Ar, FGKAstNode& Node) {
+    Ar << Node.Kind;
+    Ar << Node.Op;
+    Ar << Node.Value;
+    Ar << Node.First;
+    Ar << Node.Num;
+    Ar << Node.Line;
+    return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FGKScriptAst& Ast) {
+    Ar << Ast.Nodes;
+    Ar << Ast.Children;
+    Ar << Ast.Strings;
+    Ar << Ast.Root;
+    return Ar;
+}
+
+uint32 FGKStringViewKeyFuncs::GetKeyHash(FStringView Key) {
+    return CityHash32((const char*)Key.GetData(), Key.Len() * sizeof(TCHAR));
+}
+
+int32 FGKScriptAstBuilder::Intern(FStringView Str) {
+    if (int32 const* Id = StringIds.Find(Str)) {
+        return *Id;
+    }
+
+    // The FString buffer does not move when Strings grows, the view stays valid
+    int32 Id = Ast.Strings.Emplace(Str);
+    StringIds.Add(FStringView(Ast.Strings[Id]), Id);
+    return Id;
+}
+
+FStringView FGKScriptAst::GetDocstring(int32 Body) const {
+    int32 First = GetChild(Body, 0);
+    if (First == INDEX_NONE || Nodes[First].Kind != EGKAstKind::ExprStmt) {
+        return FStringView();
+    }
+
+    int32 Value = GetChild(First, 0);
+    if (Value == INDEX_NONE || Nodes[Value].Kind != EGKAstKind::Constant ||
+        Nodes[Value].Op != uint8(EGKAstConstant::String)) {
+        return FStringView();
+    }
+    return GetValue(Value);
+}
+
+uint64 FGKScriptAst::Hash(int32 Node) const {
+    if (Node == INDEX_NONE) {
+        return 0;
+    }
+
+    FGKAstNode const& N = Nodes[Node];
+    FStringView Value = GetValue(Node);
+
+    uint64 Result = CityHash64WithSeed((const char*)Value.GetData(), Value.Len() * sizeof(TCHAR), (uint64(N.Kind) << 8) | N.Op);
+    Result = CityHash128to64({Result, uint64(N.Num)});
+
+    for (int32 Child : GetChildren(Node)) {
+        Result = CityHash128to64({Result, Hash(Child)});
+    }
+    return Result;
+}
+
+FString FGKScriptAst::ToString() const {
+    FString Out;
+
+    TFunction<void(int32, int32)> Dump = [&](int32 Node, int32 Depth) {
+        for (int32 i = 0; i < Depth; i++) {
+            Out += TEXT("  ");
+        }
+
+        if (Node == INDEX_NONE) {
+            Out += TEXT("-\n");
+            return;
+        }
+
+        FGKAstNode const& N = Nodes[Node];
+        Out += ::ToString(N.Kind);
+
+        FStringView Value = GetValue(Node);
+        if (!Value.IsEmpty()) {
+            Out += TEXT(" ");
+            Out += Value;
+        }
+        if (N.Kind == EGKAstKind::UnaryOp || N.Kind == EGKAstKind::BinOp ||
+            N.Kind == EGKAstKind::BoolOp || N.Kind == EGKAstKind::Compare ||
+            N.Kind == EGKAstKind::AugAssign) {
+            Out += TEXT(" ");
+            Out += ::ToString(EGKAstOp(N.Op));
+        }
+        Out += TEXT("\n");
+
+        for (int32 Child : GetChildren(Node)) {
+            Dump(Child, Depth + 1);
+        }
+    };
+
+    if (Root != INDEX_NONE) {
+        Dump(Root, 0);
+    }
+    return Out;
+}
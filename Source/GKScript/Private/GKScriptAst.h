@@ -0,0 +1,183 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Unreal Engine
+#include "CoreMinimal.h"
+
+
+// Node kinds and the layout of their children
+//
+// clang-format off
+#define GKAST_KINDS(NODE)\
+    /* Statements */\
+    NODE(Module)        /* [stmt...]                                                          */\
+    NODE(Block)         /* [node...]                                                          */\
+    NODE(Import)        /* Value: module                                                      */\
+    NODE(ImportFrom)    /* Value: module, [Name...]                                           */\
+    NODE(ClassDef)      /* Value: name, [Block(bases), Block(decorators), Block(body)]        */\
+    NODE(FunctionDef)   /* Value: name, [Block(decorators), Block(Arg...), returns?, Block(body)] */\
+    NODE(Arg)           /* Value: name, [annotation?, default?]                               */\
+    NODE(Return)        /* [value?]                                                           */\
+    NODE(Assign)        /* [target..., value]                                                 */\
+    NODE(AnnAssign)     /* [target, annotation, value?]                                       */\
+    NODE(AugAssign)     /* Op, [target, value]                                                */\
+    NODE(ExprStmt)      /* [value]                                                            */\
+    NODE(If)            /* [test, Block(body), Block(orelse)]                                 */\
+    NODE(Match)         /* [subject, Case...]                                                 */\
+    NODE(Case)          /* [pattern, Block(body)]                                             */\
+    NODE(Pass)\
+    /* Expressions */\
+    NODE(Name)          /* Value: id                                                          */\
+    NODE(Attribute)     /* Value: attr, [value]                                               */\
+    NODE(Call)          /* [func, arg..., Keyword...]                                         */\
+    NODE(Keyword)       /* Value: arg, [value]                                                */\
+    NODE(Constant)      /* Op: EGKAstConstant, Value: literal                                 */\
+    NODE(Tuple)         /* [elt...]                                                           */\
+    NODE(List)          /* [elt...]                                                           */\
+    NODE(Subscript)     /* [value, index]                                                     */\
+    NODE(UnaryOp)       /* Op, [operand]                                                      */\
+    NODE(BinOp)         /* Op, [left, right]                                                  */\
+    NODE(BoolOp)        /* Op, [left, right]                                                  */\
+    NODE(Compare)       /* Op, [left, right]                                                  */
+// clang-format on
+
+enum class EGKAstKind : uint8 {
+    #define NODE(Name) Name,
+        GKAST_KINDS(NODE)
+    #undef NODE
+};
+
+enum class EGKAstConstant : uint8 {
+    None,
+    True,
+    False,
+    Int,
+    Real,
+    String,
+};
+
+enum class EGKAstOp : uint8 {
+    None,
+    Add,
+    Sub,
+    Mult,
+    Div,
+    Mod,
+    USub,
+    Not,
+    And,
+    Or,
+    Eq,
+    NotEq,
+    Lt,
+    LtE,
+    Gt,
+    GtE,
+    Is,
+    IsNot,
+    In,
+    NotIn,
+};
+
+const TCHAR* ToString(EGKAstKind Kind);
+const TCHAR* ToString(EGKAstOp Op);
+
+
+struct FGKAstNode {
+    EGKAstKind Kind   = EGKAstKind::Pass;
+    uint8      Op     = 0;              // EGKAstOp or EGKAstConstant
+    int32      Value  = INDEX_NONE;     // Index in the string table
+    int32      First  = 0;              // First child in FGKScriptAst::Children
+    int32      Num    = 0;              // Number of children
+    int32      Line   = 0;
+};
+
+
+/*! Engine owned AST of a .us script
+ *
+ * Nodes live in one contiguous array and reference their children through
+ * a range of ``Children``, identifiers and literals are interned in ``Strings``.
+ * Optional children are stored as INDEX_NONE so every kind has a fixed layout,
+ * see EGKAstKind.
+ *
+ * Nothing points into the parser or the python interpreter, the AST can be kept,
+ * copied and read from several threads at once.
+ */
+struct FGKScriptAst {
+    TArray<FGKAstNode> Nodes;
+    TArray<int32>      Children;
+    TArray<FString>    Strings;
+    int32              Root = INDEX_NONE;
+
+    void Reset();
+
+    int32 AddNode(EGKAstKind Kind, int32 Value, TArrayView<const int32> Kids, int32 Line, uint8 Op = 0);
+
+    FGKAstNode const& Get(int32 Node) const {
+        return Nodes[Node];
+    }
+
+    TArrayView<const int32> GetChildren(int32 Node) const {
+        FGKAstNode const& N = Nodes[Node];
+        return TArrayView<const int32>(Children.GetData() + N.First, N.Num);
+    }
+
+    // Returns INDEX_NONE for missing children
+    int32 GetChild(int32 Node, int32 i) const {
+        FGKAstNode const& N = Nodes[Node];
+        return i < N.Num ? Children[N.First + i] : INDEX_NONE;
+    }
+
+    // Empty string when the node has no value
+    FStringView GetValue(int32 Node) const {
+        int32 Value = Nodes[Node].Value;
+        return Value != INDEX_NONE ? FStringView(Strings[Value]) : FStringView();
+    }
+
+    // Docstring of a module, class or function body, empty if none
+    FStringView GetDocstring(int32 Body) const;
+
+    // Structural hash of a subtree, lines are ignored so moving code around
+    // or editing comments does not change it
+    uint64 Hash(int32 Node) const;
+
+    // Debug dump, one node per line
+    FString ToString() const;
+};
+
+FArchive& operator<<(FArchive& Ar, FGKAstNode& Node);
+FArchive& operator<<(FArchive& Ar, FGKScriptAst& Ast);
+
+
+// Identifiers are case sensitive, FString keys are not
+struct FGKStringViewKeyFuncs : TDefaultMapKeyFuncs<FStringView, int32, false> {
+    static bool Matches(FStringView A, FStringView B) {
+        return A.Equals(B, ESearchCase::CaseSensitive);
+    }
+
+    static uint32 GetKeyHash(FStringView Key);
+};
+
+
+/*! Build an AST, interning its strings
+ *
+ * Interned strings are looked up by views into ``Ast.Strings``,
+ * the builder must not outlive the build.
+ */
+struct FGKScriptAstBuilder {
+    FGKScriptAstBuilder(FGKScriptAst& Ast): Ast(Ast) {
+        Ast.Reset();
+    }
+
+    int32 Intern(FStringView Str);
+
+    int32 AddNode(EGKAstKind Kind, int32 Value, TArrayView<const int32> Kids, int32 Line, uint8 Op = 0) {
+        return Ast.AddNode(Kind, Value, Kids, Line, Op);
+    }
+
+    FGKScriptAst& Ast;
+
+    private:
+    TMap<FStringView, int32, FDefaultSetAllocator, FGKStringViewKeyFuncs> StringIds;
+};
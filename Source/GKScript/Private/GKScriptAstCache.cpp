@@ -0,0 +1,310 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKScriptAstCache.h"
+
+// Gamekit
+#include "GKScript.h"
+#include "GKScriptStats.h"
+
+// Unreal Engine
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+
+namespace {
+
+const uint32 GKAstCacheMagic = 0x53414B47;    // GKAS
+const uint32 GKAstCacheFormat = 1;
+
+TAutoConsoleVariable<int32> CVarGKScriptAstCacheMaxMB(
+    TEXT("GKScript.AstCacheMaxMB"),
+    256,
+    TEXT("Size of the on disk AST cache, in MiB, least recently used entries are evicted past it"),
+    ECVF_Default
+);
+
+struct FGKAstCacheHeader {
+    uint32 Magic;
+    uint32 Format;
+    uint32 ParserVersion;
+    uint32 CharSize;
+    uint64 Key;
+    int32  Root;
+    int32  NumNodes;
+    int32  NumChildren;
+    int32  NumStrings;
+    int32  NumChars;
+    int32  Padding;
+};
+
+static_assert(TIsTriviallyCopyConstructible<FGKAstNode>::Value, "FGKAstNode is copied as is");
+
+template <typename T>
+void AppendBytes(TArray<uint8>& Bytes, T const* Data, int32 Num) {
+    Bytes.Append(reinterpret_cast<uint8 const*>(Data), Num * sizeof(T));
+}
+
+template <typename T, typename Allocator>
+bool ReadArray(IFileHandle& File, TArray<T, Allocator>& Array, int32 Num) {
+    Array.SetNumUninitialized(Num);
+    return File.Read(reinterpret_cast<uint8*>(Array.GetData()), int64(Num) * sizeof(T));
+}
+
+constexpr int32 GKAstNumKinds = 0
+    #define NODE(Name) + 1
+        GKAST_KINDS(NODE)
+    #undef NODE
+    ;
+
+bool IsValidNode(FGKAstNode const& Node, int32 NumChildren, int32 NumStrings) {
+    if (uint8(Node.Kind) >= GKAstNumKinds ||
+        Node.First < 0 || Node.Num < 0 || Node.First > NumChildren - Node.Num ||
+        Node.Value < INDEX_NONE || Node.Value >= NumStrings) {
+        return false;
+    }
+
+    switch (Node.Kind) {
+    case EGKAstKind::Constant:
+        return Node.Op <= uint8(EGKAstConstant::String);
+    case EGKAstKind::UnaryOp:
+    case EGKAstKind::BinOp:
+    case EGKAstKind::BoolOp:
+    case EGKAstKind::Compare:
+    case EGKAstKind::AugAssign:
+        return Node.Op <= uint8(EGKAstOp::NotIn);
+    default:
+        return Node.Op == 0;
+    }
+}
+
+// The arrays are read straight into the AST, only the strings are rebuilt
+bool ReadAst(IFileHandle& File, uint64 Key, FGKScriptAst& Ast) {
+    FGKAstCacheHeader Header;
+    if (!File.Read(reinterpret_cast<uint8*>(&Header), sizeof(Header))) {
+        return false;
+    }
+
+    if (Header.Magic != GKAstCacheMagic ||
+        Header.Format != GKAstCacheFormat ||
+        Header.ParserVersion != FGKScriptParser::Version ||
+        Header.CharSize != sizeof(TCHAR) ||
+        Header.Key != Key ||
+        Header.NumNodes < 0 || Header.NumChildren < 0 || Header.NumStrings < 0 || Header.NumChars < 0 ||
+        Header.Root < INDEX_NONE || Header.Root >= Header.NumNodes) {
+        return false;
+    }
+
+    int64 Size =
+        sizeof(Header) +
+        int64(Header.NumNodes) * sizeof(FGKAstNode) +
+        (int64(Header.NumChildren) + Header.NumStrings + 1) * sizeof(int32) +
+        int64(Header.NumChars) * sizeof(TCHAR);
+
+    if (File.Size() != Size) {
+        return false;
+    }
+
+    TArray<int32>  Offsets;
+    TArray<TCHAR>  Chars;
+
+    if (!ReadArray(File, Ast.Nodes, Header.NumNodes) ||
+        !ReadArray(File, Ast.Children, Header.NumChildren) ||
+        !ReadArray(File, Offsets, Header.NumStrings + 1) ||
+        !ReadArray(File, Chars, Header.NumChars)) {
+        return false;
+    }
+
+    // A corrupted entry is a miss, not a crash
+    for (FGKAstNode const& Node : Ast.Nodes) {
+        if (!IsValidNode(Node, Header.NumChildren, Header.NumStrings)) {
+            return false;
+        }
+    }
+    for (int32 Child : Ast.Children) {
+        if (Child < INDEX_NONE || Child >= Header.NumNodes) {
+            return false;
+        }
+    }
+    for (int32 i = 0; i < Header.NumStrings; i++) {
+        if (Offsets[i] < 0 || Offsets[i] > Offsets[i + 1] || Offsets[i + 1] > Header.NumChars) {
+            return false;
+        }
+    }
+
+    Ast.Strings.Reserve(Header.NumStrings);
+    for (int32 i = 0; i < Header.NumStrings; i++) {
+        Ast.Strings.Emplace(FStringView(Chars.GetData() + Offsets[i], Offsets[i + 1] - Offsets[i]));
+    }
+
+    Ast.Root = Header.Root;
+    return true;
+}
+
+} // namespace
+
+
+FGKScriptAstCache& FGKScriptAstCache::Get() {
+    static FGKScriptAstCache Cache;
+    return Cache;
+}
+
+FGKScriptAstCache::FGKScriptAstCache() {
+    CacheDir = FPaths::ProjectSavedDir() / TEXT("GKScript") / TEXT("AstCache");
+}
+
+uint64 FGKScriptAstCache::MakeKey(FStringView Source) {
+    uint64 Seed = (uint64(GKAstCacheFormat) << 32) | uint64(FGKScriptParser::Version);
+    return CityHash64WithSeed((const char*)Source.GetData(), Source.Len() * sizeof(TCHAR), Seed);
+}
+
+FString FGKScriptAstCache::GetPath(uint64 Key) const {
+    return CacheDir / FString::Printf(TEXT("%016llx.gkast"), Key);
+}
+
+bool FGKScriptAstCache::GetOrParse(FStringView Source, FGKScriptAst& Ast, FGKScriptParseError& Error, bool* bHit) {
+    uint64 Key = MakeKey(Source);
+
+    if (Load(Key, Ast)) {
+        if (bHit) {
+            *bHit = true;
+        }
+        return true;
+    }
+
+    if (bHit) {
+        *bHit = false;
+    }
+
+    // Scripts that do not parse are not cached, the error is reported every time
+    if (!FGKScriptParser::Parse(Source, Ast, Error)) {
+        return false;
+    }
+
+    Store(Key, Ast);
+    return true;
+}
+
+bool FGKScriptAstCache::Load(uint64 Key, FGKScriptAst& Ast) const {
+    GKSCRIPT_SCOPE(STAT_GKScript_AstCache);
+    FString Path = GetPath(Key);
+
+    TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Path));
+    if (!File) {
+        return false;
+    }
+
+    Ast.Reset();
+    if (!ReadAst(*File, Key, Ast)) {
+        Ast.Reset();
+        return false;
+    }
+    File.Reset();
+
+    // Entries are evicted least recently used first
+    IFileManager::Get().SetTimeStamp(*Path, FDateTime::UtcNow());
+    return true;
+}
+
+void FGKScriptAstCache::Trim() const {
+    GKSCRIPT_SCOPE(STAT_GKScript_AstCache);
+    int64 MaxBytes = int64(FMath::Max(CVarGKScriptAstCacheMaxMB.GetValueOnAnyThread(), 0)) * 1024 * 1024;
+
+    struct FEntry {
+        FString   Path;
+        FDateTime TimeStamp;
+        int64     Size;
+    };
+
+    TArray<FEntry> Entries;
+    int64 Total = 0;
+
+    IFileManager::Get().IterateDirectoryStat(*CacheDir, [&](const TCHAR* Path, FFileStatData const& Stat) {
+        if (!Stat.bIsDirectory && FStringView(Path).EndsWith(TEXT(".gkast"))) {
+            Entries.Add({Path, Stat.ModificationTime, Stat.FileSize});
+            Total += Stat.FileSize;
+        }
+        return true;
+    });
+
+    if (Total <= MaxBytes) {
+        return;
+    }
+
+    Entries.Sort([](FEntry const& A, FEntry const& B) {
+        return A.TimeStamp < B.TimeStamp;
+    });
+
+    int32 NumEvicted = 0;
+    for (FEntry const& Entry : Entries) {
+        if (Total <= MaxBytes) {
+            break;
+        }
+        if (IFileManager::Get().Delete(*Entry.Path, false, false, true)) {
+            Total -= Entry.Size;
+            NumEvicted += 1;
+        }
+    }
+    GKSCRIPT_LOG(TEXT("Evicted %d AST cache entries, %.1f MiB left"), NumEvicted, Total / (1024.0 * 1024.0));
+}
+
+bool FGKScriptAstCache::Store(uint64 Key, FGKScriptAst const& Ast) const {
+    GKSCRIPT_SCOPE(STAT_GKScript_AstCache);
+    TArray<int32> Offsets;
+    Offsets.Reserve(Ast.Strings.Num() + 1);
+
+    int32 NumChars = 0;
+    for (FString const& Str : Ast.Strings) {
+        Offsets.Add(NumChars);
+        NumChars += Str.Len();
+    }
+    Offsets.Add(NumChars);
+
+    FGKAstCacheHeader Header;
+    FMemory::Memzero(Header);
+    Header.Magic = GKAstCacheMagic;
+    Header.Format = GKAstCacheFormat;
+    Header.ParserVersion = FGKScriptParser::Version;
+    Header.CharSize = sizeof(TCHAR);
+    Header.Key = Key;
+    Header.Root = Ast.Root;
+    Header.NumNodes = Ast.Nodes.Num();
+    Header.NumChildren = Ast.Children.Num();
+    Header.NumStrings = Ast.Strings.Num();
+    Header.NumChars = NumChars;
+
+    TArray<uint8> Bytes;
+    Bytes.Reserve(
+        sizeof(Header) +
+        Ast.Nodes.Num() * sizeof(FGKAstNode) +
+        (Ast.Children.Num() + Offsets.Num()) * sizeof(int32) +
+        NumChars * sizeof(TCHAR)
+    );
+
+    AppendBytes(Bytes, &Header, 1);
+    AppendBytes(Bytes, Ast.Nodes.GetData(), Ast.Nodes.Num());
+    AppendBytes(Bytes, Ast.Children.GetData(), Ast.Children.Num());
+    AppendBytes(Bytes, Offsets.GetData(), Offsets.Num());
+    for (FString const& Str : Ast.Strings) {
+        AppendBytes(Bytes, *Str, Str.Len());
+    }
+
+    // Readers never see a partial file
+    FString Path = GetPath(Key);
+    FString TempPath = FString::Printf(TEXT("%s.%u.%u.tmp"), *Path, FPlatformProcess::GetCurrentProcessId(), FPlatformTLS::GetCurrentThreadId());
+
+    if (!FFileHelper::SaveArrayToFile(Bytes, *TempPath)) {
+        GKSCRIPT_WARNING(TEXT("Could not write %s"), *TempPath);
+        return false;
+    }
+
+    if (!IFileManager::Get().Move(*Path, *TempPath, true, true, false, true)) {
+        IFileManager::Get().Delete(*TempPath, false, false, true);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Gamekit
+#include "GKScriptAst.h"
+#include "GKScriptParser.h"
+
+// Unreal Engine
+#include "CoreMinimal.h"
+
+
+/*! On disk cache of parsed scripts
+ *
+ * ASTs are stored in ``Saved/GKScript/AstCache`` in a flat binary layout,
+ * one file per script, named after the hash of the script content and the parser version.
+ * Nodes and children are read straight into the AST, only the strings are rebuilt,
+ * re-importing an unchanged script skips the parse entirely.
+ * The cache is trimmed to ``GKScript.AstCacheMaxMB`` before each batch, least recently used first.
+ *
+ * Entries are written to a temporary file and renamed, the cache can be used
+ * from several threads and processes at once.
+ */
+class FGKScriptAstCache
+{
+    public:
+    static FGKScriptAstCache& Get();
+
+    // Load the AST from the cache, parse and store it on a miss
+    bool GetOrParse(FStringView Source, FGKScriptAst& Ast, FGKScriptParseError& Error, bool* bHit = nullptr);
+
+    bool Load(uint64 Key, FGKScriptAst& Ast) const;
+
+    bool Store(uint64 Key, FGKScriptAst const& Ast) const;
+
+    // Evict the least recently used entries until the cache fits its budget
+    void Trim() const;
+
+    // Hash of the content and of the parser version
+    static uint64 MakeKey(FStringView Source);
+
+    FString GetPath(uint64 Key) const;
+
+    FString CacheDir;
+
+    private:
+    FGKScriptAstCache();
+};
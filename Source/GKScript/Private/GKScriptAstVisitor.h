@@ -0,0 +1,63 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Gamekit
+#include "GKScriptAst.h"
+
+
+/*! Static dispatch over the nodes of an FGKScriptAst
+ *
+ * The AST is only read, several visitors can traverse the same AST
+ * at the same time from different threads.
+ * Kinds that are not implemented by ``Impl`` traverse their children.
+ */
+template <typename Impl, typename ReturnType, typename... Args>
+struct FGKScriptAstVisitor {
+
+    ReturnType Exec(int32 Node, Args... args) {
+        if (Node == INDEX_NONE) {
+            return ReturnType();
+        }
+
+        switch (Ast->Get(Node).Kind) {
+
+        // Generate Static dispatch
+        // ------------------------
+        //
+        // clang-format off
+        #define NODE(Kind)\
+            case EGKAstKind::Kind:\
+                return static_cast<Impl&>(*this).Kind(Node, args...);
+
+            GKAST_KINDS(NODE)
+
+        #undef NODE
+        // clang-format on
+        }
+
+        return ReturnType();
+    }
+
+    ReturnType ExecChildren(int32 Node, Args... args) {
+        for (int32 Child : Ast->GetChildren(Node)) {
+            Exec(Child, args...);
+        }
+        return ReturnType();
+    }
+
+    // Generate Fallback functions
+    // ---------------------------
+    //
+    // clang-format off
+    #define NODE(Kind)\
+    ReturnType Kind(int32 Node, Args... args) {\
+        return ExecChildren(Node, args...);\
+    }
+
+    GKAST_KINDS(NODE)
+    #undef NODE
+    // clang-format on
+
+    FGKScriptAst const* Ast = nullptr;
+};
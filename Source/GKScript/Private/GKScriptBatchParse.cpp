@@ -0,0 +1,78 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKScriptBatchParse.h"
+
+// Gamekit
+#include "GKScript.h"
+#include "GKPythonInterpreter.h"
+#include "GKScriptAstCache.h"
+#include "GKScriptStats.h"
+
+// Unreal Engine
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+
+// Last, Python-ast.h defines macros named after the AST nodes
+#include "GKPythonLowering.h"
+
+
+void FGKScriptBatchParser::ParseFiles(TArrayView<const FString> Files, TArray<FGKScriptParseResult>& Results, EGKScriptParser Parser) {
+    GKSCRIPT_SCOPE(STAT_GKScript_BatchParse);
+    Results.Reset();
+    Results.SetNum(Files.Num());
+
+    TArray<FString> Sources;
+    Sources.SetNum(Files.Num());
+
+    // Reading is parallel for both backends
+    ParallelFor(Files.Num(), [&](int32 i) {
+        Results[i].Path = Files[i];
+
+        if (!FFileHelper::LoadFileToString(Sources[i], *Files[i])) {
+            Results[i].Error.Message = TEXT("Could not read the file");
+        }
+    });
+
+    if (Parser == EGKScriptParser::CPython) {
+        FGKPythonInterpreter::Get().Initialize();
+
+        // Arenas are reused between the files and freed once they are all parsed
+        FGKPyArenaBatch ArenaBatch;
+
+        for (int32 i = 0; i < Files.Num(); i++) {
+            FGKScriptParseResult& Result = Results[i];
+            if (!Result.Error.Message.IsEmpty()) {
+                continue;
+            }
+
+            Result.bParsed = FGKPythonLowering::Parse(TCHAR_TO_UTF8(*Sources[i]), Result.Ast, Result.Error);
+        }
+        return;
+    }
+
+    FGKScriptAstCache& Cache = FGKScriptAstCache::Get();
+    Cache.Trim();
+
+    ParallelFor(Files.Num(), [&](int32 i) {
+        FGKScriptParseResult& Result = Results[i];
+        if (!Result.Error.Message.IsEmpty()) {
+            return;
+        }
+
+        Result.bParsed = Cache.GetOrParse(Sources[i], Result.Ast, Result.Error, &Result.bCacheHit);
+
+        // Release the source as soon as possible on large imports
+        Sources[i].Empty();
+    });
+}
+
+EGKScriptParser FGKScriptBatchParser::ParseParserName(FString const& Name) {
+    if (Name.Equals(TEXT("CPython"))) {
+        return EGKScriptParser::CPython;
+    }
+    if (!Name.IsEmpty() && !Name.Equals(TEXT("Native"))) {
+        GKSCRIPT_WARNING(TEXT("Unknown parser %s, using the native parser"), *Name);
+    }
+    return EGKScriptParser::Native;
+}
@@ -0,0 +1,40 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Gamekit
+#include "GKScriptAst.h"
+#include "GKScriptParser.h"
+
+// Unreal Engine
+#include "CoreMinimal.h"
+
+
+enum class EGKScriptParser : uint8 {
+    Native,     // FGKScriptParser, parallel, cached
+    CPython,    // FGKPythonLowering, serialized by the GIL
+};
+
+struct FGKScriptParseResult {
+    FString             Path;
+    FGKScriptAst        Ast;
+    FGKScriptParseError Error;
+    bool                bParsed = false;
+    bool                bCacheHit = false;
+};
+
+
+/*! Parse stage of the bulk import
+ *
+ * Scripts are read and parsed on every core, each result only depends on its script.
+ * The native backend goes through FGKScriptAstCache, unchanged scripts are not parsed.
+ *
+ * The CPython backend is kept to validate the native parser, the engine python shares
+ * one GIL between every thread so it runs one script at a time.
+ */
+struct FGKScriptBatchParser {
+    static void ParseFiles(TArrayView<const FString> Files, TArray<FGKScriptParseResult>& Results,
+                           EGKScriptParser Parser = EGKScriptParser::Native);
+
+    static EGKScriptParser ParseParserName(FString const& Name);
+};
@@ -0,0 +1,935 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKScriptBytecode.h"
+
+// Gamekit
+#include "GKScript.h"
+#include "GKEdGraphTypes.h"
+#include "GKPythonTransform.h"
+#include "GKReflectionIndex.h"
+#include "GKScriptAstCache.h"
+#include "GKScriptStats.h"
+
+// Unreal Engine
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Editor.h"
+#include "EdGraphSchema_K2.h"
+#include "Engine/Blueprint.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "GameFramework/Actor.h"
+#include "Kismet2/BlueprintEditorUtils.h"
+#include "Kismet2/CompilerResultsLog.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "KismetCompilerMisc.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "ScopedTransaction.h"
+#include "Subsystems/AssetEditorSubsystem.h"
+#include "UObject/MetaData.h"
+#include "UObject/Script.h"
+#include "UObject/TextProperty.h"
+
+#define LOCTEXT_NAMESPACE "FGKScriptModule"
+
+
+// Script the Blueprint was compiled from, relative to the project directory
+static const FName GKScriptSourceKey = TEXT("GKScriptSource");
+
+// Code that cannot be compiled, the whole class is rejected
+#define GKBYTECODE_ERROR(Node, Format, ...)                                                         \
+    {                                                                                               \
+        bFailed = true;                                                                             \
+        GKSCRIPT_ERROR(TEXT("%s:%d: ") Format, *SourcePath, Ast->Get(Node).Line, ##__VA_ARGS__);    \
+    }
+
+namespace {
+
+// Same conversions as the pins, objects can be passed where a base class is expected
+bool IsAssignable(FProperty* Value, FProperty* Dest) {
+    if (Dest->SameType(Value)) {
+        return true;
+    }
+
+    FObjectProperty* From = CastField<FObjectProperty>(Value);
+    FObjectProperty* To = CastField<FObjectProperty>(Dest);
+    return From && To && From->GetClass() == To->GetClass() && From->PropertyClass->IsChildOf(To->PropertyClass);
+}
+
+// Literal kind of a C++ default value, as stored in the CPP_Default_ metadata
+bool GetDefaultKind(FProperty* Param, FString const& Literal, EGKAstConstant& Kind) {
+    if (CastField<FBoolProperty>(Param)) {
+        Kind = Literal.ToBool() ? EGKAstConstant::True : EGKAstConstant::False;
+    } else if (CastField<FFloatProperty>(Param) || CastField<FDoubleProperty>(Param)) {
+        Kind = EGKAstConstant::Real;
+    } else if (CastField<FNumericProperty>(Param)) {
+        Kind = EGKAstConstant::Int;
+    } else if (CastField<FStrProperty>(Param) || CastField<FNameProperty>(Param) || CastField<FTextProperty>(Param)) {
+        Kind = EGKAstConstant::String;
+    } else if (CastField<FObjectPropertyBase>(Param) && (Literal.IsEmpty() || Literal == TEXT("None"))) {
+        Kind = EGKAstConstant::None;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
+FGKScriptBytecodeCompiler::FGKScriptBytecodeCompiler(FString OutputPath, FString SourcePath):
+    OutputPath(OutputPath), SourcePath(SourcePath)
+{}
+
+int FGKScriptBytecodeCompiler::Compile(FGKScriptAst const& Script) {
+    Ast = &Script;
+    int Result = Exec(Script.Root);
+    Ast = nullptr;
+    return Result;
+}
+
+int FGKScriptBytecodeCompiler::IgnoreStatement(int32 Node) {
+    // Class bodies only hold functions for now
+    GKSCRIPT_WARNING(TEXT("%s:%d: statements outside of a function are ignored"), *SourcePath, Ast->Get(Node).Line);
+    return 0;
+}
+
+bool FGKScriptBytecodeCompiler::IsSelf(int32 Node) const {
+    FGKAstNode const& Expr = Ast->Get(Node);
+    return Expr.Kind == EGKAstKind::Name && Ast->GetValue(Node).Equals(TEXT("self"), ESearchCase::CaseSensitive);
+}
+
+void FGKScriptBytecodeCompiler::EmitLet(FProperty* Property, EExprToken Access) {
+    // Bools can be bitfields, they are not written as a whole value
+    if (CastField<FBoolProperty>(Property)) {
+        Write(EX_LetBool);
+    } else {
+        Write(EX_Let);
+        WritePointer(Property);
+    }
+    Write(Access);
+    WritePointer(Property);
+}
+
+bool FGKScriptBytecodeCompiler::EmitValue(int32 Node, FProperty* Dest) {
+    FGKAstNode const& Expr = Ast->Get(Node);
+
+    switch (Expr.Kind) {
+    case EGKAstKind::Constant:
+        return EmitLiteral(Node, Dest, EGKAstConstant(Expr.Op), FString(Ast->GetValue(Node)));
+
+    case EGKAstKind::Name:
+    case EGKAstKind::Attribute:
+    case EGKAstKind::Call: {
+        if (IsSelf(Node)) {
+            FObjectProperty* Object = CastField<FObjectProperty>(Dest);
+            if (Object == nullptr || !Class->IsChildOf(Object->PropertyClass)) {
+                GKBYTECODE_ERROR(Node, TEXT("self cannot be converted to %s"), *Dest->GetCPPType());
+                return false;
+            }
+            Write(EX_Self);
+            return true;
+        }
+
+        FProperty* Value = EmitExpr(Node);
+        if (Value == nullptr) {
+            return false;
+        }
+        if (!IsAssignable(Value, Dest)) {
+            GKBYTECODE_ERROR(Node, TEXT("%s cannot be converted to %s"), *Value->GetCPPType(), *Dest->GetCPPType());
+            return false;
+        }
+        return true;
+    }
+    default:
+        break;
+    }
+
+    GKBYTECODE_ERROR(Node, TEXT("%s expressions cannot be compiled to bytecode"), ::ToString(Expr.Kind));
+    return false;
+}
+
+FProperty* FGKScriptBytecodeCompiler::EmitExpr(int32 Node) {
+    FGKAstNode const& Expr = Ast->Get(Node);
+
+    switch (Expr.Kind) {
+    case EGKAstKind::Name:
+    case EGKAstKind::Attribute:
+        return EmitVariable(Node);
+
+    case EGKAstKind::Call: {
+        UFunction* Callee = EmitCall(Node);
+        if (Callee == nullptr) {
+            return nullptr;
+        }
+
+        FProperty* Result = Callee->GetReturnProperty();
+        if (Result == nullptr) {
+            GKBYTECODE_ERROR(Node, TEXT("%s does not return a value"), *Callee->GetName());
+        }
+        return Result;
+    }
+    default:
+        break;
+    }
+
+    GKBYTECODE_ERROR(Node, TEXT("%s expressions cannot be compiled to bytecode"), ::ToString(Expr.Kind));
+    return nullptr;
+}
+
+FProperty* FGKScriptBytecodeCompiler::EmitVariable(int32 Node) {
+    // self.Name and Name are the same member, members of other objects are not supported
+    FGKAstNode const& Expr = Ast->Get(Node);
+    if (Expr.Kind == EGKAstKind::Attribute && !IsSelf(Ast->GetChild(Node, 0))) {
+        GKBYTECODE_ERROR(Node, TEXT("only the members of self can be read"));
+        return nullptr;
+    }
+
+    FName Name = FName(Ast->GetValue(Node));
+
+    // Arguments shadow the members
+    FProperty* Arg = FindFProperty<FProperty>(CurrentFunction, Name);
+    if (Arg != nullptr && Arg->HasAnyPropertyFlags(CPF_Parm) && !Arg->HasAnyPropertyFlags(CPF_ReturnParm)) {
+        Write(EX_LocalVariable);
+        WritePointer(Arg);
+        return Arg;
+    }
+
+    FProperty* Member = FindFProperty<FProperty>(Class, Name);
+    if (Member == nullptr || !Member->HasAnyPropertyFlags(CPF_BlueprintVisible)) {
+        GKBYTECODE_ERROR(Node, TEXT("unknown variable %s"), *Name.ToString());
+        return nullptr;
+    }
+
+    Write(EX_InstanceVariable);
+    WritePointer(Member);
+    return Member;
+}
+
+bool FGKScriptBytecodeCompiler::EmitCondition(int32 Node) {
+    FGKAstNode const& Expr = Ast->Get(Node);
+
+    if (Expr.Kind == EGKAstKind::Constant) {
+        EGKAstConstant Kind = EGKAstConstant(Expr.Op);
+        if (Kind == EGKAstConstant::True || Kind == EGKAstConstant::False) {
+            Write(Kind == EGKAstConstant::True ? EX_True : EX_False);
+            return true;
+        }
+    }
+
+    FProperty* Value = EmitExpr(Node);
+    if (Value != nullptr && CastField<FBoolProperty>(Value) == nullptr) {
+        GKBYTECODE_ERROR(Node, TEXT("conditions must be bool, not %s"), *Value->GetCPPType());
+        return false;
+    }
+    return Value != nullptr;
+}
+
+bool FGKScriptBytecodeCompiler::EmitLiteral(int32 Node, FProperty* Dest, EGKAstConstant Kind, FString const& Literal) {
+    switch (Kind) {
+    case EGKAstConstant::None:
+        if (CastField<FObjectPropertyBase>(Dest)) {
+            Write(EX_NoObject);
+            return true;
+        }
+        break;
+
+    case EGKAstConstant::True:
+    case EGKAstConstant::False:
+        if (CastField<FBoolProperty>(Dest)) {
+            Write(Kind == EGKAstConstant::True ? EX_True : EX_False);
+            return true;
+        }
+        break;
+
+    case EGKAstConstant::Int:
+    case EGKAstConstant::Real: {
+        if (CastField<FFloatProperty>(Dest)) {
+            Write(EX_FloatConst);
+            Write<float>(FCString::Atof(*Literal));
+            return true;
+        }
+        if (CastField<FDoubleProperty>(Dest)) {
+            Write(EX_DoubleConst);
+            Write<double>(FCString::Atod(*Literal));
+            return true;
+        }
+
+        // Reals are never truncated
+        int64 Value = 0;
+        if (Kind == EGKAstConstant::Real || !LexTryParseString(Value, *Literal)) {
+            break;
+        }
+
+        if (CastField<FIntProperty>(Dest)) {
+            Write(EX_IntConst);
+            Write<int32>(int32(Value));
+            return true;
+        }
+        if (CastField<FInt64Property>(Dest)) {
+            Write(EX_Int64Const);
+            Write<int64>(Value);
+            return true;
+        }
+        if (CastField<FByteProperty>(Dest)) {
+            Write(EX_ByteConst);
+            Write<uint8>(uint8(Value));
+            return true;
+        }
+        break;
+    }
+
+    case EGKAstConstant::String: {
+        if (CastField<FNameProperty>(Dest)) {
+            Write(EX_NameConst);
+            Write<FScriptName>(NameToScriptName(FName(*Literal)));
+            return true;
+        }
+
+        bool bText = CastField<FTextProperty>(Dest) != nullptr;
+        if (!bText && CastField<FStrProperty>(Dest) == nullptr) {
+            break;
+        }
+
+        // Text literals are not localized, like the defaults of a pin
+        if (bText) {
+            Write(EX_TextConst);
+            Write<uint8>(uint8(EBlueprintTextLiteralType::LiteralString));
+        }
+
+        if (FCString::IsPureAnsi(*Literal)) {
+            Write(EX_StringConst);
+            for (TCHAR Char : Literal) {
+                Write<ANSICHAR>(ANSICHAR(Char));
+            }
+            Write<ANSICHAR>('\0');
+        } else {
+            Write(EX_UnicodeStringConst);
+            FTCHARToUTF16 Chars(*Literal);
+            for (int32 i = 0; i < Chars.Length(); i++) {
+                Write<UTF16CHAR>(Chars.Get()[i]);
+            }
+            Write<UTF16CHAR>(0);
+        }
+        return true;
+    }
+    }
+
+    GKBYTECODE_ERROR(Node, TEXT("%s cannot be converted to %s"), *Literal, *Dest->GetCPPType());
+    return false;
+}
+
+UFunction* FGKScriptBytecodeCompiler::EmitCall(int32 Node) {
+    // f(), self.f(), Library.f() or Object.f(), resolved like FGKPythonTransform::LowerCall
+    int32 Func = Ast->GetChild(Node, 0);
+    EGKAstKind FuncKind = Ast->Get(Func).Kind;
+    if (FuncKind != EGKAstKind::Name && FuncKind != EGKAstKind::Attribute) {
+        GKBYTECODE_ERROR(Node, TEXT("only named functions can be called"));
+        return nullptr;
+    }
+
+    FStringView FunctionName = Ast->GetValue(Func);
+    UFunction* Callee = nullptr;
+
+    // Skip size of the EX_Context, when the function is not called on self
+    int32 Skip = INDEX_NONE;
+
+    int32 Receiver = FuncKind == EGKAstKind::Attribute ? Ast->GetChild(Func, 0) : INDEX_NONE;
+
+    if (Receiver == INDEX_NONE || IsSelf(Receiver)) {
+        // Members first, then every Blueprint callable function
+        Callee = FGKReflectionIndex::Get().FindFunction(FunctionName, Class);
+    } else if (UClass* Library = Ast->Get(Receiver).Kind == EGKAstKind::Name ? FGKReflectionIndex::Get().FindClass(Ast->GetValue(Receiver)) : nullptr) {
+        // Library.f(), static functions of a class
+        Callee = Library->FindFunctionByName(FName(FunctionName));
+    } else {
+        // Object.f(), the call is evaluated in the context of the object
+        Write(EX_Context);
+
+        FProperty* Value = EmitExpr(Receiver);
+        if (Value == nullptr) {
+            return nullptr;
+        }
+
+        FObjectProperty* Object = CastField<FObjectProperty>(Value);
+        if (Object == nullptr) {
+            GKBYTECODE_ERROR(Node, TEXT("%s is called on a value that is not an object"), *FString(FunctionName));
+            return nullptr;
+        }
+
+        Callee = Object->PropertyClass->FindFunctionByName(FName(FunctionName));
+        Skip = WriteSkip();
+        WritePointer(Callee ? Callee->GetReturnProperty() : nullptr);
+    }
+
+    if (Callee == nullptr) {
+        GKBYTECODE_ERROR(Node, TEXT("unknown function %s"), *FString(FunctionName));
+        return nullptr;
+    }
+
+    bool bStatic = Callee->HasAnyFunctionFlags(FUNC_Static);
+
+    if (!Callee->HasAnyFunctionFlags(FUNC_BlueprintCallable | FUNC_BlueprintPure) ||
+        Callee->GetOwnerClass()->IsChildOf(UInterface::StaticClass()) ||
+        Callee->HasMetaData(FBlueprintMetadata::MD_Latent)) {
+        GKBYTECODE_ERROR(Node, TEXT("%s cannot be called from bytecode, use the graph backend"), *Callee->GetName());
+        return nullptr;
+    }
+
+    if (Skip == INDEX_NONE && !bStatic && !Class->IsChildOf(Callee->GetOwnerClass())) {
+        GKBYTECODE_ERROR(Node, TEXT("%s is not a member of %s"), *Callee->GetName(), *Class->GetSuperClass()->GetName());
+        return nullptr;
+    }
+
+    // Static functions run on the default object of their class, as the Kismet compiler calls them
+    if (Skip == INDEX_NONE && bStatic) {
+        Write(EX_Context);
+        Write(EX_ObjectConst);
+        WritePointer(Callee->GetOwnerClass()->GetDefaultObject());
+        Skip = WriteSkip();
+        WritePointer(Callee->GetReturnProperty());
+    }
+
+    int32 Start = CurrentFunction->Script.Num();
+
+    if (bStatic || Callee->HasAnyFunctionFlags(FUNC_Final)) {
+        Write(EX_FinalFunction);
+        WritePointer(Callee);
+    } else {
+        Write(EX_VirtualFunction);
+        Write<FScriptName>(NameToScriptName(Callee->GetFName()));
+    }
+
+    // Keywords by name, then the positional arguments in the order of the parameters
+    TArray<int32, TInlineAllocator<8>> Positionals;
+    TMap<FName, int32, TInlineSetAllocator<8>> Keywords;
+
+    TArrayView<const int32> Args = Ast->GetChildren(Node);
+    for (int32 i = 1; i < Args.Num(); i++) {
+        if (Ast->Get(Args[i]).Kind == EGKAstKind::Keyword) {
+            Keywords.Add(FName(Ast->GetValue(Args[i])), Ast->GetChild(Args[i], 0));
+        } else {
+            Positionals.Add(Args[i]);
+        }
+    }
+
+    // The world context pin is hidden and set to self
+    FString const& WorldContext = Callee->GetMetaData(FBlueprintMetadata::MD_WorldContext);
+    int32 Positional = 0;
+
+    for (TFieldIterator<FProperty> It(Callee); It && It->HasAnyPropertyFlags(CPF_Parm); ++It) {
+        FProperty* Param = *It;
+
+        if (Param->HasAnyPropertyFlags(CPF_ReturnParm)) {
+            continue;
+        }
+
+        if (Param->HasAnyPropertyFlags(CPF_OutParm) && !Param->HasAnyPropertyFlags(CPF_ConstParm)) {
+            GKBYTECODE_ERROR(Node, TEXT("%s has output parameters, use the graph backend"), *Callee->GetName());
+            return nullptr;
+        }
+
+        if (!WorldContext.IsEmpty() && Param->GetName() == WorldContext) {
+            Write(EX_Self);
+            continue;
+        }
+
+        int32 Value = INDEX_NONE;
+        if (int32* Keyword = Keywords.Find(Param->GetFName())) {
+            Value = *Keyword;
+            Keywords.Remove(Param->GetFName());
+        } else if (Positionals.IsValidIndex(Positional)) {
+            Value = Positionals[Positional++];
+        }
+
+        if (Value != INDEX_NONE) {
+            if (!EmitValue(Value, Param)) {
+                return nullptr;
+            }
+            continue;
+        }
+
+        // Missing arguments take the default of the C++ declaration
+        FName DefaultKey = FName(FString::Printf(TEXT("CPP_Default_%s"), *Param->GetName()));
+        EGKAstConstant Kind;
+
+        if (!Callee->HasMetaData(DefaultKey) || !GetDefaultKind(Param, Callee->GetMetaData(DefaultKey), Kind)) {
+            GKBYTECODE_ERROR(Node, TEXT("missing argument %s for %s"), *Param->GetName(), *Callee->GetName());
+            return nullptr;
+        }
+        if (!EmitLiteral(Node, Param, Kind, Callee->GetMetaData(DefaultKey))) {
+            return nullptr;
+        }
+    }
+
+    if (Positional < Positionals.Num()) {
+        GKBYTECODE_ERROR(Node, TEXT("too many arguments for %s"), *Callee->GetName());
+        return nullptr;
+    }
+    if (Keywords.Num() > 0) {
+        GKBYTECODE_ERROR(Node, TEXT("%s has no parameter %s"), *Callee->GetName(), *Keywords.CreateConstIterator().Key().ToString());
+        return nullptr;
+    }
+
+    Write(EX_EndFunctionParms);
+
+    if (Skip != INDEX_NONE) {
+        PatchSkip(Skip, CodeSkipSizeType(CurrentFunction->Script.Num() - Start));
+    }
+    return Callee;
+}
+
+int FGKScriptBytecodeCompiler::ClassDef(int32 Node) {
+    GKSCRIPT_SCOPE(STAT_GKScript_BuildBytecode);
+    // Nested classes are not supported
+    ensure(Destination == nullptr);
+
+    // Resolve BaseClass
+    TArrayView<const int32> Bases = Ast->GetChildren(Ast->GetChild(Node, 0));
+    if (!ensure(Bases.Num() == 1) || !ensure(Ast->Get(Bases[0]).Kind == EGKAstKind::Name)) {
+        return 0;
+    }
+    UClass* BaseClassType = FGKReflectionIndex::Get().FindClass(Ast->GetValue(Bases[0]));
+    if (BaseClassType == nullptr) {
+        GKSCRIPT_ERROR(TEXT("Line %d: unknown base class %s"), Ast->Get(Node).Line, *FString(Ast->GetValue(Bases[0])));
+        return 0;
+    }
+
+    FString ClassName = FString(Ast->GetValue(Node));
+    const FString PackageName = FPaths::GetPath(OutputPath) / ClassName;
+
+    // Existing Blueprints have graphs, they are patched by FGKPythonTransform
+    if (FindPackage(nullptr, *PackageName) || FPackageName::DoesPackageExist(PackageName)) {
+        GKSCRIPT_WARNING(TEXT("%s already exists, use the graph backend to update it"), *PackageName);
+        return 0;
+    }
+
+    UPackage* Package = CreatePackage(*PackageName);
+
+    Destination = NewObject<UBlueprint>(Package, FName(ClassName), RF_Public | RF_Standalone);
+    Destination->ParentClass = BaseClassType;
+    Destination->BlueprintType = EBlueprintType::BPTYPE_Normal;
+
+    // Without graphs a recompile would empty the class
+    Destination->bRecompileOnLoad = false;
+
+    // The project can be checked out anywhere else
+    FString RelativePath = FPaths::ConvertRelativePathToFull(SourcePath);
+    FPaths::MakePathRelativeTo(RelativePath, *FPaths::ConvertRelativePathToFull(FPaths::ProjectDir()));
+    Package->GetMetaData()->SetValue(Destination, GKScriptSourceKey, *RelativePath);
+
+    // Same setup as the Kismet compiler, minus the skeleton class
+    Class = NewObject<UBlueprintGeneratedClass>(Package, FName(ClassName + TEXT("_C")), RF_Public);
+    Class->ClassGeneratedBy = Destination;
+    Class->SetSuperStruct(BaseClassType);
+    Class->ClassFlags |= (BaseClassType->ClassFlags & CLASS_Inherit) | CLASS_CompiledFromBlueprint;
+    Class->ClassCastFlags |= BaseClassType->ClassCastFlags;
+    Class->ClassWithin = BaseClassType->ClassWithin;
+    Class->ClassConfigName = BaseClassType->ClassConfigName;
+
+    bFailed = false;
+
+    // Signatures first, bodies can call the functions defined after them
+    int32 Body = Ast->GetChild(Node, 2);
+    auto result = Exec(Body);
+
+    for (int32 Stmt : Ast->GetChildren(Body)) {
+        if (Ast->Get(Stmt).Kind == EGKAstKind::FunctionDef) {
+            CompileBody(Stmt);
+        }
+    }
+
+    // Code that does not compile is not replaced by code that does nothing, the package is never saved
+    if (bFailed) {
+        GKSCRIPT_ERROR(TEXT("%s could not be compiled to bytecode, use the graph backend"), *PackageName);
+        NumErrors += 1;
+
+        Destination->ClearFlags(RF_Public | RF_Standalone);
+        Destination->MarkAsGarbage();
+        Class->MarkAsGarbage();
+        Package->MarkAsGarbage();
+
+        Destination = nullptr;
+        Class = nullptr;
+        return 0;
+    }
+
+    Class->Bind();
+    Class->StaticLink(true);
+    Class->AssembleReferenceTokenStream(true);
+    Class->GetDefaultObject();
+
+    Destination->GeneratedClass = Class;
+    Blueprints.Add(Destination);
+
+    FAssetRegistryModule::AssetCreated(Destination);
+    Package->MarkPackageDirty();
+
+    // Scripts imported later can derive from it
+    FGKReflectionIndex::Get().AddBlueprint(Destination);
+
+    Destination = nullptr;
+    Class = nullptr;
+    return result;
+}
+
+int FGKScriptBytecodeCompiler::FunctionDef(int32 Node) {
+    ensure(Class != nullptr);
+
+    FName FunctionName = FName(Ast->GetValue(Node));
+
+    UFunction* Function = NewObject<UFunction>(Class, FunctionName, RF_Public);
+    Function->FunctionFlags |= FUNC_Public | FUNC_BlueprintCallable | FUNC_BlueprintEvent;
+
+    UEdGraphSchema_K2 const* Schema = GetDefault<UEdGraphSchema_K2>();
+    FCompilerResultsLog MessageLog;
+
+    // LinkAddedProperty prepends, the return value is added first so it is the last parameter,
+    // calls end their arguments before it
+    int32 Returns = Ast->GetChild(Node, 2);
+    bool bReturnsNone = Returns != INDEX_NONE &&
+        Ast->Get(Returns).Kind == EGKAstKind::Constant && EGKAstConstant(Ast->Get(Returns).Op) == EGKAstConstant::None;
+
+    if (Returns != INDEX_NONE && !bReturnsNone) {
+        FEdGraphPinType PinType;
+        FProperty* Result = nullptr;
+
+        if (FGKPinTypeResolver::Get().Resolve(*Ast, Returns, PinType)) {
+            Result = FKismetCompilerUtilities::CreatePropertyOnScope(
+                Function, UEdGraphSchema_K2::PN_ReturnValue, PinType, Class, CPF_None, Schema, MessageLog
+            );
+        }
+
+        if (Result == nullptr) {
+            GKBYTECODE_ERROR(Node, TEXT("could not resolve the return type of %s"), *FunctionName.ToString());
+        } else {
+            Result->SetPropertyFlags(CPF_Parm | CPF_OutParm | CPF_ReturnParm);
+            FKismetCompilerUtilities::LinkAddedProperty(Function, Result);
+            Function->FunctionFlags |= FUNC_HasOutParms;
+        }
+    }
+
+    // Arguments are parameters, added last to first
+    TArrayView<const int32> Args = Ast->GetChildren(Ast->GetChild(Node, 1));
+
+    for (int32 i = Args.Num() - 1; i >= 0; i--) {
+        int32 Arg = Args[i];
+
+        FName PinName = FName(Ast->GetValue(Arg));
+        if (PinName == TEXT("self")) {
+            continue;
+        }
+
+        // Parameters cannot be wildcards, unlike pins
+        FEdGraphPinType PinType;
+        if (!FGKPinTypeResolver::Get().Resolve(*Ast, Ast->GetChild(Arg, 0), PinType)) {
+            GKBYTECODE_ERROR(Arg, TEXT("could not resolve the type of %s"), *PinName.ToString());
+            continue;
+        }
+
+        FProperty* Param = FKismetCompilerUtilities::CreatePropertyOnScope(
+            Function, PinName, PinType, Class, CPF_None, Schema, MessageLog
+        );
+        if (Param == nullptr) {
+            GKBYTECODE_ERROR(Arg, TEXT("could not create parameter %s"), *PinName.ToString());
+            continue;
+        }
+
+        Param->SetPropertyFlags(CPF_Parm | CPF_BlueprintVisible | CPF_BlueprintReadOnly);
+        FKismetCompilerUtilities::LinkAddedProperty(Function, Param);
+    }
+
+    Function->Next = Class->Children;
+    Class->Children = Function;
+    Class->AddFunctionToFunctionMap(Function, FunctionName);
+    return 1;
+}
+
+void FGKScriptBytecodeCompiler::CompileBody(int32 Node) {
+    CurrentFunction = Class->FindFunctionByName(FName(Ast->GetValue(Node)), EIncludeSuperFlag::ExcludeSuper);
+    NumTemporaries = 0;
+
+    if (!ensure(CurrentFunction != nullptr)) {
+        return;
+    }
+
+    Exec(Ast->GetChild(Node, 3));
+
+    // Bodies without a return fall off the end
+    Write(EX_Return);
+    Write(EX_Nothing);
+    Write(EX_EndOfScript);
+
+    // Temporaries were added by the body, the frame size is known now
+    CurrentFunction->Bind();
+    CurrentFunction->StaticLink(true);
+    CurrentFunction = nullptr;
+}
+
+int FGKScriptBytecodeCompiler::Block(int32 Node) {
+    // Class bodies, the functions are compiled by ClassDef
+    if (CurrentFunction == nullptr) {
+        return ExecChildren(Node);
+    }
+
+    for (int32 Stmt : Ast->GetChildren(Node)) {
+        switch (Ast->Get(Stmt).Kind) {
+        case EGKAstKind::ExprStmt:
+        case EGKAstKind::Return:
+        case EGKAstKind::Assign:
+        case EGKAstKind::If:
+        case EGKAstKind::Pass:
+            Exec(Stmt);
+            break;
+        default:
+            GKBYTECODE_ERROR(Stmt, TEXT("%s statements cannot be compiled to bytecode"), ::ToString(Ast->Get(Stmt).Kind));
+            break;
+        }
+    }
+    return 1;
+}
+
+int FGKScriptBytecodeCompiler::ExprStmt(int32 Node) {
+    int32 Value = Ast->GetChild(Node, 0);
+    FGKAstNode const& Expr = Ast->Get(Value);
+
+    // Docstrings
+    if (Expr.Kind == EGKAstKind::Constant) {
+        return 1;
+    }
+    if (CurrentFunction == nullptr) {
+        return IgnoreStatement(Node);
+    }
+    if (Expr.Kind != EGKAstKind::Call) {
+        GKBYTECODE_ERROR(Node, TEXT("%s expressions cannot be compiled to bytecode"), ::ToString(Expr.Kind));
+        return 0;
+    }
+
+    int32 Start = CurrentFunction->Script.Num();
+    UFunction* Callee = EmitCall(Value);
+    if (Callee == nullptr || Callee->GetReturnProperty() == nullptr) {
+        return Callee != nullptr;
+    }
+
+    // The result goes to a local like the Kismet compiler does,
+    // the statement buffer of the VM is too small for large structs and never destroys its value
+    FEdGraphPinType PinType;
+    GetDefault<UEdGraphSchema_K2>()->ConvertPropertyToPinType(Callee->GetReturnProperty(), PinType);
+
+    FCompilerResultsLog MessageLog;
+    FProperty* Temporary = FKismetCompilerUtilities::CreatePropertyOnScope(
+        CurrentFunction,
+        FName(FString::Printf(TEXT("CallResult_%d"), NumTemporaries++)),
+        PinType,
+        Class,
+        CPF_None,
+        GetDefault<UEdGraphSchema_K2>(),
+        MessageLog
+    );
+    if (Temporary == nullptr) {
+        GKBYTECODE_ERROR(Node, TEXT("could not store the result of %s"), *Callee->GetName());
+        return 0;
+    }
+
+    // Locals follow the parameters, calls bind their arguments in order
+    FField** Tail = &CurrentFunction->ChildProperties;
+    while (*Tail != nullptr) {
+        Tail = &(*Tail)->Next;
+    }
+    *Tail = Temporary;
+
+    // The temporary is only known once the function is resolved, the assignment goes before the call
+    TArray<uint8> Call(CurrentFunction->Script.GetData() + Start, CurrentFunction->Script.Num() - Start);
+    CurrentFunction->Script.SetNum(Start);
+    EmitLet(Temporary, EX_LocalVariable);
+    CurrentFunction->Script.Append(Call);
+    return 1;
+}
+
+int FGKScriptBytecodeCompiler::Return(int32 Node) {
+    if (CurrentFunction == nullptr) {
+        return IgnoreStatement(Node);
+    }
+
+    // The VM stops at the first EX_Return it reaches and evaluates the value into the result
+    Write(EX_Return);
+
+    int32 Value = Ast->GetChild(Node, 0);
+    if (Value == INDEX_NONE) {
+        Write(EX_Nothing);
+        return 1;
+    }
+
+    FProperty* Result = CurrentFunction->GetReturnProperty();
+    if (Result == nullptr) {
+        GKBYTECODE_ERROR(Node, TEXT("%s returns a value but has no return type"), *CurrentFunction->GetName());
+        return 0;
+    }
+    return EmitValue(Value, Result);
+}
+
+int FGKScriptBytecodeCompiler::Assign(int32 Node) {
+    if (CurrentFunction == nullptr) {
+        return IgnoreStatement(Node);
+    }
+
+    TArrayView<const int32> Kids = Ast->GetChildren(Node);
+    int32 Value = Kids.Last();
+
+    // a = b = c sets every target to c
+    for (int32 Target : Kids.LeftChop(1)) {
+        FGKAstNode const& Expr = Ast->Get(Target);
+
+        if (Expr.Kind != EGKAstKind::Name && !(Expr.Kind == EGKAstKind::Attribute && IsSelf(Ast->GetChild(Target, 0)))) {
+            GKBYTECODE_ERROR(Target, TEXT("only member variables can be assigned"));
+            continue;
+        }
+
+        FName Name = FName(Ast->GetValue(Target));
+        FProperty* Arg = FindFProperty<FProperty>(CurrentFunction, Name);
+        if (Arg != nullptr && Arg->HasAnyPropertyFlags(CPF_Parm)) {
+            GKBYTECODE_ERROR(Target, TEXT("arguments cannot be assigned"));
+            continue;
+        }
+
+        FProperty* Member = FindFProperty<FProperty>(Class, Name);
+        if (Member == nullptr || !Member->HasAnyPropertyFlags(CPF_BlueprintVisible) || Member->HasAnyPropertyFlags(CPF_BlueprintReadOnly)) {
+            GKBYTECODE_ERROR(Target, TEXT("%s is not a writable member"), *Name.ToString());
+            continue;
+        }
+
+        EmitLet(Member, EX_InstanceVariable);
+        EmitValue(Value, Member);
+    }
+    return 1;
+}
+
+int FGKScriptBytecodeCompiler::If(int32 Node) {
+    if (CurrentFunction == nullptr) {
+        return IgnoreStatement(Node);
+    }
+
+    // Jump targets are offsets from the start of the script
+    Write(EX_JumpIfNot);
+    int32 Else = WriteSkip();
+    EmitCondition(Ast->GetChild(Node, 0));
+
+    Exec(Ast->GetChild(Node, 1));
+
+    int32 OrElse = Ast->GetChild(Node, 2);
+    if (OrElse == INDEX_NONE || Ast->GetChildren(OrElse).Num() == 0) {
+        PatchSkip(Else, CodeSkipSizeType(CurrentFunction->Script.Num()));
+        return 1;
+    }
+
+    Write(EX_Jump);
+    int32 End = WriteSkip();
+
+    PatchSkip(Else, CodeSkipSizeType(CurrentFunction->Script.Num()));
+    Exec(OrElse);
+    PatchSkip(End, CodeSkipSizeType(CurrentFunction->Script.Num()));
+    return 1;
+}
+
+int FGKScriptBytecodeCompiler::Pass(int32 Node) {
+    return 1;
+}
+
+bool FGKScriptBytecodeCompiler::HasPendingGraphs(UBlueprint* Blueprint) {
+    return !Blueprint->bRecompileOnLoad &&
+        Blueprint->GetOutermost()->GetMetaData()->HasValue(Blueprint, GKScriptSourceKey);
+}
+
+bool FGKScriptBytecodeCompiler::SynthesizeGraphs(UBlueprint* Blueprint) {
+    FString Path = FPaths::ConvertRelativePathToFull(
+        FPaths::ProjectDir(), Blueprint->GetOutermost()->GetMetaData()->GetValue(Blueprint, GKScriptSourceKey)
+    );
+
+    FString Source;
+    if (!FFileHelper::LoadFileToString(Source, *Path)) {
+        GKSCRIPT_ERROR(TEXT("Could not read %s, the graphs of %s cannot be built"), *Path, *Blueprint->GetPathName());
+        return false;
+    }
+
+    FGKScriptAst Script;
+    FGKScriptParseError Error;
+    if (!FGKScriptAstCache::Get().GetOrParse(Source, Script, Error)) {
+        GKSCRIPT_ERROR(TEXT("%s:%s"), *Path, *Error.ToString());
+        return false;
+    }
+
+    // The editor is interactive, the synthesis can be undone like any edit
+    const FScopedTransaction Transaction(LOCTEXT("SynthesizeGraphs", "Build Blueprint Graphs"));
+    Blueprint->Modify();
+
+    // Default graphs, as FKismetEditorUtilities::CreateBlueprint makes them
+    if (Blueprint->UbergraphPages.Num() == 0) {
+        UEdGraph* EventGraph = FBlueprintEditorUtils::CreateNewGraph(
+            Blueprint, UEdGraphSchema_K2::GN_EventGraph, UEdGraph::StaticClass(), UEdGraphSchema_K2::StaticClass()
+        );
+        EventGraph->bAllowDeletion = false;
+        FBlueprintEditorUtils::AddUbergraphPage(Blueprint, EventGraph);
+        Blueprint->LastEditedDocuments.Add(EventGraph);
+    }
+
+    if (Blueprint->ParentClass->IsChildOf(AActor::StaticClass()) &&
+        FBlueprintEditorUtils::FindUserConstructionScript(Blueprint) == nullptr) {
+        UEdGraph* ConstructionScript = FBlueprintEditorUtils::CreateNewGraph(
+            Blueprint, UEdGraphSchema_K2::FN_UserConstructionScript, UEdGraph::StaticClass(), UEdGraphSchema_K2::StaticClass()
+        );
+        FBlueprintEditorUtils::AddFunctionGraph(Blueprint, ConstructionScript, false, AActor::StaticClass());
+        ConstructionScript->bAllowDeletion = false;
+    }
+
+    // Not a batch: graphs are transactional and go through AddFunctionGraph
+    FGKPythonTransform Transform(Blueprint->GetOutermost()->GetName());
+    Transform.Transform(Script);
+
+    // From now on the graphs are the source of the class
+    Blueprint->bRecompileOnLoad = true;
+    FKismetEditorUtilities::CompileBlueprint(Blueprint);
+    Blueprint->MarkPackageDirty();
+    return true;
+}
+
+
+static FDelegateHandle GKAssetEditorRequestedOpenHandle;
+static FDelegateHandle GKPostEngineInitHandle;
+
+static void OnAssetEditorRequestedOpen(UObject* Asset) {
+    UBlueprint* Blueprint = Cast<UBlueprint>(Asset);
+
+    if (Blueprint && FGKScriptBytecodeCompiler::HasPendingGraphs(Blueprint)) {
+        FGKScriptBytecodeCompiler::SynthesizeGraphs(Blueprint);
+    }
+}
+
+void RegisterLazyGraphSynthesis() {
+    // The asset editor subsystem does not exist yet when the module starts
+    GKPostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddLambda([]() {
+        if (GEditor == nullptr) {
+            return;
+        }
+
+        UAssetEditorSubsystem* AssetEditors = GEditor->GetEditorSubsystem<UAssetEditorSubsystem>();
+        GKAssetEditorRequestedOpenHandle = AssetEditors->OnAssetEditorRequestedOpen().AddStatic(&OnAssetEditorRequestedOpen);
+    });
+}
+
+void UnregisterLazyGraphSynthesis() {
+    FCoreDelegates::OnPostEngineInit.Remove(GKPostEngineInitHandle);
+    GKPostEngineInitHandle.Reset();
+
+    if (GEditor == nullptr || !GKAssetEditorRequestedOpenHandle.IsValid()) {
+        return;
+    }
+
+    if (UAssetEditorSubsystem* AssetEditors = GEditor->GetEditorSubsystem<UAssetEditorSubsystem>()) {
+        AssetEditors->OnAssetEditorRequestedOpen().Remove(GKAssetEditorRequestedOpenHandle);
+    }
+    GKAssetEditorRequestedOpenHandle.Reset();
+}
+
+#undef GKBYTECODE_ERROR
+#undef LOCTEXT_NAMESPACE
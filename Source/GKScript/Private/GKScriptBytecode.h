@@ -0,0 +1,128 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Gamekit
+#include "GKScriptAstVisitor.h"
+
+// Unreal Engine
+#include "UObject/Script.h"
+
+class UBlueprint;
+class UBlueprintGeneratedClass;
+class UFunction;
+
+
+/*! Lower a parsed script straight to a UBlueprintGeneratedClass
+ *
+ * The class, its functions and their parameters are created from the AST
+ * and the function bytecode is emitted directly, no graph is built and the Kismet compiler does not run.
+ * Bodies support what FGKPythonTransform lowers: calls, member assignments, ``if`` and ``return``.
+ * A class using anything else is rejected as a whole, it would silently behave differently.
+ * The Blueprint only records the script it comes from, its graphs are synthesized
+ * by FGKPythonTransform the first time it is opened in the editor.
+ *
+ * Used by ``-run=GKScriptImport -Backend=Bytecode`` for bulk imports and CI validation.
+ */
+class FGKScriptBytecodeCompiler : public FGKScriptAstVisitor<FGKScriptBytecodeCompiler, int>
+{
+    public:
+
+    FGKScriptBytecodeCompiler(FString OutputPath, FString SourcePath);
+
+    int Compile(FGKScriptAst const& Script);
+
+    int IgnoreStatement(int32 Node);
+
+    // Emit the body of a function created by FunctionDef
+    void CompileBody(int32 Node);
+
+    // Expressions
+    // -----------
+    // Value of an expression, converted to the type of Dest
+    bool EmitValue(int32 Node, FProperty* Dest);
+
+    // Value of a name, a member or a call, returns the property describing it
+    FProperty* EmitExpr(int32 Node);
+
+    FProperty* EmitVariable(int32 Node);
+
+    bool EmitCondition(int32 Node);
+
+    bool EmitLiteral(int32 Node, FProperty* Dest, EGKAstConstant Kind, FString const& Literal);
+
+    // Returns the called function, nullptr if the call could not be compiled
+    UFunction* EmitCall(int32 Node);
+
+    // Header of an assignment to Property, the value follows
+    void EmitLet(FProperty* Property, EExprToken Access);
+
+    bool IsSelf(int32 Node) const;
+
+    // Encoding
+    // --------
+    void Write(EExprToken Token) {
+        CurrentFunction->Script.Add(Token);
+    }
+
+    template <typename T>
+    void Write(T Value) {
+        int32 At = CurrentFunction->Script.AddUninitialized(sizeof(T));
+        FMemory::Memcpy(CurrentFunction->Script.GetData() + At, &Value, sizeof(T));
+    }
+
+    // Objects and properties are stored as raw pointers, like the Kismet compiler does
+    void WritePointer(const void* Pointer) {
+        Write<ScriptPointerType>(ScriptPointerType(UPTRINT(Pointer)));
+    }
+
+    // Placeholder for a jump target or a skip size, returns its offset
+    int32 WriteSkip() {
+        int32 At = CurrentFunction->Script.Num();
+        Write<CodeSkipSizeType>(0);
+        return At;
+    }
+
+    void PatchSkip(int32 At, CodeSkipSizeType Value) {
+        FMemory::Memcpy(CurrentFunction->Script.GetData() + At, &Value, sizeof(CodeSkipSizeType));
+    }
+
+    // Statement
+    int Block(int32 Node);
+    int ClassDef(int32 Node);
+    int FunctionDef(int32 Node);
+    int ExprStmt(int32 Node);
+    int Return(int32 Node);
+    int Assign(int32 Node);
+    int If(int32 Node);
+    int Pass(int32 Node);
+
+    // Blueprint produced by this backend, that was never opened in the editor
+    static bool HasPendingGraphs(UBlueprint* Blueprint);
+
+    // Build the editor graphs from the script and compile the Blueprint
+    static bool SynthesizeGraphs(UBlueprint* Blueprint);
+
+    FString OutputPath;
+    FString SourcePath;
+
+    // Blueprints created by the backend
+    TArray<UBlueprint*> Blueprints;
+
+    // Classes that could not be compiled
+    int32 NumErrors = 0;
+
+    UBlueprint*               Destination = nullptr;
+    UBlueprintGeneratedClass* Class = nullptr;
+
+    // State of the function being compiled
+    UFunction* CurrentFunction = nullptr;
+    int32      NumTemporaries  = 0;
+
+    // Something in the current class could not be compiled
+    bool bFailed = false;
+};
+
+// Synthesize the graphs of bytecode only Blueprints when an editor opens them
+void RegisterLazyGraphSynthesis();
+void UnregisterLazyGraphSynthesis();
@@ -5,12 +5,33 @@
 // Gamekit
 #include "GKScript.h"
 #include "GKBlueprintTraverse.h"
+#include "GKFunctionCache.h"
+#include "GKPythonInterpreter.h"
+#include "GKScriptAstCache.h"
+#include "GKScriptBatchParse.h"
+#include "GKScriptBytecode.h"
+#include "GKScriptParser.h"
+#include "GKPythonTransform.h"
+#include "GKScriptStats.h"
 
 // Unreal Engine
 #include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
 #include "Developer/AssetTools/Public/AssetToolsModule.h"
+#include "Engine/Blueprint.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "HAL/FileManager.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/SavePackage.h"
 #include "UObject/UObjectGlobals.h"
 
+// Last, Python-ast.h defines macros named after the AST nodes
+#include "GKPythonLowering.h"
+
 
 #define GKSTR_1(x) #x
 #define GKSTR(x) GKSTR_1(x)
@@ -18,6 +39,8 @@
 void ShowVersionInfo();
 void WaitReady();
 UBlueprint* LoadBlueprint(FString BlueprintPath);
+void BenchmarkParsers(FString const& Folder);
+bool SaveBlueprint(UBlueprint* Blueprint);
 
 
 int32 UGKScriptCommandlet::Main(const FString& Params)
@@ -27,16 +50,42 @@ int32 UGKScriptCommandlet::Main(const FString& Params)
     GKSCRIPT_VERBOSE(TEXT("Parameters: %s"), *Params);
     ShowVersionInfo();
 
+    FString BenchmarkFolder;
+    if (FParse::Value(*Params, TEXT("BenchmarkParsers="), BenchmarkFolder)) {
+        BenchmarkParsers(BenchmarkFolder);
+        return 0;
+    }
+
     FString Destination = "GKScript";
     FString DebugValue = TEXT("/Game/TopDown/Blueprints/BP_TopDownController.BP_TopDownController");
     FString BlueprintPath = DebugValue;
+    FString ClassPath;
 
     // Parse Parameters
     FParse::Value(*Params, TEXT("Blueprint="), BlueprintPath);
     FParse::Value(*Params, TEXT("Destination="), Destination);
+    FParse::Value(*Params, TEXT("Class="), ClassPath);
     //
 
+    // Decompile the generated class, works on cooked content
+    if (!ClassPath.IsEmpty()) {
+        UBlueprintGeneratedClass* Class = nullptr;
+        {
+            GKSCRIPT_SCOPE(STAT_GKScript_Load);
+            Class = LoadObject<UBlueprintGeneratedClass>(nullptr, *ClassPath);
+        }
+
+        if (Class == nullptr) {
+            GKSCRIPT_ERROR(TEXT("Could not load class %s"), *ClassPath);
+            return 1;
+        }
+
+        GeneratePythonFromBlueprint(Class, Destination);
+        return 0;
+    }
+
     UBlueprint* Blueprint = LoadBlueprint(BlueprintPath);
+    FGKFunctionCache::Get().Trim();
 
     if (Blueprint) {
         GKSCRIPT_VERBOSE(TEXT(""));
@@ -58,6 +107,7 @@ int32 UGKScriptCommandlet::Main(const FString& Params)
 }
 
 UBlueprint* LoadBlueprint(FString BlueprintPath) {
+    GKSCRIPT_SCOPE(STAT_GKScript_Load);
 #if 0
     // ConstructorHelpers cannot be called outside a constructor
     ConstructorHelpers::FObjectFinder<UBlueprint> TestingBlueprint(                                          //
@@ -77,6 +127,237 @@ UBlueprint* LoadBlueprint(FString BlueprintPath) {
     return Cast<UBlueprint>(StaticLoadObject(UBlueprint::StaticClass(), NULL, *FullBlueprintPath));
 }
 
+int32 UGKScriptImportCommandlet::Main(const FString& Params)
+{
+    WaitReady();
+
+    GKSCRIPT_VERBOSE(TEXT("Parameters: %s"), *Params);
+    ShowVersionInfo();
+
+    FString Scripts = FPaths::ProjectContentDir() / TEXT("GKScript");
+    FString Destination = TEXT("/Game/GKScript");
+    FString ParserName;
+    FString Backend = TEXT("Graph");
+
+    // Parse Parameters
+    FParse::Value(*Params, TEXT("Scripts="), Scripts);
+    FParse::Value(*Params, TEXT("Destination="), Destination);
+    FParse::Value(*Params, TEXT("Parser="), ParserName);
+    FParse::Value(*Params, TEXT("Backend="), Backend);
+    //
+
+    // Bytecode skips the graphs and the Kismet compiler, graphs are built when the Blueprint is opened
+    bool bBytecode = Backend.Equals(TEXT("Bytecode"));
+
+    TArray<FString> Files;
+    IFileManager::Get().FindFilesRecursive(Files, *Scripts, TEXT("*.us"), true, false);
+
+    if (Files.Num() == 0) {
+        GKSCRIPT_WARNING(TEXT("No script found in %s"), *Scripts);
+        return 0;
+    }
+
+    // Parse everything first, on every core
+    double Start = FPlatformTime::Seconds();
+    TArray<FGKScriptParseResult> Results;
+    FGKScriptBatchParser::ParseFiles(Files, Results, FGKScriptBatchParser::ParseParserName(ParserName));
+
+    int32 NumHits = 0;
+    int32 Failures = 0;
+    for (FGKScriptParseResult const& Result : Results) {
+        NumHits += Result.bCacheHit;
+
+        if (!Result.bParsed) {
+            GKSCRIPT_ERROR(TEXT("%s:%s"), *Result.Path, *Result.Error.ToString());
+            Failures += 1;
+        }
+    }
+
+    GKSCRIPT_DISPLAY(TEXT(">> Parsed %d scripts in %.2f ms, cache hits: %d, failures: %d"),
+        Files.Num(), (FPlatformTime::Seconds() - Start) * 1000.0, NumHits, Failures);
+
+    // Build the graphs, the commandlet cannot undo so nothing is recorded
+    Start = FPlatformTime::Seconds();
+    TArray<UBlueprint*> Blueprints;
+    int32 NumUnchanged = 0;
+    {
+        TGuardValue<ITransaction*> UndoGuard(GUndo, nullptr);
+
+        for (FGKScriptParseResult const& Result : Results) {
+            if (!Result.bParsed) {
+                continue;
+            }
+
+            if (bBytecode) {
+                FGKScriptBytecodeCompiler Compiler(Destination / FPaths::GetBaseFilename(Result.Path), Result.Path);
+                Compiler.Compile(Result.Ast);
+
+                Blueprints.Append(Compiler.Blueprints);
+                Failures += Compiler.NumErrors;
+                continue;
+            }
+
+            FGKPythonTransform Transform(Destination / FPaths::GetBaseFilename(Result.Path));
+            Transform.bBatch = true;
+            Transform.Transform(Result.Ast);
+
+            Blueprints.Append(Transform.Blueprints);
+            NumUnchanged += Transform.NumUnchanged;
+        }
+    }
+
+    GKSCRIPT_DISPLAY(TEXT(">> Built %d Blueprints in %.2f ms, unchanged: %d"),
+        Blueprints.Num(), (FPlatformTime::Seconds() - Start) * 1000.0, NumUnchanged);
+
+    // One compile per modified Blueprint, once all its graphs are patched
+    Start = FPlatformTime::Seconds();
+    int32 Saved = 0;
+    for (UBlueprint* Blueprint : Blueprints) {
+        if (!bBytecode) {
+            GKSCRIPT_SCOPE(STAT_GKScript_Compile);
+            FKismetEditorUtilities::CompileBlueprint(Blueprint, EBlueprintCompileOptions::SkipGarbageCollection);
+
+            if (Blueprint->Status == BS_Error) {
+                GKSCRIPT_ERROR(TEXT("%s failed to compile"), *Blueprint->GetPathName());
+            }
+        }
+
+        Saved += SaveBlueprint(Blueprint);
+    }
+
+    // Collect the transient objects left by the compilations once
+    CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+    GKSCRIPT_DISPLAY(TEXT(">> Compiled and saved %d/%d Blueprints in %.2f ms"),
+        Saved, Blueprints.Num(), (FPlatformTime::Seconds() - Start) * 1000.0);
+
+    return Failures > 0 || Saved != Blueprints.Num() ? 1 : 0;
+}
+
+bool SaveBlueprint(UBlueprint* Blueprint) {
+    GKSCRIPT_SCOPE(STAT_GKScript_Save);
+    UPackage* Package = Blueprint->GetOutermost();
+    FString Filename = FPackageName::LongPackageNameToFilename(
+        Package->GetName(),
+        FPackageName::GetAssetPackageExtension()
+    );
+
+    FSavePackageArgs SaveArgs;
+    SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+    SaveArgs.Error = GError;
+
+    if (!UPackage::SavePackage(Package, Blueprint, *Filename, SaveArgs)) {
+        GKSCRIPT_ERROR(TEXT("Could not save %s"), *Filename);
+        return false;
+    }
+    return true;
+}
+
+// Parse every .us script of a folder with CPython and the native parser
+void BenchmarkParsers(FString const& Folder) {
+    TArray<FString> Files;
+    IFileManager::Get().FindFilesRecursive(Files, *Folder, TEXT("*.us"), true, false);
+
+    if (Files.Num() == 0) {
+        GKSCRIPT_WARNING(TEXT("No script found in %s"), *Folder);
+        return;
+    }
+
+    TArray<FString> Sources;
+    TArray<TArray<ANSICHAR>> Utf8Sources;
+    Sources.SetNum(Files.Num());
+    Utf8Sources.SetNum(Files.Num());
+    int64 TotalBytes = 0;
+
+    for (int32 i = 0; i < Files.Num(); i++) {
+        FFileHelper::LoadFileToString(Sources[i], *Files[i]);
+
+        FTCHARToUTF8 Utf8(*Sources[i]);
+        Utf8Sources[i].Append(Utf8.Get(), Utf8.Length());
+        Utf8Sources[i].Add('\0');
+        TotalBytes += Utf8.Length();
+    }
+
+    double MiB = double(TotalBytes) / (1024.0 * 1024.0);
+    GKSCRIPT_DISPLAY(TEXT("Parsing %d scripts, %.2f MiB"), Files.Num(), MiB);
+
+    TArray<FGKScriptAst> Asts;
+    TArray<FGKScriptParseError> Errors;
+    Asts.SetNum(Files.Num());
+    Errors.SetNum(Files.Num());
+    TArray<bool> Parsed;
+    Parsed.SetNumZeroed(Files.Num());
+
+    // CPython lowered to the same AST, the GIL serializes the parses
+    FGKPythonInterpreter::Get().Initialize();
+
+    double Start = FPlatformTime::Seconds();
+    for (int32 i = 0; i < Utf8Sources.Num(); i++) {
+        FGKPythonLowering::Parse(Utf8Sources[i].GetData(), Asts[i], Errors[i]);
+    }
+    double CPythonTime = FPlatformTime::Seconds() - Start;
+
+    // Native, one thread
+    Start = FPlatformTime::Seconds();
+    for (int32 i = 0; i < Sources.Num(); i++) {
+        FGKScriptParser::Parse(Sources[i], Asts[i], Errors[i]);
+    }
+    double SerialTime = FPlatformTime::Seconds() - Start;
+
+    // Native, every core
+    Start = FPlatformTime::Seconds();
+    ParallelFor(Sources.Num(), [&](int32 i) {
+        Parsed[i] = FGKScriptParser::Parse(Sources[i], Asts[i], Errors[i]);
+    });
+    double ParallelTime = FPlatformTime::Seconds() - Start;
+
+    // Native, through the AST cache, the first pass fills it
+    FGKScriptAstCache& Cache = FGKScriptAstCache::Get();
+    ParallelFor(Sources.Num(), [&](int32 i) {
+        FGKScriptParseError CacheError;
+        Cache.GetOrParse(Sources[i], Asts[i], CacheError);
+    });
+
+    TArray<bool> Hits;
+    Hits.SetNumZeroed(Files.Num());
+
+    Start = FPlatformTime::Seconds();
+    ParallelFor(Sources.Num(), [&](int32 i) {
+        FGKScriptParseError CacheError;
+        Cache.GetOrParse(Sources[i], Asts[i], CacheError, &Hits[i]);
+    });
+    double CachedTime = FPlatformTime::Seconds() - Start;
+
+    int32 Failures = 0;
+    for (int32 i = 0; i < Files.Num(); i++) {
+        if (!Parsed[i]) {
+            GKSCRIPT_WARNING(TEXT("%s:%s"), *Files[i], *Errors[i].ToString());
+            Failures += 1;
+        }
+    }
+
+    auto Report = [MiB](const TCHAR* Name, double Time) {
+        GKSCRIPT_DISPLAY(TEXT(" - %-16s: %8.2f ms %8.2f MiB/s"), Name, Time * 1000.0, MiB / FMath::Max(Time, 1e-9));
+    };
+
+    Report(TEXT("CPython"), CPythonTime);
+    Report(TEXT("Native"), SerialTime);
+    Report(TEXT("Native parallel"), ParallelTime);
+    Report(TEXT("Cached parallel"), CachedTime);
+
+    int32 NumHits = 0;
+    for (bool bHit : Hits) {
+        NumHits += bHit;
+    }
+
+    GKSCRIPT_DISPLAY(TEXT(" - Threads: %d, speedup vs CPython: %.1fx, failures: %d, cache hits: %d"),
+        FTaskGraphInterface::Get().GetNumWorkerThreads() + 1,
+        CPythonTime / FMath::Max(ParallelTime, 1e-9),
+        Failures,
+        NumHits
+    );
+}
+
 void ShowVersionInfo() {
     FString Tag = GKSTR(GKSCRIPT_TAG);
     FString Commit = GKSTR(GKSCRIPT_COMMIT);
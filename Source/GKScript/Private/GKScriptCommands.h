@@ -15,6 +15,17 @@ class UGKScriptCommandlet : public UCommandlet
 {
     GENERATED_BODY()
 
+public:
+    virtual int32 Main(const FString& Params) override;
+};
+
+
+// <Your Project Name> -run=GKScriptImport -Scripts=<Folder> -Destination=/Game/GKScript
+UCLASS()
+class UGKScriptImportCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
 public:
     virtual int32 Main(const FString& Params) override;
 };
\ No newline at end of file
@@ -0,0 +1,1282 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKScriptParser.h"
+
+// Gamekit
+#include "GKScriptStats.h"
+
+
+namespace {
+
+enum class EGKToken : uint8 {
+    Name,
+    Number,
+    String,
+    Op,
+    Newline,
+    Indent,
+    Dedent,
+    End,
+};
+
+struct FGKToken {
+    EGKToken    Kind = EGKToken::End;
+    bool        bRaw = false;       // String without escape processing
+    FStringView Text;               // Strings exclude their quotes
+    int32       Line = 0;
+    int32       Column = 0;
+};
+
+using FGKNodeList = TArray<int32, TInlineAllocator<8>>;
+
+// Longest first
+const TCHAR* const GKOperators[] = {
+    TEXT("**="), TEXT("//="), TEXT(">>="), TEXT("<<="), TEXT("..."),
+    TEXT("=="), TEXT("!="), TEXT("<="), TEXT(">="), TEXT("->"), TEXT(":="),
+    TEXT("+="), TEXT("-="), TEXT("*="), TEXT("/="), TEXT("%="),
+    TEXT("**"), TEXT("//"), TEXT("<<"), TEXT(">>"),
+};
+
+const TCHAR GKSingleOperators[] = TEXT("()[]{}:,.;@=+-*/%<>|&^~");
+
+const int32 GKMaxDepth = 256;
+
+
+/*! Split the source into tokens, python style
+ *
+ * Indentation becomes Indent/Dedent tokens, newlines inside brackets
+ * and blank lines are dropped.
+ */
+struct FGKLexer {
+    FGKLexer(FStringView Source, FGKScriptParseError& Error):
+        Source(Source), Error(Error)
+    {}
+
+    bool Tokenize(TArray<FGKToken>& Tokens) {
+        Tokens.Reserve(Source.Len() / 4);
+        IndentStack.Add(0);
+
+        bool bLineStart = true;
+
+        while (Pos < Source.Len()) {
+            if (bLineStart && Brackets == 0) {
+                bLineStart = false;
+                if (!Indentation(Tokens)) {
+                    return false;
+                }
+                continue;
+            }
+
+            TCHAR C = Source[Pos];
+
+            if (C == TEXT(' ') || C == TEXT('\t') || C == TEXT('\r') || C == TEXT('\f')) {
+                Pos += 1;
+                continue;
+            }
+
+            if (C == TEXT('#')) {
+                SkipComment();
+                continue;
+            }
+
+            if (C == TEXT('\\') && Peek(1) == TEXT('\n')) {
+                Pos += 2;
+                NewLine();
+                continue;
+            }
+
+            if (C == TEXT('\n')) {
+                if (Brackets == 0) {
+                    Add(Tokens, EGKToken::Newline, Pos, 0);
+                    bLineStart = true;
+                }
+                Pos += 1;
+                NewLine();
+                continue;
+            }
+
+            if (FChar::IsDigit(C) || (C == TEXT('.') && FChar::IsDigit(Peek(1)))) {
+                Number(Tokens);
+                continue;
+            }
+
+            if (FChar::IsAlpha(C) || C == TEXT('_') || C > 127) {
+                int32 Start = Pos;
+                while (Pos < Source.Len() && (FChar::IsAlnum(Source[Pos]) || Source[Pos] == TEXT('_') || Source[Pos] > 127)) {
+                    Pos += 1;
+                }
+
+                // String prefix
+                FStringView Prefix = Source.Mid(Start, Pos - Start);
+                if (IsQuote(Peek(0)) && IsStringPrefix(Prefix)) {
+                    bool bRaw = false;
+                    for (TCHAR P : Prefix) {
+                        bRaw |= FChar::ToLower(P) == TEXT('r');
+                    }
+                    if (!String(Tokens, bRaw)) {
+                        return false;
+                    }
+                    continue;
+                }
+
+                Add(Tokens, EGKToken::Name, Start, Pos - Start);
+                continue;
+            }
+
+            if (IsQuote(C)) {
+                if (!String(Tokens, false)) {
+                    return false;
+                }
+                continue;
+            }
+
+            if (!Operator(Tokens)) {
+                return false;
+            }
+        }
+
+        // Close the last line and the opened blocks
+        if (Tokens.Num() > 0 && Tokens.Last().Kind != EGKToken::Newline && Tokens.Last().Kind != EGKToken::Dedent) {
+            Add(Tokens, EGKToken::Newline, Pos, 0);
+        }
+        while (IndentStack.Num() > 1) {
+            IndentStack.Pop(false);
+            Add(Tokens, EGKToken::Dedent, Pos, 0);
+        }
+        Add(Tokens, EGKToken::End, Pos, 0);
+        return true;
+    }
+
+    private:
+    TCHAR Peek(int32 Offset) const {
+        int32 i = Pos + Offset;
+        return i < Source.Len() ? Source[i] : TEXT('\0');
+    }
+
+    static bool IsQuote(TCHAR C) {
+        return C == TEXT('"') || C == TEXT('\'');
+    }
+
+    static bool IsStringPrefix(FStringView Prefix) {
+        if (Prefix.Len() > 2) {
+            return false;
+        }
+        for (TCHAR C : Prefix) {
+            C = FChar::ToLower(C);
+            if (C != TEXT('r') && C != TEXT('u') && C != TEXT('b') && C != TEXT('f')) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void NewLine() {
+        Line += 1;
+        LineStart = Pos;
+    }
+
+    void Add(TArray<FGKToken>& Tokens, EGKToken Kind, int32 Start, int32 Len, bool bRaw = false) {
+        FGKToken& Token = Tokens.AddDefaulted_GetRef();
+        Token.Kind = Kind;
+        Token.bRaw = bRaw;
+        Token.Text = Source.Mid(Start, Len);
+        Token.Line = Line;
+        Token.Column = Start - LineStart + 1;
+    }
+
+    bool Fail(const TCHAR* Message) {
+        Error.Line = Line;
+        Error.Column = Pos - LineStart + 1;
+        Error.Message = Message;
+        return false;
+    }
+
+    void SkipComment() {
+        while (Pos < Source.Len() && Source[Pos] != TEXT('\n')) {
+            Pos += 1;
+        }
+    }
+
+    bool Indentation(TArray<FGKToken>& Tokens) {
+        int32 Width = 0;
+
+        while (Pos < Source.Len()) {
+            TCHAR C = Source[Pos];
+
+            if (C == TEXT(' ')) {
+                Width += 1;
+            } else if (C == TEXT('\t')) {
+                Width = (Width / 8 + 1) * 8;
+            } else if (C == TEXT('\r') || C == TEXT('\f')) {
+            } else if (C == TEXT('#')) {
+                SkipComment();
+                continue;
+            } else if (C == TEXT('\n')) {
+                // Blank lines and comments do not change the indentation
+                Width = 0;
+                Pos += 1;
+                NewLine();
+                continue;
+            } else {
+                break;
+            }
+            Pos += 1;
+        }
+
+        if (Pos >= Source.Len()) {
+            return true;
+        }
+
+        if (Width > IndentStack.Last()) {
+            IndentStack.Add(Width);
+            Add(Tokens, EGKToken::Indent, Pos, 0);
+            return true;
+        }
+
+        while (Width < IndentStack.Last()) {
+            IndentStack.Pop(false);
+            Add(Tokens, EGKToken::Dedent, Pos, 0);
+        }
+
+        if (Width != IndentStack.Last()) {
+            return Fail(TEXT("unindent does not match any outer indentation level"));
+        }
+        return true;
+    }
+
+    void Number(TArray<FGKToken>& Tokens) {
+        int32 Start = Pos;
+
+        while (Pos < Source.Len()) {
+            TCHAR C = Source[Pos];
+
+            if (FChar::IsAlnum(C) || C == TEXT('_') || C == TEXT('.')) {
+                Pos += 1;
+            }
+            // Exponent sign
+            else if ((C == TEXT('+') || C == TEXT('-')) && (Source[Pos - 1] == TEXT('e') || Source[Pos - 1] == TEXT('E'))) {
+                Pos += 1;
+            }
+            else {
+                break;
+            }
+        }
+
+        Add(Tokens, EGKToken::Number, Start, Pos - Start);
+    }
+
+    bool String(TArray<FGKToken>& Tokens, bool bRaw) {
+        TCHAR Quote = Source[Pos];
+        bool bTriple = Peek(1) == Quote && Peek(2) == Quote;
+        int32 QuoteLen = bTriple ? 3 : 1;
+
+        int32 StartLine = Line;
+        int32 StartColumn = Pos - LineStart + 1;
+
+        Pos += QuoteLen;
+        int32 Start = Pos;
+
+        while (true) {
+            if (Pos >= Source.Len()) {
+                return Fail(TEXT("unterminated string literal"));
+            }
+
+            TCHAR C = Source[Pos];
+
+            if (C == TEXT('\\')) {
+                if (Peek(1) == TEXT('\n')) {
+                    Pos += 1;
+                    NewLine();
+                }
+                Pos += 2;
+                continue;
+            }
+
+            if (C == TEXT('\n')) {
+                if (!bTriple) {
+                    return Fail(TEXT("unterminated string literal"));
+                }
+                Pos += 1;
+                NewLine();
+                continue;
+            }
+
+            if (C == Quote && (!bTriple || (Peek(1) == Quote && Peek(2) == Quote))) {
+                break;
+            }
+            Pos += 1;
+        }
+
+        FGKToken& Token = Tokens.AddDefaulted_GetRef();
+        Token.Kind = EGKToken::String;
+        Token.bRaw = bRaw;
+        Token.Text = Source.Mid(Start, Pos - Start);
+        Token.Line = StartLine;
+        Token.Column = StartColumn;
+
+        Pos += QuoteLen;
+        return true;
+    }
+
+    bool Operator(TArray<FGKToken>& Tokens) {
+        FStringView Rest = Source.RightChop(Pos);
+
+        for (const TCHAR* Op : GKOperators) {
+            if (Rest.StartsWith(Op)) {
+                int32 Len = FCString::Strlen(Op);
+                Add(Tokens, EGKToken::Op, Pos, Len);
+                Pos += Len;
+                return true;
+            }
+        }
+
+        TCHAR C = Source[Pos];
+        if (FCString::Strchr(GKSingleOperators, C) == nullptr) {
+            return Fail(TEXT("invalid character"));
+        }
+
+        if (C == TEXT('(') || C == TEXT('[') || C == TEXT('{')) {
+            Brackets += 1;
+        }
+        else if (C == TEXT(')') || C == TEXT(']') || C == TEXT('}')) {
+            Brackets = FMath::Max(Brackets - 1, 0);
+        }
+
+        Add(Tokens, EGKToken::Op, Pos, 1);
+        Pos += 1;
+        return true;
+    }
+
+    FStringView               Source;
+    FGKScriptParseError&      Error;
+    TArray<int32, TInlineAllocator<16>> IndentStack;
+    int32                     Pos = 0;
+    int32                     Line = 1;
+    int32                     LineStart = 0;
+    int32                     Brackets = 0;
+};
+
+
+/*! Recursive descent parser over the tokens
+ *
+ * Every rule returns the index of the node it created or INDEX_NONE on error,
+ * the first error is kept and stops the parse.
+ */
+struct FGKParser {
+    FGKParser(TArray<FGKToken> const& Tokens, FGKScriptAst& Ast, FGKScriptParseError& Error):
+        Tokens(Tokens), Builder(Ast), Error(Error)
+    {}
+
+    bool Module() {
+        FGKNodeList Body;
+
+        while (!Failed() && !Check(EGKToken::End)) {
+            if (Match(EGKToken::Newline)) {
+                continue;
+            }
+            Statement(Body);
+        }
+
+        if (Failed()) {
+            return false;
+        }
+
+        Builder.Ast.Root = Builder.AddNode(EGKAstKind::Module, INDEX_NONE, Body, 1);
+        return true;
+    }
+
+    private:
+    // Tokens
+    // ------
+    FGKToken const& Current() const {
+        return Tokens[Pos];
+    }
+
+    FGKToken const& Peek(int32 Offset) const {
+        return Tokens[FMath::Min(Pos + Offset, Tokens.Num() - 1)];
+    }
+
+    FGKToken const& Advance() {
+        FGKToken const& Token = Tokens[Pos];
+        if (Token.Kind != EGKToken::End) {
+            Pos += 1;
+        }
+        return Token;
+    }
+
+    bool Check(EGKToken Kind) const {
+        return Current().Kind == Kind;
+    }
+
+    bool CheckOp(const TCHAR* Op) const {
+        return Current().Kind == EGKToken::Op && Current().Text.Equals(Op, ESearchCase::CaseSensitive);
+    }
+
+    bool CheckName(const TCHAR* Name) const {
+        return Current().Kind == EGKToken::Name && Current().Text.Equals(Name, ESearchCase::CaseSensitive);
+    }
+
+    bool Match(EGKToken Kind) {
+        if (Check(Kind)) {
+            Advance();
+            return true;
+        }
+        return false;
+    }
+
+    bool MatchOp(const TCHAR* Op) {
+        if (CheckOp(Op)) {
+            Advance();
+            return true;
+        }
+        return false;
+    }
+
+    bool MatchName(const TCHAR* Name) {
+        if (CheckName(Name)) {
+            Advance();
+            return true;
+        }
+        return false;
+    }
+
+    bool ExpectOp(const TCHAR* Op) {
+        if (MatchOp(Op)) {
+            return true;
+        }
+        Fail(*FString::Printf(TEXT("expected '%s'"), Op));
+        return false;
+    }
+
+    bool Expect(EGKToken Kind, const TCHAR* What) {
+        if (Match(Kind)) {
+            return true;
+        }
+        Fail(*FString::Printf(TEXT("expected %s"), What));
+        return false;
+    }
+
+    int32 Fail(const TCHAR* Message) {
+        if (!bFailed) {
+            FGKToken const& Token = Current();
+            Error.Line = Token.Line;
+            Error.Column = Token.Column;
+            Error.Message = Message;
+            if (Token.Kind != EGKToken::Newline && Token.Kind != EGKToken::End) {
+                Error.Message += TEXT(", got '");
+                Error.Message.Append(Token.Text.GetData(), Token.Text.Len());
+                Error.Message += TEXT("'");
+            }
+            bFailed = true;
+        }
+        return INDEX_NONE;
+    }
+
+    bool Failed() const {
+        return bFailed;
+    }
+
+    int32 Intern(FStringView Str) {
+        return Builder.Intern(Str);
+    }
+
+    // Statements
+    // ----------
+    void Statement(FGKNodeList& Body) {
+        if (CheckOp(TEXT("@")) || CheckName(TEXT("class")) || CheckName(TEXT("def"))) {
+            Body.Add(Definition());
+            return;
+        }
+
+        if (CheckName(TEXT("if"))) {
+            Advance();
+            Body.Add(If());
+            return;
+        }
+
+        if (CheckName(TEXT("match")) && IsMatchStatement()) {
+            Body.Add(MatchStatement());
+            return;
+        }
+
+        // Simple statements, ``;`` separated
+        do {
+            if (Check(EGKToken::Newline)) {
+                break;
+            }
+            if (MatchName(TEXT("import"))) {
+                Import(Body);
+                continue;
+            }
+            Body.Add(SimpleStatement());
+        } while (!Failed() && MatchOp(TEXT(";")));
+
+        if (!Failed()) {
+            Expect(EGKToken::Newline, TEXT("end of line"));
+        }
+    }
+
+    // ``import a, b`` is one Import per module, as FGKPythonLowering splits it
+    void Import(FGKNodeList& Body) {
+        do {
+            int32 Line = Current().Line;
+            int32 Module = DottedName();
+            if (Failed()) {
+                return;
+            }
+            Body.Add(Builder.AddNode(EGKAstKind::Import, Module, {}, Line));
+        } while (MatchOp(TEXT(",")));
+    }
+
+    int32 SimpleStatement() {
+        int32 Line = Current().Line;
+
+        if (MatchName(TEXT("pass"))) {
+            return Builder.AddNode(EGKAstKind::Pass, INDEX_NONE, {}, Line);
+        }
+
+        if (MatchName(TEXT("return"))) {
+            int32 Value = INDEX_NONE;
+            if (!Check(EGKToken::Newline) && !CheckOp(TEXT(";"))) {
+                Value = ExpressionList();
+            }
+            int32 Kids[] = {Value};
+            return Builder.AddNode(EGKAstKind::Return, INDEX_NONE, Kids, Line);
+        }
+
+        if (MatchName(TEXT("from"))) {
+            int32 Module = DottedName();
+            if (!Failed() && !MatchName(TEXT("import"))) {
+                return Fail(TEXT("expected 'import'"));
+            }
+
+            bool bParen = MatchOp(TEXT("("));
+            FGKNodeList Names;
+            do {
+                if (bParen && CheckOp(TEXT(")"))) {
+                    break;
+                }
+                if (MatchOp(TEXT("*"))) {
+                    Names.Add(Builder.AddNode(EGKAstKind::Name, Intern(TEXT("*")), {}, Line));
+                    continue;
+                }
+                if (!Check(EGKToken::Name)) {
+                    return Fail(TEXT("expected a name"));
+                }
+                Names.Add(Builder.AddNode(EGKAstKind::Name, Intern(Advance().Text), {}, Line));
+            } while (MatchOp(TEXT(",")));
+
+            if (bParen && !ExpectOp(TEXT(")"))) {
+                return INDEX_NONE;
+            }
+            return Builder.AddNode(EGKAstKind::ImportFrom, Module, Names, Line);
+        }
+
+        // Expression, assignment
+        int32 Target = ExpressionList();
+        if (Failed()) {
+            return INDEX_NONE;
+        }
+
+        if (MatchOp(TEXT(":"))) {
+            int32 Annotation = Expression();
+            int32 Value = INDEX_NONE;
+            if (MatchOp(TEXT("="))) {
+                Value = ExpressionList();
+            }
+            int32 Kids[] = {Target, Annotation, Value};
+            return Builder.AddNode(EGKAstKind::AnnAssign, INDEX_NONE, Kids, Line);
+        }
+
+        if (MatchOp(TEXT("="))) {
+            // a = b = c is one Assign with two targets, like python
+            FGKNodeList Kids;
+            Kids.Add(Target);
+            Kids.Add(ExpressionList());
+
+            while (!Failed() && MatchOp(TEXT("="))) {
+                Kids.Add(ExpressionList());
+            }
+            return Builder.AddNode(EGKAstKind::Assign, INDEX_NONE, Kids, Line);
+        }
+
+        EGKAstOp AugOp = EGKAstOp::None;
+        if (CheckOp(TEXT("+="))) { AugOp = EGKAstOp::Add; }
+        else if (CheckOp(TEXT("-="))) { AugOp = EGKAstOp::Sub; }
+        else if (CheckOp(TEXT("*="))) { AugOp = EGKAstOp::Mult; }
+        else if (CheckOp(TEXT("/="))) { AugOp = EGKAstOp::Div; }
+        else if (CheckOp(TEXT("%="))) { AugOp = EGKAstOp::Mod; }
+
+        if (AugOp != EGKAstOp::None) {
+            Advance();
+            int32 Kids[] = {Target, Expression()};
+            return Builder.AddNode(EGKAstKind::AugAssign, INDEX_NONE, Kids, Line, uint8(AugOp));
+        }
+
+        int32 Kids[] = {Target};
+        return Builder.AddNode(EGKAstKind::ExprStmt, INDEX_NONE, Kids, Line);
+    }
+
+    int32 DottedName() {
+        if (!Check(EGKToken::Name)) {
+            return Fail(TEXT("expected a module name"));
+        }
+
+        FGKToken const& First = Advance();
+        FStringView Name = First.Text;
+
+        // Tokens are views in the source, the dotted name is contiguous
+        // unless spaces were put around the dots
+        TStringBuilder<128> Builder_;
+        Builder_ << Name;
+        while (MatchOp(TEXT("."))) {
+            if (!Check(EGKToken::Name)) {
+                return Fail(TEXT("expected a name"));
+            }
+            Builder_ << TEXT('.') << Advance().Text;
+        }
+        return Intern(Builder_.ToView());
+    }
+
+    int32 Definition() {
+        FGKNodeList Decorators;
+        int32 Line = Current().Line;
+
+        while (MatchOp(TEXT("@"))) {
+            Decorators.Add(Expression());
+            if (Failed() || !Expect(EGKToken::Newline, TEXT("end of line"))) {
+                return INDEX_NONE;
+            }
+            while (Match(EGKToken::Newline)) {}
+        }
+
+        int32 DecoratorBlock = Builder.AddNode(EGKAstKind::Block, INDEX_NONE, Decorators, Line);
+
+        if (MatchName(TEXT("class"))) {
+            return ClassDef(DecoratorBlock);
+        }
+        if (MatchName(TEXT("def"))) {
+            return FunctionDef(DecoratorBlock);
+        }
+        return Fail(TEXT("expected 'class' or 'def'"));
+    }
+
+    int32 ClassDef(int32 Decorators) {
+        int32 Line = Current().Line;
+        if (!Check(EGKToken::Name)) {
+            return Fail(TEXT("expected a class name"));
+        }
+        int32 Name = Intern(Advance().Text);
+
+        FGKNodeList Bases;
+        if (MatchOp(TEXT("("))) {
+            while (!Failed() && !CheckOp(TEXT(")"))) {
+                Bases.Add(Expression());
+                if (!MatchOp(TEXT(","))) {
+                    break;
+                }
+            }
+            if (!ExpectOp(TEXT(")"))) {
+                return INDEX_NONE;
+            }
+        }
+
+        int32 BaseBlock = Builder.AddNode(EGKAstKind::Block, INDEX_NONE, Bases, Line);
+        int32 Body = Suite();
+
+        int32 Kids[] = {BaseBlock, Decorators, Body};
+        return Builder.AddNode(EGKAstKind::ClassDef, Name, Kids, Line);
+    }
+
+    int32 FunctionDef(int32 Decorators) {
+        int32 Line = Current().Line;
+        if (!Check(EGKToken::Name)) {
+            return Fail(TEXT("expected a function name"));
+        }
+        int32 Name = Intern(Advance().Text);
+
+        if (!ExpectOp(TEXT("("))) {
+            return INDEX_NONE;
+        }
+
+        FGKNodeList Args;
+        while (!Failed() && !CheckOp(TEXT(")"))) {
+            if (!Check(EGKToken::Name)) {
+                return Fail(TEXT("expected an argument name"));
+            }
+
+            FGKToken const& ArgName = Advance();
+            int32 Annotation = INDEX_NONE;
+            int32 Default = INDEX_NONE;
+
+            if (MatchOp(TEXT(":"))) {
+                Annotation = Expression();
+            }
+            if (MatchOp(TEXT("="))) {
+                Default = Expression();
+            }
+
+            int32 Kids[] = {Annotation, Default};
+            Args.Add(Builder.AddNode(EGKAstKind::Arg, Intern(ArgName.Text), Kids, ArgName.Line));
+
+            if (!MatchOp(TEXT(","))) {
+                break;
+            }
+        }
+
+        if (Failed() || !ExpectOp(TEXT(")"))) {
+            return INDEX_NONE;
+        }
+
+        int32 ArgBlock = Builder.AddNode(EGKAstKind::Block, INDEX_NONE, Args, Line);
+
+        int32 Returns = INDEX_NONE;
+        if (MatchOp(TEXT("->"))) {
+            Returns = Expression();
+        }
+
+        int32 Body = Suite();
+
+        int32 Kids[] = {Decorators, ArgBlock, Returns, Body};
+        return Builder.AddNode(EGKAstKind::FunctionDef, Name, Kids, Line);
+    }
+
+    int32 If() {
+        int32 Line = Current().Line;
+        int32 Test = Expression();
+        int32 Body = Suite();
+        int32 OrElse = INDEX_NONE;
+
+        if (!Failed() && MatchName(TEXT("elif"))) {
+            int32 ElseLine = Current().Line;
+            int32 Kids[] = {If()};
+            OrElse = Builder.AddNode(EGKAstKind::Block, INDEX_NONE, Kids, ElseLine);
+        }
+        else if (!Failed() && MatchName(TEXT("else"))) {
+            OrElse = Suite();
+        }
+        else {
+            OrElse = Builder.AddNode(EGKAstKind::Block, INDEX_NONE, {}, Line);
+        }
+
+        int32 Kids[] = {Test, Body, OrElse};
+        return Builder.AddNode(EGKAstKind::If, INDEX_NONE, Kids, Line);
+    }
+
+    // ``match`` is a soft keyword, ``match = 1`` is an assignment
+    bool IsMatchStatement() const {
+        FGKToken const& Next = Peek(1);
+        if (Next.Kind == EGKToken::Newline || Next.Kind == EGKToken::End) {
+            return false;
+        }
+        if (Next.Kind == EGKToken::Op && !Next.Text.Equals(TEXT("(")) && !Next.Text.Equals(TEXT("[")) &&
+            !Next.Text.Equals(TEXT("-"))) {
+            return false;
+        }
+
+        // The line must end with ``:`` and open a block
+        int32 Depth = 0;
+        for (int32 i = Pos + 1; i < Tokens.Num(); i++) {
+            FGKToken const& Token = Tokens[i];
+            if (Token.Kind == EGKToken::Newline || Token.Kind == EGKToken::End) {
+                FGKToken const& Previous = Tokens[i - 1];
+                return Previous.Kind == EGKToken::Op && Previous.Text.Equals(TEXT(":")) &&
+                       i + 1 < Tokens.Num() && Tokens[i + 1].Kind == EGKToken::Indent;
+            }
+            if (Token.Kind == EGKToken::Op) {
+                if (Token.Text.Equals(TEXT("(")) || Token.Text.Equals(TEXT("["))) {
+                    Depth += 1;
+                } else if (Token.Text.Equals(TEXT(")")) || Token.Text.Equals(TEXT("]"))) {
+                    Depth -= 1;
+                } else if (Depth == 0 && Token.Text.Equals(TEXT("="))) {
+                    return false;
+                }
+            }
+        }
+        return false;
+    }
+
+    int32 MatchStatement() {
+        int32 Line = Current().Line;
+        Advance();
+
+        FGKNodeList Kids;
+        Kids.Add(ExpressionList());
+
+        if (Failed() || !ExpectOp(TEXT(":")) || !Expect(EGKToken::Newline, TEXT("end of line")) ||
+            !Expect(EGKToken::Indent, TEXT("an indented block"))) {
+            return INDEX_NONE;
+        }
+
+        while (!Failed() && !Match(EGKToken::Dedent)) {
+            if (Match(EGKToken::Newline)) {
+                continue;
+            }
+
+            int32 CaseLine = Current().Line;
+            if (!MatchName(TEXT("case"))) {
+                return Fail(TEXT("expected 'case'"));
+            }
+
+            int32 Pattern = Expression();
+            if (CheckName(TEXT("if"))) {
+                return Fail(TEXT("case guards are not supported"));
+            }
+
+            int32 CaseKids[] = {Pattern, Suite()};
+            Kids.Add(Builder.AddNode(EGKAstKind::Case, INDEX_NONE, CaseKids, CaseLine));
+        }
+
+        return Builder.AddNode(EGKAstKind::Match, INDEX_NONE, Kids, Line);
+    }
+
+    // ``: stmt`` or ``: NEWLINE INDENT stmt+ DEDENT``
+    int32 Suite() {
+        int32 Line = Current().Line;
+        FGKNodeList Body;
+
+        if (Failed() || !ExpectOp(TEXT(":"))) {
+            return INDEX_NONE;
+        }
+
+        if (!Match(EGKToken::Newline)) {
+            Statement(Body);
+            return Builder.AddNode(EGKAstKind::Block, INDEX_NONE, Body, Line);
+        }
+
+        if (!Expect(EGKToken::Indent, TEXT("an indented block"))) {
+            return INDEX_NONE;
+        }
+
+        Depth += 1;
+        if (Depth > GKMaxDepth) {
+            return Fail(TEXT("too many nested blocks"));
+        }
+
+        while (!Failed() && !Match(EGKToken::Dedent)) {
+            if (Check(EGKToken::End)) {
+                break;
+            }
+            if (Match(EGKToken::Newline)) {
+                continue;
+            }
+            Statement(Body);
+        }
+
+        Depth -= 1;
+        return Builder.AddNode(EGKAstKind::Block, INDEX_NONE, Body, Line);
+    }
+
+    // Expressions
+    // -----------
+
+    // ``a, b`` is a tuple
+    int32 ExpressionList() {
+        int32 Line = Current().Line;
+        int32 First = Expression();
+
+        if (!CheckOp(TEXT(","))) {
+            return First;
+        }
+
+        FGKNodeList Elts;
+        Elts.Add(First);
+        while (!Failed() && MatchOp(TEXT(","))) {
+            if (!StartsExpression()) {
+                break;
+            }
+            Elts.Add(Expression());
+        }
+        return Builder.AddNode(EGKAstKind::Tuple, INDEX_NONE, Elts, Line);
+    }
+
+    bool StartsExpression() const {
+        FGKToken const& Token = Current();
+        switch (Token.Kind) {
+        case EGKToken::Name:
+        case EGKToken::Number:
+        case EGKToken::String:
+            return true;
+        case EGKToken::Op:
+            return Token.Text.Equals(TEXT("(")) || Token.Text.Equals(TEXT("[")) ||
+                   Token.Text.Equals(TEXT("-")) || Token.Text.Equals(TEXT("+"));
+        default:
+            return false;
+        }
+    }
+
+    int32 Expression() {
+        if (Failed()) {
+            return INDEX_NONE;
+        }
+
+        if (!EnterNested()) {
+            return INDEX_NONE;
+        }
+
+        int32 Result = OrTest();
+        Depth -= 1;
+        return Result;
+    }
+
+    // Expressions and unary operators nest, the depth bounds the recursion
+    bool EnterNested() {
+        Depth += 1;
+        if (Depth > GKMaxDepth) {
+            Fail(TEXT("expression is too deeply nested"));
+            return false;
+        }
+        return true;
+    }
+
+    int32 OrTest() {
+        int32 Left = AndTest();
+        while (!Failed() && CheckName(TEXT("or"))) {
+            int32 Line = Advance().Line;
+            int32 Kids[] = {Left, AndTest()};
+            Left = Builder.AddNode(EGKAstKind::BoolOp, INDEX_NONE, Kids, Line, uint8(EGKAstOp::Or));
+        }
+        return Left;
+    }
+
+    int32 AndTest() {
+        int32 Left = NotTest();
+        while (!Failed() && CheckName(TEXT("and"))) {
+            int32 Line = Advance().Line;
+            int32 Kids[] = {Left, NotTest()};
+            Left = Builder.AddNode(EGKAstKind::BoolOp, INDEX_NONE, Kids, Line, uint8(EGKAstOp::And));
+        }
+        return Left;
+    }
+
+    int32 NotTest() {
+        if (CheckName(TEXT("not"))) {
+            int32 Line = Advance().Line;
+            if (!EnterNested()) {
+                return INDEX_NONE;
+            }
+
+            int32 Kids[] = {NotTest()};
+            Depth -= 1;
+            return Builder.AddNode(EGKAstKind::UnaryOp, INDEX_NONE, Kids, Line, uint8(EGKAstOp::Not));
+        }
+        return Comparison();
+    }
+
+    EGKAstOp CompareOp() {
+        if (MatchOp(TEXT("=="))) { return EGKAstOp::Eq; }
+        if (MatchOp(TEXT("!="))) { return EGKAstOp::NotEq; }
+        if (MatchOp(TEXT("<="))) { return EGKAstOp::LtE; }
+        if (MatchOp(TEXT(">="))) { return EGKAstOp::GtE; }
+        if (MatchOp(TEXT("<")))  { return EGKAstOp::Lt; }
+        if (MatchOp(TEXT(">")))  { return EGKAstOp::Gt; }
+        if (MatchName(TEXT("in"))) { return EGKAstOp::In; }
+        if (MatchName(TEXT("is"))) {
+            return MatchName(TEXT("not")) ? EGKAstOp::IsNot : EGKAstOp::Is;
+        }
+        if (CheckName(TEXT("not")) && Peek(1).Kind == EGKToken::Name && Peek(1).Text.Equals(TEXT("in"))) {
+            Advance();
+            Advance();
+            return EGKAstOp::NotIn;
+        }
+        return EGKAstOp::None;
+    }
+
+    // Chained comparisons are folded to the left
+    int32 Comparison() {
+        int32 Left = Arithmetic();
+        while (!Failed()) {
+            int32 Line = Current().Line;
+            EGKAstOp Op = CompareOp();
+            if (Op == EGKAstOp::None) {
+                break;
+            }
+            int32 Kids[] = {Left, Arithmetic()};
+            Left = Builder.AddNode(EGKAstKind::Compare, INDEX_NONE, Kids, Line, uint8(Op));
+        }
+        return Left;
+    }
+
+    int32 Arithmetic() {
+        int32 Left = Term();
+        while (!Failed()) {
+            EGKAstOp Op = CheckOp(TEXT("+")) ? EGKAstOp::Add : CheckOp(TEXT("-")) ? EGKAstOp::Sub : EGKAstOp::None;
+            if (Op == EGKAstOp::None) {
+                break;
+            }
+            int32 Line = Advance().Line;
+            int32 Kids[] = {Left, Term()};
+            Left = Builder.AddNode(EGKAstKind::BinOp, INDEX_NONE, Kids, Line, uint8(Op));
+        }
+        return Left;
+    }
+
+    int32 Term() {
+        int32 Left = Factor();
+        while (!Failed()) {
+            EGKAstOp Op = CheckOp(TEXT("*")) ? EGKAstOp::Mult :
+                          CheckOp(TEXT("/")) ? EGKAstOp::Div  :
+                          CheckOp(TEXT("%")) ? EGKAstOp::Mod  : EGKAstOp::None;
+            if (Op == EGKAstOp::None) {
+                break;
+            }
+            int32 Line = Advance().Line;
+            int32 Kids[] = {Left, Factor()};
+            Left = Builder.AddNode(EGKAstKind::BinOp, INDEX_NONE, Kids, Line, uint8(Op));
+        }
+        return Left;
+    }
+
+    int32 Factor() {
+        if (CheckOp(TEXT("-"))) {
+            int32 Line = Advance().Line;
+            if (!EnterNested()) {
+                return INDEX_NONE;
+            }
+
+            int32 Kids[] = {Factor()};
+            Depth -= 1;
+            return Builder.AddNode(EGKAstKind::UnaryOp, INDEX_NONE, Kids, Line, uint8(EGKAstOp::USub));
+        }
+        if (MatchOp(TEXT("+"))) {
+            if (!EnterNested()) {
+                return INDEX_NONE;
+            }
+
+            int32 Result = Factor();
+            Depth -= 1;
+            return Result;
+        }
+        return Primary();
+    }
+
+    int32 Primary() {
+        int32 Node = Atom();
+
+        while (!Failed()) {
+            int32 Line = Current().Line;
+
+            if (MatchOp(TEXT("."))) {
+                if (!Check(EGKToken::Name)) {
+                    return Fail(TEXT("expected an attribute name"));
+                }
+                int32 Kids[] = {Node};
+                Node = Builder.AddNode(EGKAstKind::Attribute, Intern(Advance().Text), Kids, Line);
+            }
+            else if (MatchOp(TEXT("("))) {
+                Node = Call(Node, Line);
+            }
+            else if (MatchOp(TEXT("["))) {
+                int32 Kids[] = {Node, ExpressionList()};
+                if (!ExpectOp(TEXT("]"))) {
+                    return INDEX_NONE;
+                }
+                Node = Builder.AddNode(EGKAstKind::Subscript, INDEX_NONE, Kids, Line);
+            }
+            else {
+                break;
+            }
+        }
+        return Node;
+    }
+
+    int32 Call(int32 Func, int32 Line) {
+        FGKNodeList Args;
+        FGKNodeList Keywords;
+        Args.Add(Func);
+
+        while (!Failed() && !CheckOp(TEXT(")"))) {
+            // Keyword argument
+            if (Check(EGKToken::Name) && Peek(1).Kind == EGKToken::Op && Peek(1).Text.Equals(TEXT("="))) {
+                FGKToken const& Name = Advance();
+                Advance();
+                int32 Kids[] = {Expression()};
+                Keywords.Add(Builder.AddNode(EGKAstKind::Keyword, Intern(Name.Text), Kids, Name.Line));
+            }
+            else if (Keywords.Num() > 0) {
+                return Fail(TEXT("positional argument follows keyword argument"));
+            }
+            else {
+                Args.Add(Expression());
+            }
+
+            if (!MatchOp(TEXT(","))) {
+                break;
+            }
+        }
+
+        if (Failed() || !ExpectOp(TEXT(")"))) {
+            return INDEX_NONE;
+        }
+
+        Args.Append(Keywords);
+        return Builder.AddNode(EGKAstKind::Call, INDEX_NONE, Args, Line);
+    }
+
+    int32 Atom() {
+        FGKToken const& Token = Current();
+        int32 Line = Token.Line;
+
+        switch (Token.Kind) {
+        case EGKToken::Name: {
+            Advance();
+            if (Token.Text.Equals(TEXT("None"))) {
+                return Constant(EGKAstConstant::None, INDEX_NONE, Line);
+            }
+            if (Token.Text.Equals(TEXT("True"))) {
+                return Constant(EGKAstConstant::True, INDEX_NONE, Line);
+            }
+            if (Token.Text.Equals(TEXT("False"))) {
+                return Constant(EGKAstConstant::False, INDEX_NONE, Line);
+            }
+            return Builder.AddNode(EGKAstKind::Name, Intern(Token.Text), {}, Line);
+        }
+        case EGKToken::Number: {
+            Advance();
+            bool bReal = false;
+            for (TCHAR C : Token.Text) {
+                bReal |= C == TEXT('.') || ((C == TEXT('e') || C == TEXT('E')) && !Token.Text.StartsWith(TEXT("0x")));
+            }
+            return Constant(bReal ? EGKAstConstant::Real : EGKAstConstant::Int, Intern(Token.Text), Line);
+        }
+        case EGKToken::String: {
+            return Constant(EGKAstConstant::String, Strings(), Line);
+        }
+        case EGKToken::Op: {
+            if (MatchOp(TEXT("("))) {
+                // Empty tuple
+                if (MatchOp(TEXT(")"))) {
+                    return Builder.AddNode(EGKAstKind::Tuple, INDEX_NONE, {}, Line);
+                }
+
+                int32 First = Expression();
+                if (!CheckOp(TEXT(","))) {
+                    ExpectOp(TEXT(")"));
+                    return First;
+                }
+
+                FGKNodeList Elts;
+                Elts.Add(First);
+                while (!Failed() && MatchOp(TEXT(","))) {
+                    if (CheckOp(TEXT(")"))) {
+                        break;
+                    }
+                    Elts.Add(Expression());
+                }
+                if (Failed() || !ExpectOp(TEXT(")"))) {
+                    return INDEX_NONE;
+                }
+                return Builder.AddNode(EGKAstKind::Tuple, INDEX_NONE, Elts, Line);
+            }
+
+            if (MatchOp(TEXT("["))) {
+                FGKNodeList Elts;
+                while (!Failed() && !CheckOp(TEXT("]"))) {
+                    Elts.Add(Expression());
+                    if (!MatchOp(TEXT(","))) {
+                        break;
+                    }
+                }
+                if (Failed() || !ExpectOp(TEXT("]"))) {
+                    return INDEX_NONE;
+                }
+                return Builder.AddNode(EGKAstKind::List, INDEX_NONE, Elts, Line);
+            }
+
+            if (MatchOp(TEXT("..."))) {
+                return Builder.AddNode(EGKAstKind::Name, Intern(TEXT("...")), {}, Line);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        return Fail(TEXT("expected an expression"));
+    }
+
+    int32 Constant(EGKAstConstant Type, int32 Value, int32 Line) {
+        return Builder.AddNode(EGKAstKind::Constant, Value, {}, Line, uint8(Type));
+    }
+
+    // Adjacent strings are concatenated
+    int32 Strings() {
+        FGKToken const& First = Advance();
+        int32 Escape = INDEX_NONE;
+
+        if (!Check(EGKToken::String) && (First.bRaw || !First.Text.FindChar(TEXT('\\'), Escape))) {
+            return Intern(First.Text);
+        }
+
+        FString Value;
+        Unescape(First, Value);
+        while (Check(EGKToken::String)) {
+            Unescape(Advance(), Value);
+        }
+        return Intern(Value);
+    }
+
+    static void Unescape(FGKToken const& Token, FString& Out) {
+        FStringView Text = Token.Text;
+        Out.Reserve(Out.Len() + Text.Len());
+
+        if (Token.bRaw) {
+            Out.Append(Text.GetData(), Text.Len());
+            return;
+        }
+
+        for (int32 i = 0; i < Text.Len(); i++) {
+            TCHAR C = Text[i];
+
+            if (C != TEXT('\\') || i + 1 >= Text.Len()) {
+                Out.AppendChar(C);
+                continue;
+            }
+
+            i += 1;
+            switch (Text[i]) {
+            case TEXT('n'):  Out.AppendChar(TEXT('\n')); break;
+            case TEXT('t'):  Out.AppendChar(TEXT('\t')); break;
+            case TEXT('r'):  Out.AppendChar(TEXT('\r')); break;
+            case TEXT('0'):  Out.AppendChar(TEXT('\0')); break;
+            case TEXT('\\'): Out.AppendChar(TEXT('\\')); break;
+            case TEXT('\''): Out.AppendChar(TEXT('\'')); break;
+            case TEXT('"'):  Out.AppendChar(TEXT('"'));  break;
+            case TEXT('\n'): break;
+            default:
+                // Unknown escapes are kept as is
+                Out.AppendChar(TEXT('\\'));
+                Out.AppendChar(Text[i]);
+            }
+        }
+    }
+
+    TArray<FGKToken> const& Tokens;
+    FGKScriptAstBuilder     Builder;
+    FGKScriptParseError&    Error;
+    int32                   Pos = 0;
+    int32                   Depth = 0;
+    bool                    bFailed = false;
+};
+
+} // namespace
+
+
+bool FGKScriptParser::Parse(FStringView Source, FGKScriptAst& Ast, FGKScriptParseError& Error) {
+    GKSCRIPT_SCOPE(STAT_GKScript_Parse);
+    TArray<FGKToken> Tokens;
+
+    FGKLexer Lexer(Source, Error);
+    if (!Lexer.Tokenize(Tokens)) {
+        Ast.Reset();
+        return false;
+    }
+
+    FGKParser Parser(Tokens, Ast, Error);
+    if (!Parser.Module()) {
+        Ast.Reset();
+        return false;
+    }
+    return true;
+}
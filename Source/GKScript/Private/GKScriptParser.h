@@ -0,0 +1,38 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Gamekit
+#include "GKScriptAst.h"
+
+// Unreal Engine
+#include "CoreMinimal.h"
+
+
+struct FGKScriptParseError {
+    int32   Line = 0;
+    int32   Column = 0;
+    FString Message;
+
+    FString ToString() const {
+        return FString::Printf(TEXT("%d:%d: %s"), Line, Column, *Message);
+    }
+};
+
+
+/*! Native parser for the .us dialect
+ *
+ * Hand written lexer and recursive descent parser for the subset of python
+ * the transform emits: imports, classes, functions with annotated arguments,
+ * assignments, calls with keyword arguments, if/elif/else, match/case, return,
+ * pass and docstrings.
+ *
+ * It does not need the python interpreter nor the GIL and holds no global state,
+ * any number of scripts can be parsed at once from worker threads.
+ */
+struct FGKScriptParser {
+    // Bumped every time the produced AST changes
+    static constexpr int32 Version = 1;
+
+    static bool Parse(FStringView Source, FGKScriptAst& Ast, FGKScriptParseError& Error);
+};
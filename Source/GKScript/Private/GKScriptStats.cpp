@@ -0,0 +1,43 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKScriptStats.h"
+
+// Gamekit
+#include "GKEdGraphVisitor.h"
+
+
+UE_TRACE_CHANNEL_DEFINE(GKScriptChannel);
+
+DEFINE_STAT(STAT_GKScript_Load);
+DEFINE_STAT(STAT_GKScript_ReflectionIndex);
+
+DEFINE_STAT(STAT_GKScript_Generate);
+DEFINE_STAT(STAT_GKScript_EmitGraph);
+DEFINE_STAT(STAT_GKScript_FindRoots);
+DEFINE_STAT(STAT_GKScript_Numbering);
+DEFINE_STAT(STAT_GKScript_ResolvePin);
+DEFINE_STAT(STAT_GKScript_Naming);
+DEFINE_STAT(STAT_GKScript_Decompile);
+DEFINE_STAT(STAT_GKScript_NodesEmitted);
+
+DEFINE_STAT(STAT_GKScript_Write);
+DEFINE_STAT(STAT_GKScript_FunctionCache);
+DEFINE_STAT(STAT_GKScript_AstCache);
+DEFINE_STAT(STAT_GKScript_FunctionCacheHits);
+DEFINE_STAT(STAT_GKScript_FunctionCacheMisses);
+
+DEFINE_STAT(STAT_GKScript_Parse);
+DEFINE_STAT(STAT_GKScript_BatchParse);
+DEFINE_STAT(STAT_GKScript_BuildClass);
+DEFINE_STAT(STAT_GKScript_BuildFunction);
+DEFINE_STAT(STAT_GKScript_BuildBytecode);
+DEFINE_STAT(STAT_GKScript_Compile);
+DEFINE_STAT(STAT_GKScript_Save);
+DEFINE_STAT(STAT_GKScript_PythonParse);
+
+DEFINE_STAT(STAT_GKScript_GenerateOnSave);
+DEFINE_STAT(STAT_GKScript_GenerateOnSaveQueue);
+DEFINE_STAT(STAT_GKScript_GeneratedOnSave);
+
+UK2NODES(GKSCRIPT_DEFINE_NODE_STAT)
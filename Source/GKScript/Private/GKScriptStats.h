@@ -0,0 +1,78 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Gamekit
+#include "GKScript.h"
+
+// Unreal Engine
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+
+/*! Stats and trace scopes of the plugin
+ *
+ * Every scope is recorded twice: as a cycle stat (``stat GKScript``, ``stat GKScriptNodes``,
+ * ``stat Python``) and as a CPU event on the ``GKScript`` trace channel, enabled in Unreal Insights
+ * with ``-trace=cpu,GKScript``.
+ *
+ * Emission is also recorded per node kind, see UK2NODES in GKEdGraphVisitor.h.
+ * Node scopes are inclusive: a node is timed with the nodes it reaches through its pins,
+ * which are timed again under their own kind, so the inclusive times of ``stat GKScriptNodes``
+ * add up to more than Emit Graph. Compare kinds with the exclusive columns, or the exclusive
+ * time in Insights.
+ */
+UE_TRACE_CHANNEL_EXTERN(GKScriptChannel);
+
+DECLARE_STATS_GROUP(TEXT("GKScript Nodes"), STATGROUP_GKScriptNodes, STATCAT_Advanced);
+DECLARE_STATS_GROUP(TEXT("Python"), STATGROUP_Python, STATCAT_Advanced);
+
+// Cycle stat and trace event named after the stat
+#define GKSCRIPT_SCOPE(Stat)\
+    SCOPE_CYCLE_COUNTER(Stat);\
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, GKScriptChannel)
+
+// Loading
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Load Blueprint"), STAT_GKScript_Load, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Reflection Index"), STAT_GKScript_ReflectionIndex, STATGROUP_GKScript, );
+
+// Blueprint to code
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Generate"), STAT_GKScript_Generate, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Emit Graph"), STAT_GKScript_EmitGraph, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Find Roots"), STAT_GKScript_FindRoots, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Number Graph"), STAT_GKScript_Numbering, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Resolve Pin"), STAT_GKScript_ResolvePin, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Naming"), STAT_GKScript_Naming, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decompile Bytecode"), STAT_GKScript_Decompile, STATGROUP_GKScript, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Nodes Emitted"), STAT_GKScript_NodesEmitted, STATGROUP_GKScript, );
+
+// I/O
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Write Code"), STAT_GKScript_Write, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Function Cache"), STAT_GKScript_FunctionCache, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AST Cache"), STAT_GKScript_AstCache, STATGROUP_GKScript, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Function Cache Hits"), STAT_GKScript_FunctionCacheHits, STATGROUP_GKScript, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Function Cache Misses"), STAT_GKScript_FunctionCacheMisses, STATGROUP_GKScript, );
+
+// Code to Blueprint
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Parse"), STAT_GKScript_Parse, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batch Parse"), STAT_GKScript_BatchParse, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Class"), STAT_GKScript_BuildClass, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Function Graph"), STAT_GKScript_BuildFunction, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Bytecode"), STAT_GKScript_BuildBytecode, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Compile Blueprint"), STAT_GKScript_Compile, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Save Blueprint"), STAT_GKScript_Save, STATGROUP_GKScript, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CPython Parse"), STAT_GKScript_PythonParse, STATGROUP_Python, );
+
+// Editor
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Generate On Save"), STAT_GKScript_GenerateOnSave, STATGROUP_GKScript, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Generate On Save Queue"), STAT_GKScript_GenerateOnSaveQueue, STATGROUP_GKScript, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Generated On Save"), STAT_GKScript_GeneratedOnSave, STATGROUP_GKScript, );
+
+// Per node kind, used with UK2NODES
+#define GKSCRIPT_DECLARE_NODE_STAT(Name)\
+    DECLARE_CYCLE_STAT_EXTERN(TEXT(#Name), STAT_GKScript_Node_##Name, STATGROUP_GKScriptNodes, );
+
+#define GKSCRIPT_DEFINE_NODE_STAT(Name)\
+    DEFINE_STAT(STAT_GKScript_Node_##Name);
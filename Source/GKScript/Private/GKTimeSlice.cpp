@@ -0,0 +1,73 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+// Include
+#include "GKTimeSlice.h"
+
+// Gamekit
+#include "GKScript.h"
+
+// Unreal Engine
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+
+namespace {
+
+TAutoConsoleVariable<float> CVarGKScriptTimeSliceMs(
+    TEXT("GKScript.TimeSliceMs"),
+    4.f,
+    TEXT("Game thread budget, in milliseconds per frame, of interactive code generation (preview, generation on save)"),
+    ECVF_Default
+);
+
+} // namespace
+
+
+double FGKTimeSlicedJob::GetBudget() {
+    return FMath::Max(CVarGKScriptTimeSliceMs.GetValueOnGameThread(), 0.1f) / 1000.0;
+}
+
+FGKTimeSlicedJob::FGKTimeSlicedJob(FStep Step, FDone Done):
+    Step(MoveTemp(Step)), Done(MoveTemp(Done))
+{}
+
+FGKTimeSlicedJob::~FGKTimeSlicedJob() {
+    FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+}
+
+TSharedRef<FGKTimeSlicedJob> FGKTimeSlicedJob::Start(FStep Step, FDone Done) {
+    TSharedRef<FGKTimeSlicedJob> Job = MakeShareable(new FGKTimeSlicedJob(MoveTemp(Step), MoveTemp(Done)));
+
+    // Weak, the job stops if its owner lets it go
+    Job->TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateSP(Job, &FGKTimeSlicedJob::Tick)
+    );
+    return Job;
+}
+
+void FGKTimeSlicedJob::Cancel() {
+    if (!bDone) {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+        Finish(true);
+    }
+}
+
+bool FGKTimeSlicedJob::Tick(float DeltaTime) {
+    double EndTime = FPlatformTime::Seconds() + GetBudget();
+
+    if (!Step(EndTime)) {
+        return true;
+    }
+
+    Finish(false);
+    return false;
+}
+
+void FGKTimeSlicedJob::Finish(bool bCancelled) {
+    bDone = true;
+    TickerHandle.Reset();
+
+    if (Done) {
+        Done(bCancelled);
+    }
+}
@@ -0,0 +1,55 @@
+// Copyright 2023 Mischievous Game, Inc. All Rights Reserved.
+
+#pragma once
+
+// Unreal Engine
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+
+/*! Run a resumable job on the game thread, one slice per frame
+ *
+ * Step is called once per tick with a deadline and returns true when the job is done,
+ * each slice is given ``GKScript.TimeSliceMs`` milliseconds.
+ * The job stops when it is done, cancelled or released by its owner.
+ *
+ * .. code-block:: cpp
+ *
+ *    TSharedPtr<FGKEdGraphTransform> Transform = ...;
+ *    Job = FGKTimeSlicedJob::Start([Transform](double EndTime) {
+ *        return Transform->GenerateSlice(EndTime);
+ *    });
+ *
+ * .. note::
+ *
+ *    A slice can overrun its deadline by one unit of work, a root for FGKEdGraphVisitor
+ */
+class FGKTimeSlicedJob: public TSharedFromThis<FGKTimeSlicedJob>
+{
+    public:
+    using FStep = TFunction<bool(double EndTime)>;
+    using FDone = TFunction<void(bool bCancelled)>;
+
+    static TSharedRef<FGKTimeSlicedJob> Start(FStep Step, FDone Done = nullptr);
+
+    ~FGKTimeSlicedJob();
+
+    void Cancel();
+
+    bool IsDone() const { return bDone; }
+
+    // Budget of a slice in seconds
+    static double GetBudget();
+
+    private:
+    FGKTimeSlicedJob(FStep Step, FDone Done);
+
+    bool Tick(float DeltaTime);
+
+    void Finish(bool bCancelled);
+
+    FStep                       Step;
+    FDone                       Done;
+    FTSTicker::FDelegateHandle  TickerHandle;
+    bool                        bDone = false;
+};